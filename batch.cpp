@@ -0,0 +1,226 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <sys/stat.h>
+#include <errno.h>
+#include "util.h"
+#include "parser.h"
+#include "compiler.h"
+#include "rewriter.h"
+#include "preprocess.h"
+#include "funcs.h"
+#include "diskcache.h"
+#include "batch.h"
+
+std::vector<std::string> readManifest(std::string manifest) {
+    if (!exists(manifest)) throw("Manifest does not exist: " + manifest);
+    std::string root;
+    int lastSlashPos = manifest.rfind("/");
+    if (lastSlashPos >= 0) root = manifest.substr(0, lastSlashPos) + "/";
+    std::vector<std::string> lines = splitLines(get_file_contents(manifest));
+    std::vector<std::string> o;
+    for (unsigned i = 0; i < lines.size(); i++) {
+        std::string l = lines[i];
+        while (l.size() && (l[l.size() - 1] == ' ' || l[l.size() - 1] == '\t'
+                            || l[l.size() - 1] == '\r'))
+            l = l.substr(0, l.size() - 1);
+        while (l.size() && (l[0] == ' ' || l[0] == '\t')) l = l.substr(1);
+        if (!l.size() || l[0] == '#') continue;
+        o.push_back(l[0] == '/' ? l : root + l);
+    }
+    return o;
+}
+
+// Output path for a source file, without extension: the source path
+// with its .se dropped, made relative (leading / and . dropped, .. turned
+// into __) and put under the output directory
+std::string outputBase(const std::string &outDir, const std::string &file) {
+    std::string o = outDir;
+    size_t pos = 0;
+    while (pos < file.size()) {
+        size_t end = file.find('/', pos);
+        if (end == std::string::npos) end = file.size();
+        std::string part = file.substr(pos, end - pos);
+        pos = end + 1;
+        if (part == "" || part == ".") continue;
+        o += "/" + (part == ".." ? "__" : part);
+    }
+    if (o.size() > 3 && o.substr(o.size() - 3) == ".se")
+        o = o.substr(0, o.size() - 3);
+    return o;
+}
+
+// Creates the directories leading up to a path
+void mkParentDirs(const std::string &path) {
+    for (unsigned i = 1; i < path.size(); i++) {
+        if (path[i] != '/') continue;
+        std::string dir = path.substr(0, i);
+        if (mkdir(dir.c_str(), 0777) && errno != EEXIST)
+            throw("Cannot create directory " + dir);
+    }
+}
+
+void writeOutput(const std::string &path, const std::string &contents) {
+    std::ofstream out(path.c_str(), std::ios::out | std::ios::binary);
+    out << contents;
+    out.close();
+    if (!out) throw("Cannot write " + path);
+}
+
+// Drops the lines after from that are already among those before it
+void dropRepeatedLines(std::string &diagnostics, size_t from) {
+    std::vector<std::string> seen = splitLines(diagnostics.substr(0, from));
+    std::vector<std::string> added = splitLines(diagnostics.substr(from));
+    diagnostics = diagnostics.substr(0, from);
+    for (unsigned i = 0; i < added.size(); i++) {
+        if (added[i].size() && std::find(seen.begin(), seen.end(),
+                                         added[i]) == seen.end())
+            diagnostics += added[i] + "\n";
+    }
+}
+
+// Compiles one file and writes its outputs. Errors and warnings are
+// collected into the result rather than printed, as several files are
+// being compiled at once
+batchResult compileBatchFile(const std::string &file,
+                             const batchOptions &opts) {
+    batchResult r;
+    r.file = file;
+    diagnosticsSink = &r.diagnostics;
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    try {
+        // parseSerpent would take a missing file for serpent code
+        if (!exists(file)) throw("File does not exist: " + file);
+        std::string base = outputBase(opts.outDir, file);
+        mkParentDirs(base);
+        if (diskCacheEnabled() && !opts.lll) {
+            // Nothing to compile if the cache has it all
+            compiledArtifacts a = compileArtifacts(file);
+            reportWarnings(a.parseWarnings + a.codeWarnings);
+            writeOutput(base + ".hex", binToHex(a.code) + "\n");
+            if (opts.signature && a.hasSignature) {
+                size_t mark = r.diagnostics.size();
+                reportWarnings(a.signatureWarnings);
+                dropRepeatedLines(r.diagnostics, mark);
+                writeOutput(base + ".sig", a.signature + "\n");
+            }
+            // Making it failed; fail the same way
+            else if (opts.signature)
+                mkFullExtern(parseSerpent(file));
+        }
+        else {
+            // The same steps as compile(), so the output is identical,
+            // and the signature is made from the same parse
+            compilationScope scope;
+            Node ast = parseSerpent(file);
+            Node lll = rewrite(ast);
+            writeOutput(base + ".hex", binToHex(compileLLL(lll)) + "\n");
+            if (opts.lll)
+                writeOutput(base + ".lll", printAST(lll) + "\n");
+            if (opts.signature) {
+                // Preprocessing warns again about what it warned about
+                // while compiling
+                size_t mark = r.diagnostics.size();
+                std::string sig = mkFullExtern(ast);
+                dropRepeatedLines(r.diagnostics, mark);
+                writeOutput(base + ".sig", sig + "\n");
+            }
+        }
+        r.ok = true;
+    }
+    catch (std::string &e) {
+        // err() has reported it already
+        if (r.diagnostics.find(e) == std::string::npos)
+            r.diagnostics += e + "\n";
+    }
+    catch (...) {
+        r.diagnostics += "Compilation failed\n";
+    }
+    r.seconds = secondsSince(start);
+    diagnosticsSink = 0;
+    return r;
+}
+
+std::vector<batchResult> compileBatch(const batchOptions &opts) {
+    std::vector<batchResult> results(opts.files.size());
+    unsigned jobs = opts.jobs > 0 ? opts.jobs
+                                  : std::thread::hardware_concurrency();
+    if (jobs < 1) jobs = 1;
+    if (jobs > opts.files.size()) jobs = opts.files.size();
+    std::atomic<unsigned> next(0);
+    std::vector<std::thread> pool;
+    for (unsigned t = 0; t < jobs; t++) {
+        pool.push_back(std::thread([&]() {
+            // Files are already compiled in parallel, so each one parses
+            // its includes serially
+            parseThreadsScope serial(jobs > 1 ? 1 : 0);
+            unsigned i;
+            while ((i = next++) < opts.files.size())
+                results[i] = compileBatchFile(opts.files[i], opts);
+        }));
+    }
+    for (unsigned t = 0; t < pool.size(); t++) pool[t].join();
+    return results;
+}
+
+int batchUsage() {
+    std::cerr << "Usage: serpent batch [-j threads] [-m manifest] [--lll] "
+                 "[--signature] -o outdir [file.se ...]\n";
+    return 1;
+}
+
+int batchMain(int argc, char **argv) {
+    batchOptions opts;
+    for (int i = 0; i < argc; i++) {
+        std::string a = argv[i];
+        if ((a == "-j" || a == "-m" || a == "-o") && i + 1 >= argc)
+            return batchUsage();
+        if (a == "-j") opts.jobs = decimalToUnsigned(argv[++i]);
+        else if (a == "-o") opts.outDir = argv[++i];
+        else if (a == "-m") {
+            std::vector<std::string> m;
+            try {
+                m = readManifest(argv[++i]);
+            }
+            catch (std::string &e) {
+                std::cerr << e << "\n";
+                return 1;
+            }
+            opts.files.insert(opts.files.end(), m.begin(), m.end());
+        }
+        else if (a == "--lll") opts.lll = true;
+        else if (a == "--signature") opts.signature = true;
+        else if (a.size() && a[0] == '-') return batchUsage();
+        else opts.files.push_back(a);
+    }
+    if (!opts.outDir.size() || !opts.files.size()) return batchUsage();
+    while (opts.outDir.size() > 1 && opts.outDir[opts.outDir.size() - 1] == '/')
+        opts.outDir = opts.outDir.substr(0, opts.outDir.size() - 1);
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    std::vector<batchResult> results = compileBatch(opts);
+    double wall = secondsSince(start), total = 0;
+    int failed = 0;
+    for (unsigned i = 0; i < results.size(); i++) {
+        const batchResult &r = results[i];
+        printf("%-6s %9.3fs  %s\n", r.ok ? "ok" : "FAILED", r.seconds,
+               r.file.c_str());
+        std::vector<std::string> lines = splitLines(r.diagnostics);
+        for (unsigned j = 0; j < lines.size(); j++) {
+            if (lines[j].size()) printf("           %s\n", lines[j].c_str());
+        }
+        total += r.seconds;
+        failed += !r.ok;
+    }
+    printf("%d files, %d failed, %.3fs compiling, %.3fs wall\n",
+           (int)results.size(), failed, total, wall);
+    return failed ? 1 : 0;
+}
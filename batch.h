@@ -0,0 +1,57 @@
+#ifndef ETHSERP_BATCH
+#define ETHSERP_BATCH
+
+#include <stdio.h>
+#include <iostream>
+#include <vector>
+#include <string>
+
+// Compiles many contracts in one process, on a pool of worker threads,
+// so that process startup and the one-off table setup are paid once
+class batchOptions {
+    public:
+        batchOptions() {
+            jobs = 0;
+            lll = false;
+            signature = false;
+        }
+        // Where outputs go; a.se/b.se becomes outDir/a/b.hex (and .lll,
+        // .sig)
+        std::string outDir;
+        // Worker threads, 0 for one per core
+        int jobs;
+        // Also write the LLL and the full signature of each contract
+        bool lll;
+        bool signature;
+        std::vector<std::string> files;
+};
+
+class batchResult {
+    public:
+        batchResult() {
+            ok = false;
+            seconds = 0;
+        }
+        std::string file;
+        bool ok;
+        double seconds;
+        // Errors and warnings, one per line
+        std::string diagnostics;
+};
+
+// Reads a manifest: one source file per line, blank lines and lines
+// starting with # are skipped. Relative paths are taken relative to the
+// directory of the manifest. Throws a string if the manifest does not
+// exist
+std::vector<std::string> readManifest(std::string manifest);
+
+// Compiles every file and writes its outputs, returning the results in
+// the same order as opts.files
+std::vector<batchResult> compileBatch(const batchOptions &opts);
+
+// Entry point for `serpent batch [-j threads] [-m manifest] [--lll]
+// [--signature] -o outdir [file.se ...]`; prints per-file timings and
+// returns the process exit status
+int batchMain(int argc, char **argv);
+
+#endif
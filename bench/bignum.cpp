@@ -0,0 +1,159 @@
+// Microbenchmark comparing the limb-based decimal* kernels in bignum.cpp
+// against the original digit-string implementations (reproduced below)
+//
+// Build and run with `make bench_bignum && ./bench/bignum`
+#include <stdio.h>
+#include <iostream>
+#include <vector>
+#include <string>
+#include <sys/time.h>
+#include "../bignum.h"
+
+const std::string nums2 = "0123456789";
+
+std::string oldAdd(std::string a, std::string b) {
+    std::string o = a;
+    while (b.length() < a.length()) b = "0" + b;
+    while (o.length() < b.length()) o = "0" + o;
+    bool carry = false;
+    for (int i = o.length() - 1; i >= 0; i--) {
+        o[i] = o[i] + b[i] - '0';
+        if (carry) o[i]++;
+        if (o[i] > '9') {
+            o[i] -= 10;
+            carry = true;
+        }
+        else carry = false;
+    }
+    if (carry) o = "1" + o;
+    return o;
+}
+
+std::string oldDigitMul(std::string a, int dig) {
+    if (dig == 0) return "0";
+    else return oldAdd(a, oldDigitMul(a, dig - 1));
+}
+
+std::string oldMul(std::string a, std::string b) {
+    std::string o = "0";
+    for (unsigned i = 0; i < b.length(); i++) {
+        std::string n = oldDigitMul(a, b[i] - '0');
+        if (n != "0") {
+            for (unsigned j = i + 1; j < b.length(); j++) n += "0";
+        }
+        o = oldAdd(o, n);
+    }
+    return o;
+}
+
+bool oldGt(std::string a, std::string b, bool eqAllowed=false) {
+    if (a == b) return eqAllowed;
+    return (a.length() > b.length()) || (a.length() >= b.length() && a > b);
+}
+
+std::string oldSub(std::string a, std::string b) {
+    if (b == "0") return a;
+    if (b == a) return "0";
+    while (b.length() < a.length()) b = "0" + b;
+    std::string c = b;
+    for (unsigned i = 0; i < c.length(); i++) c[i] = '0' + ('9' - c[i]);
+    std::string o = oldAdd(oldAdd(a, c).substr(1), "1");
+    while (o.size() > 1 && o[0] == '0') o = o.substr(1);
+    return o;
+}
+
+std::string oldDiv(std::string a, std::string b) {
+    std::string c = b;
+    if (oldGt(c, a)) return "0";
+    int zeroes = -1;
+    while (oldGt(a, c, true)) {
+        zeroes += 1;
+        c = c + "0";
+    }
+    c = c.substr(0, c.size() - 1);
+    std::string quot = "0";
+    while (oldGt(a, c, true)) {
+        a = oldSub(a, c);
+        quot = oldAdd(quot, "1");
+    }
+    for (int i = 0; i < zeroes; i++) quot += "0";
+    return oldAdd(quot, oldDiv(a, b));
+}
+
+std::string oldMod(std::string a, std::string b) {
+    return oldSub(a, oldMul(oldDiv(a, b), b));
+}
+
+std::string oldModExp(std::string b, std::string e, std::string m) {
+    if (e == "0") return "1";
+    else if (e == "1") return b;
+    else if (oldMod(e, "2") == "0") {
+        std::string o = oldModExp(b, oldDiv(e, "2"), m);
+        return oldMod(oldMul(o, o), m);
+    }
+    else {
+        std::string o = oldModExp(b, oldDiv(e, "2"), m);
+        return oldMod(oldMul(oldMul(o, o), b), m);
+    }
+}
+
+std::string oldExp(std::string b, std::string e) {
+    if (e == "0") return "1";
+    else if (e == "1") return b;
+    else if (oldMod(e, "2") == "0") {
+        std::string o = oldExp(b, oldDiv(e, "2"));
+        return oldMul(o, o);
+    }
+    else {
+        std::string o = oldExp(b, oldDiv(e, "2"));
+        return oldMul(oldMul(o, o), b);
+    }
+}
+
+double now() {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+// Runs f repeatedly for about a tenth of a second, returns microseconds
+// per call
+template <typename F>
+double timeit(F f) {
+    unsigned iters = 0;
+    double start = now(), end;
+    do {
+        f();
+        iters++;
+        end = now();
+    } while (end - start < 0.1);
+    return (end - start) * 1e6 / iters;
+}
+
+std::string sink;
+
+#define CASE(name, oldExpr, newExpr) { \
+        if (oldExpr != newExpr) { \
+            std::cerr << "Mismatch in " << name << "\n"; \
+            return 1; \
+        } \
+        double o = timeit([&]() { sink = oldExpr; }); \
+        double n = timeit([&]() { sink = newExpr; }); \
+        printf("%-28s %14.2f %14.2f %10.1fx\n", name, o, n, o / n); \
+    }
+
+int main() {
+    std::string a = tt256m1, b = tt255, c = "340282366920938463463374607431768211507";
+    std::string big = decimalExp("7", "2000");
+    printf("%-28s %14s %14s %11s\n", "operation", "old (us)", "new (us)", "speedup");
+    CASE("add 256-bit", oldAdd(a, b), decimalAdd(a, b));
+    CASE("mul 256-bit", oldMul(a, b), decimalMul(a, b));
+    CASE("div 512/128-bit", oldDiv(oldMul(a, b), c), decimalDiv(decimalMul(a, b), c));
+    CASE("mod 256-bit by 2^256", oldMod(oldMul(a, b), tt256), decimalMod(decimalMul(a, b), tt256));
+    CASE("modexp 2**255 % 2^256", oldModExp("2", "255", tt256), decimalModExp("2", "255", tt256));
+    CASE("modexp 3**(2^256-1) % 2^256", oldModExp("3", a, tt256), decimalModExp("3", a, tt256));
+    CASE("exp 256**31", oldExp("256", "31"), decimalExp("256", "31"));
+    CASE("exp 7**2000", oldExp("7", "2000"), decimalExp("7", "2000"));
+    CASE("mul 1690-digit", oldMul(big, big), decimalMul(big, big));
+    return 0;
+}
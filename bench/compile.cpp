@@ -0,0 +1,135 @@
+// Compile throughput over contracts on disk and the generated stress
+// contracts of stress.h. Every contract is compiled a few times and the
+// fastest run is reported, as JSON so that results can be kept and
+// compared over time: the total time, the size of the code and, for
+// each phase of the compilation (see passTimings in util.h), its time,
+// the sizes of its input and output, its peak heap and the number of
+// allocations it made. A contract that fails to compile is reported with
+// its error
+//
+// Build and run with `make bench`, or
+// `make bench_compile && ./bench/compile [-r runs] [--no-stress] file.se ...`
+#include <stdio.h>
+#include <iostream>
+#include <vector>
+#include <string>
+#include "../util.h"
+#include "../bignum.h"
+#include "../funcs.h"
+#include "stress.h"
+
+class benchResult {
+    public:
+        std::string name;
+        std::string error;
+        double seconds;
+        unsigned bytes;
+        passTimings timings;
+};
+
+std::string jsonString(const std::string &s) {
+    std::string o = "\"";
+    for (unsigned i = 0; i < s.size(); i++) {
+        unsigned char c = s[i];
+        if (c == '"' || c == '\\') o += std::string("\\") + (char)c;
+        else if (c < 32) {
+            char buf[8];
+            sprintf(buf, "\\u%04x", c);
+            o += buf;
+        }
+        else o += (char)c;
+    }
+    return o + "\"";
+}
+
+benchResult run(const std::string &name, const std::string &input,
+                unsigned runs) {
+    benchResult best;
+    best.name = name;
+    best.seconds = -1;
+    best.bytes = 0;
+    for (unsigned i = 0; i < runs; i++) {
+        benchResult r;
+        r.name = name;
+        r.bytes = 0;
+        std::string diagnostics;
+        std::chrono::steady_clock::time_point start =
+            std::chrono::steady_clock::now();
+        {
+            passTimingScope timing(&r.timings);
+            diagnosticsSink = &diagnostics;
+            try {
+                compilationScope scope;
+                r.bytes = compileLLL(compileToLLL(input)).size();
+            }
+            catch (std::string &e) {
+                r.error = e;
+            }
+            catch (...) {
+                r.error = "Compilation failed: " + diagnostics;
+            }
+            diagnosticsSink = 0;
+        }
+        r.seconds = secondsSince(start);
+        if (r.error.size()) return r;
+        if (best.seconds < 0 || r.seconds < best.seconds) best = r;
+    }
+    return best;
+}
+
+std::string toJson(const benchResult &r) {
+    char buf[256];
+    std::string o = "    {\"name\": " + jsonString(r.name);
+    if (r.error.size()) return o + ", \"error\": " + jsonString(r.error) + "}";
+    sprintf(buf, ", \"seconds\": %.6f, \"bytes\": %u, \"phases\": [",
+            r.seconds, r.bytes);
+    o += buf;
+    const std::vector<phaseRecord> &p = r.timings.phases;
+    for (unsigned i = 0; i < p.size(); i++) {
+        sprintf(buf, "%s\n        {\"name\": \"%s\", \"depth\": %d, "
+                "\"seconds\": %.6f, \"nodesIn\": %lld, \"nodesOut\": %lld, "
+                "\"peakBytes\": %lld, \"allocations\": %lld}",
+                i ? "," : "", p[i].name.c_str(), p[i].depth, p[i].seconds,
+                p[i].nodesIn, p[i].nodesOut, p[i].peakBytes,
+                p[i].allocations);
+        o += buf;
+    }
+    return o + "]}";
+}
+
+int main(int argc, char **argv) {
+    unsigned runs = 3;
+    bool stress = true;
+    std::vector<std::string> files;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-r" && i + 1 < argc) runs = decimalToUnsigned(argv[++i]);
+        else if (arg == "--no-stress") stress = false;
+        else files.push_back(arg);
+    }
+    if (!runs) runs = 1;
+    std::vector<benchResult> results;
+    for (unsigned i = 0; i < files.size(); i++) {
+        if (!exists(files[i])) {
+            std::cerr << "File does not exist: " << files[i] << "\n";
+            return 1;
+        }
+        results.push_back(run(files[i], files[i], runs));
+    }
+    if (stress) {
+        std::vector<stressContract> s = stressContracts();
+        for (unsigned i = 0; i < s.size(); i++)
+            results.push_back(run(s[i].name, s[i].code, runs));
+    }
+    if (!heapCounted)
+        std::cerr << "The heap is not counted, as memcount.cpp is not linked"
+                     " in: peakBytes and allocations are -1\n";
+    printf("{\"runs\": %u, \"heapCounted\": %s, \"contracts\": [\n", runs,
+           heapCounted ? "true" : "false");
+    for (unsigned i = 0; i < results.size(); i++) {
+        printf("%s%s", toJson(results[i]).c_str(),
+               i + 1 < results.size() ? ",\n" : "\n");
+    }
+    printf("]}\n");
+    return 0;
+}
@@ -0,0 +1,269 @@
+// Expression parser throughput, comparing the single-pass parser in
+// parser.cpp against the original shunting-yard + treefy pair
+// (reproduced below). Every line of the input files is tokenized up
+// front the way parseLines does it, both parsers are run over the token
+// lines and checked to give identical trees, then each is timed. Lines
+// that inset or import other files are left out, as parsing those would
+// mostly measure the file being pulled in
+//
+// Build and run with
+// `make bench_parse && ./bench/parse examples/*.se examples/*/*.se`
+#include <stdio.h>
+#include <iostream>
+#include <vector>
+#include <string>
+#include <sys/time.h>
+#include "../util.h"
+#include "../tokenize.h"
+#include "../parser.h"
+
+int toktype(const Node &tok);
+int precedence(const Node &tok);
+
+// Converts to reverse polish notation
+std::vector<Node> oldShuntingYard(std::vector<Node> tokens) {
+    std::vector<Node> iq;
+    for (int i = tokens.size() - 1; i >= 0; i--) {
+        iq.push_back(tokens[i]);
+    }
+    std::vector<Node> oq;
+    std::vector<Node> stack;
+    Node prev, tok;
+    int prevtyp = 0, toktyp = 0;
+    
+    while (iq.size()) {
+        prev = tok;
+        prevtyp = toktyp;
+        tok = iq.back();
+        toktyp = toktype(tok);
+        iq.pop_back();
+        // Alphanumerics go straight to output queue
+        if (toktyp == ALPHANUM) {
+            oq.push_back(tok);
+        }
+        // Left parens go on stack and output queue
+        else if (toktyp == LPAREN) {
+            while (stack.size() && toktype(stack.back()) == TOKEN_SPLITTER) {
+                oq.push_back(stack.back());
+                stack.pop_back();
+            }
+            if (prevtyp != ALPHANUM && prevtyp != RPAREN) {
+                oq.push_back(token("id", tok.metadata));
+            }
+            stack.push_back(tok);
+            oq.push_back(tok);
+        }
+        // If rparen, keep moving from stack to output queue until lparen
+        else if (toktyp == RPAREN) {
+            while (stack.size() && toktype(stack.back()) != LPAREN) {
+                oq.push_back(stack.back());
+                stack.pop_back();
+            }
+            if (stack.size()) {
+                stack.pop_back();
+            }
+            oq.push_back(tok);
+        }
+        else if (toktyp == UNARY_OP) {
+            stack.push_back(tok);
+        }
+        // If token splitter, just push it to the stack 
+        else if (toktyp == TOKEN_SPLITTER) {
+            while (stack.size() && toktype(stack.back()) == TOKEN_SPLITTER) {
+                oq.push_back(stack.back());
+                stack.pop_back();
+            }
+            stack.push_back(tok);
+        }
+        // If binary op, keep popping from stack while higher bedmas precedence
+        else if (toktyp == BINARY_OP) {
+            if (tok.val == "-" && prevtyp != ALPHANUM && prevtyp != RPAREN) {
+                stack.push_back(tok);
+                oq.push_back(token("0", tok.metadata));
+            }
+            else {
+                int prec = precedence(tok);
+                while (stack.size() 
+                      && (toktype(stack.back()) == BINARY_OP 
+                          || toktype(stack.back()) == UNARY_OP
+                          || toktype(stack.back()) == TOKEN_SPLITTER)
+                      && precedence(stack.back()) <= prec) {
+                    oq.push_back(stack.back());
+                    stack.pop_back();
+                }
+                stack.push_back(tok);
+            }
+        }
+        // Comma means finish evaluating the argument
+        else if (toktyp == COMMA) {
+            while (stack.size() && toktype(stack.back()) != LPAREN) {
+                oq.push_back(stack.back());
+                stack.pop_back();
+            }
+        }
+    }
+    while (stack.size()) {
+        oq.push_back(stack.back());
+        stack.pop_back();
+    }
+    return oq;
+}
+
+// Converts reverse polish notation into tree
+Node oldTreefy(std::vector<Node> stream) {
+    std::vector<Node> iq;
+    for (int i = stream.size() -1; i >= 0; i--) {
+        iq.push_back(stream[i]);
+    }
+    std::vector<Node> oq;
+    while (iq.size()) {
+        Node tok = iq.back();
+        iq.pop_back();
+        int typ = toktype(tok);
+        // If unary, take node off end of oq and wrap it with the operator
+        // If binary, do the same with two nodes
+        if (typ == UNARY_OP || typ == BINARY_OP || typ == TOKEN_SPLITTER) {
+            std::vector<Node> args;
+            int rounds = (typ == UNARY_OP) ? 1 : 2;
+            for (int i = 0; i < rounds; i++) {
+                if (oq.size() == 0) {
+                    err("Line malformed, not enough args for "+tok.val,
+                        tok.metadata);
+                }
+                args.push_back(oq.back());
+                oq.pop_back();
+            }
+            std::vector<Node> args2;
+            while (args.size()) {
+                args2.push_back(args.back());
+                args.pop_back();
+            }
+            oq.push_back(astnode(tok.val, args2, tok.metadata));
+        }
+        // If rparen, keep grabbing until we get to an lparen
+        else if (typ == RPAREN) {
+            std::vector<Node> args;
+            while (1) {
+                if (toktype(oq.back()) == LPAREN) break;
+                args.push_back(oq.back());
+                oq.pop_back();
+                if (!oq.size()) err("Bracket without matching", tok.metadata);
+            }
+            oq.pop_back();
+            args.push_back(oq.back());
+            oq.pop_back();
+            // We represent a[b] as (access a b)
+            if (tok.val == "]")
+                 args.push_back(token("access", tok.metadata));
+            if (args.back().type == ASTNODE)
+                 args.push_back(token("fun", tok.metadata));
+            std::string fun = args.back().val;
+            args.pop_back();
+            // We represent [1,2,3] as (array_lit 1 2 3)
+            if (fun == "access" && args.size() && args.back().val == "id") {
+                fun = "array_lit";
+                args.pop_back();
+            }
+            std::vector<Node> args2;
+            while (args.size()) {
+                args2.push_back(args.back());
+                args.pop_back();
+            }
+            // When evaluating 2 + (3 * 5), the shunting yard algo turns that
+            // into 2 ( id 3 5 * ) +, effectively putting "id" as a dummy
+            // function where the algo was expecting a function to call the
+            // thing inside the brackets. This reverses that step
+            if (fun == "id" && args2.size() == 1) {
+                oq.push_back(args2[0]);
+            }
+            else {
+                oq.push_back(astnode(fun, args2, tok.metadata));
+            }
+        }
+        else oq.push_back(tok);
+    }
+    // Output must have one argument
+    if (oq.size() == 0) {
+        err("Output blank", Metadata());
+    }
+    else if (oq.size() > 1) {
+        return asn("multi", oq, oq[0].metadata);
+    }
+
+    return oq[0];
+}
+
+bool same(const Node &a, const Node &b) {
+    if (a.type != b.type || a.val != b.val || a.args.size() != b.args.size()
+            || a.metadata.ln != b.metadata.ln
+            || a.metadata.ch != b.metadata.ch)
+        return false;
+    for (unsigned i = 0; i < a.args.size(); i++) {
+        if (!same(a.args[i], b.args[i])) return false;
+    }
+    return true;
+}
+
+double now() {
+    struct timeval tv;
+    gettimeofday(&tv, 0);
+    return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+// Lines of tokens per second
+template <typename F>
+double throughput(const std::vector<std::vector<Node> > &lines, F f) {
+    double count = 0, start = now(), end;
+    do {
+        for (unsigned i = 0; i < lines.size(); i++) f(lines[i]);
+        count += lines.size();
+        end = now();
+    } while (end - start < 0.5);
+    return count / (end - start);
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: parse <file.se> ...\n";
+        return 1;
+    }
+    std::vector<std::vector<Node> > lines;
+    unsigned tokens = 0;
+    for (int i = 1; i < argc; i++) {
+        std::vector<std::string> src = splitLines(get_file_contents(argv[i]));
+        for (unsigned j = 0; j < src.size(); j++) {
+            std::vector<Node> toks = tokenize(src[j], Metadata(argv[i], j, 0));
+            std::vector<Node> line;
+            bool skip = false;
+            for (unsigned k = 0; k < toks.size(); k++) {
+                if (toks[k].val == "#" || toks[k].val == "//") break;
+                if (toks[k].val == "inset" || toks[k].val == "import"
+                        || toks[k].val == "create")
+                    skip = true;
+                line.push_back(toks[k]);
+            }
+            if (line.size() && line.back().val == ":") line.pop_back();
+            if (!line.size() || skip) continue;
+            if (!same(oldTreefy(oldShuntingYard(line)),
+                      parseSerpentTokenStream(line))) {
+                std::cerr << "Tree mismatch on " << argv[i] << " line "
+                          << j + 1 << "\n";
+                return 1;
+            }
+            lines.push_back(line);
+            tokens += line.size();
+        }
+    }
+    printf("%d files, %d lines, %d tokens\n", argc - 1, (int)lines.size(),
+           tokens);
+    double o = throughput(lines, [](const std::vector<Node> &l) {
+        oldTreefy(oldShuntingYard(l));
+    });
+    double n = throughput(lines, [](const std::vector<Node> &l) {
+        parseSerpentTokenStream(l);
+    });
+    printf("%-28s %10.0f lines/s\n", "shuntingYard + treefy", o);
+    printf("%-28s %10.0f lines/s %8.1fx\n", "parseSerpentTokenStream", n,
+           n / o);
+    return 0;
+}
@@ -0,0 +1,188 @@
+// How the time of each phase of a compilation grows with the size of the
+// input. Every generator of stress.h is run at doubling sizes, up to
+// 100000 lines of source or until one compilation takes longer than the
+// time budget, and the times of each phase (see passTimings in util.h)
+// are fitted to a power of n. A phase whose time grows faster than
+// n log n over the sizes at which it is slow enough to measure fails the
+// run, and the program exits with status 1
+//
+// Build and run with `make scaling`, or
+// `make bench_scaling && ./bench/scaling [-t seconds] [-l lines] [dimension ...]`
+#include <stdio.h>
+#include <math.h>
+#include <iostream>
+#include <vector>
+#include <string>
+#include <map>
+#include <algorithm>
+#include "../util.h"
+#include "../bignum.h"
+#include "../funcs.h"
+#include "stress.h"
+
+// The longest expression nesting that compiles on the default stack
+const unsigned MAX_NESTING = 512;
+// Text literals are all on one line, so are capped by length instead
+const unsigned MAX_TEXT = 1 << 20;
+// Phases quicker than this at a size are too noisy to fit
+const double MIN_SECONDS = 0.002;
+// How far the fitted exponent may exceed that of n log n
+const double TOLERANCE = 0.25;
+
+class dimension {
+    public:
+        std::string name;
+        std::string (*generate)(unsigned n);
+        unsigned start;
+        unsigned limit;
+};
+
+std::vector<dimension> dimensions() {
+    dimension d[] = {
+        { "statements", stressStatements, 100, 1 << 30 },
+        { "functions", stressFunctions, 25, 1 << 30 },
+        { "nesting", stressNesting, 8, MAX_NESTING },
+        { "macros", stressMacros, 25, 1 << 30 },
+        { "data", stressData, 25, 1 << 30 },
+        { "text", stressText, 1000, MAX_TEXT },
+    };
+    return std::vector<dimension>(d, d + sizeof(d) / sizeof(d[0]));
+}
+
+unsigned lineCount(const std::string &s) {
+    unsigned o = 0;
+    for (unsigned i = 0; i < s.size(); i++) o += s[i] == '\n';
+    return o;
+}
+
+// Seconds spent in each phase, and in the whole compilation as "total",
+// keeping the fastest of a few runs. Phases not seen before are added to
+// order as they start
+std::map<std::string, double> measure(const std::string &code,
+                                      std::vector<std::string> &order) {
+    std::map<std::string, double> best;
+    double spent = 0;
+    for (unsigned run = 0; run < 3 && (run == 0 || spent < 1); run++) {
+        passTimings timings;
+        std::chrono::steady_clock::time_point start =
+            std::chrono::steady_clock::now();
+        {
+            passTimingScope timing(&timings);
+            compilationScope scope;
+            compileLLL(compileToLLL(code));
+        }
+        double seconds = secondsSince(start);
+        spent += seconds;
+        std::map<std::string, double> times;
+        times["total"] = seconds;
+        for (unsigned i = 0; i < timings.phases.size(); i++) {
+            const std::string &name = timings.phases[i].name;
+            if (std::find(order.begin(), order.end(), name) == order.end())
+                order.push_back(name);
+            times[name] += timings.phases[i].seconds;
+        }
+        std::map<std::string, double>::iterator it;
+        for (it = times.begin(); it != times.end(); it++) {
+            if (!best.count(it->first) || it->second < best[it->first])
+                best[it->first] = it->second;
+        }
+    }
+    return best;
+}
+
+// Least squares slope of y against x
+double slope(const std::vector<double> &x, const std::vector<double> &y) {
+    double mx = 0, my = 0;
+    for (unsigned i = 0; i < x.size(); i++) {
+        mx += x[i] / x.size();
+        my += y[i] / y.size();
+    }
+    double sxy = 0, sxx = 0;
+    for (unsigned i = 0; i < x.size(); i++) {
+        sxy += (x[i] - mx) * (y[i] - my);
+        sxx += (x[i] - mx) * (x[i] - mx);
+    }
+    return sxx > 0 ? sxy / sxx : 0;
+}
+
+// Runs one dimension and reports on it, returning the number of phases
+// that grow too fast
+int scale(const dimension &d, double budget, unsigned maxLines) {
+    std::vector<unsigned> sizes;
+    std::vector<std::map<std::string, double> > times;
+    std::vector<std::string> order(1, "total");
+    unsigned lines = 0;
+    for (unsigned n = d.start; n <= d.limit; n *= 2) {
+        std::string code = d.generate(n);
+        if (sizes.size() >= 2 && lineCount(code) > maxLines) break;
+        lines = lineCount(code);
+        std::map<std::string, double> t;
+        try {
+            t = measure(code, order);
+        }
+        catch (std::string &e) {
+            std::cerr << d.name << ":" << n << ": " << e << "\n";
+            return 1;
+        }
+        sizes.push_back(n);
+        times.push_back(t);
+        if (t["total"] > budget) break;
+    }
+    printf("%s: n = %u .. %u, up to %u lines\n", d.name.c_str(), sizes[0],
+           sizes.back(), lines);
+    printf("    %-18s %8s  %-6s  %s\n", "phase", "exponent", "", "ms at each n");
+    int failed = 0;
+    for (unsigned p = 0; p < order.size(); p++) {
+        // Fit the sizes at which the phase takes long enough to time
+        std::vector<double> x, y, yn;
+        std::string row;
+        for (unsigned i = 0; i < sizes.size(); i++) {
+            double t = times[i].count(order[p]) ? times[i][order[p]] : 0;
+            char buf[32];
+            sprintf(buf, " %.1f", t * 1000);
+            row += buf;
+            if (t < MIN_SECONDS) continue;
+            double n = sizes[i];
+            x.push_back(log(n));
+            y.push_back(log(t));
+            yn.push_back(log(t / (n * log(n))));
+        }
+        std::string verdict = "-";
+        char exponent[32] = "-";
+        if (x.size() >= 3) {
+            sprintf(exponent, "%.2f", slope(x, y));
+            bool ok = slope(x, yn) <= TOLERANCE;
+            verdict = ok ? "ok" : "FAIL";
+            if (!ok && order[p] != "total") failed++;
+        }
+        printf("    %-18s %8s  %-6s %s\n", order[p].c_str(), exponent,
+               verdict.c_str(), row.c_str());
+    }
+    return failed;
+}
+
+int main(int argc, char **argv) {
+    double budget = 5;
+    unsigned maxLines = 100000;
+    std::vector<std::string> only;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-t" && i + 1 < argc) budget = atof(argv[++i]);
+        else if (arg == "-l" && i + 1 < argc)
+            maxLines = decimalToUnsigned(argv[++i]);
+        else only.push_back(arg);
+    }
+    std::vector<dimension> d = dimensions();
+    int failed = 0;
+    for (unsigned i = 0; i < d.size(); i++) {
+        if (only.size() && std::find(only.begin(), only.end(), d[i].name)
+                               == only.end())
+            continue;
+        failed += scale(d[i], budget, maxLines);
+    }
+    if (failed) {
+        printf("%d phase(s) grow faster than n log n\n", failed);
+        return 1;
+    }
+    return 0;
+}
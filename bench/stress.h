@@ -0,0 +1,119 @@
+// Generated contracts for the compile benchmarks, each one scaled up
+// along a single dimension
+#ifndef ETHSERP_BENCH_STRESS
+#define ETHSERP_BENCH_STRESS
+
+#include <string>
+#include <vector>
+#include "../bignum.h"
+
+// One function of n statements
+inline std::string stressStatements(unsigned n) {
+    std::string o = "def f(x):\n    y = x\n";
+    for (unsigned i = 0; i < n; i++) {
+        std::string k = unsignedToDecimal(i);
+        o += "    y = y * " + k + " + x\n";
+    }
+    return o + "    return(y)\n";
+}
+
+// n functions of a few statements each
+inline std::string stressFunctions(unsigned n) {
+    std::string o;
+    for (unsigned i = 0; i < n; i++) {
+        std::string k = unsignedToDecimal(i);
+        o += "def f" + k + "(x, y):\n"
+             "    z = x * " + k + " + y\n"
+             "    if z > " + k + ":\n"
+             "        return(z - " + k + ")\n"
+             "    return(z)\n\n";
+    }
+    return o;
+}
+
+// One expression nested n brackets deep
+inline std::string stressNesting(unsigned n) {
+    std::string o = "def f(x):\n    return(";
+    for (unsigned i = 0; i < n; i++) o += "(x + ";
+    o += "1";
+    for (unsigned i = 0; i < n; i++) o += ")";
+    return o + ")\n";
+}
+
+// n storage declarations, every other one a struct array
+inline std::string stressData(unsigned n) {
+    std::string o;
+    for (unsigned i = 0; i < n; i++) {
+        std::string k = unsignedToDecimal(i);
+        if (i % 2) o += "data d" + k + "[2^160](owner, balance, nonce)\n";
+        else o += "data d" + k + "\n";
+    }
+    std::string last = unsignedToDecimal(n ? n - 1 : 0);
+    o += "\ndef f(x):\n";
+    if (n % 2 == 0) o += "    self.d" + last + "[x].balance = x\n"
+                         "    return(self.d" + last + "[x].balance)\n";
+    else o += "    self.d" + last + " = x\n"
+              "    return(self.d" + last + ")\n";
+    return o;
+}
+
+// n macros, each used once
+inline std::string stressMacros(unsigned n) {
+    std::string o;
+    for (unsigned i = 0; i < n; i++) {
+        std::string k = unsignedToDecimal(i);
+        o += "macro m" + k + "($a):\n    $a * " + k + " + 1\n\n";
+    }
+    o += "def f(x):\n";
+    for (unsigned i = 0; i < n; i++)
+        o += "    x = m" + unsignedToDecimal(i) + "(x)\n";
+    return o + "    return(x)\n";
+}
+
+// A text literal n characters long
+inline std::string stressText(unsigned n) {
+    std::string s;
+    for (unsigned i = 0; i < n; i++) s += (char)('a' + i % 26);
+    return "def f():\n    return(text(\"" + s + "\"):str)\n";
+}
+
+class stressContract {
+    public:
+        std::string name;
+        std::string code;
+};
+
+// The generated contracts the benchmark compiles by default
+inline std::vector<stressContract> stressContracts() {
+    std::vector<stressContract> o;
+    unsigned statements[] = { 10, 100, 1000 };
+    unsigned functions[] = { 10, 100, 400 };
+    unsigned nesting[] = { 10, 100, 300 };
+    unsigned macros[] = { 10, 100, 400 };
+    unsigned data[] = { 10, 100, 1000 };
+    unsigned text[] = { 100, 10000, 100000 };
+    for (unsigned i = 0; i < 3; i++) {
+        stressContract c;
+        c.name = "statements:" + unsignedToDecimal(statements[i]);
+        c.code = stressStatements(statements[i]);
+        o.push_back(c);
+        c.name = "functions:" + unsignedToDecimal(functions[i]);
+        c.code = stressFunctions(functions[i]);
+        o.push_back(c);
+        c.name = "nesting:" + unsignedToDecimal(nesting[i]);
+        c.code = stressNesting(nesting[i]);
+        o.push_back(c);
+        c.name = "macros:" + unsignedToDecimal(macros[i]);
+        c.code = stressMacros(macros[i]);
+        o.push_back(c);
+        c.name = "data:" + unsignedToDecimal(data[i]);
+        c.code = stressData(data[i]);
+        o.push_back(c);
+        c.name = "text:" + unsignedToDecimal(text[i]);
+        c.code = stressText(text[i]);
+        o.push_back(c);
+    }
+    return o;
+}
+
+#endif
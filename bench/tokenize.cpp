@@ -0,0 +1,194 @@
+// Tokenizer throughput, comparing the table-driven tokenizer in
+// tokenize.cpp against the original character-at-a-time implementation
+// (reproduced below). Each input file is tokenized repeatedly, both
+// results are checked to be identical, and throughput is given in MB/s.
+// The span tokenizer is also timed with each scan kernel set the CPU
+// supports, on the given files and on generated sources with long
+// identifiers, wide indentation and long string literals
+//
+// Build and run with
+// `make bench_tokenize && ./bench/tokenize examples/*.se examples/*/*.se`
+#include <stdio.h>
+#include <iostream>
+#include <vector>
+#include <string>
+#include <sys/time.h>
+#include "../util.h"
+#include "../tokenize.h"
+#include "../lexscan.h"
+#include "../bignum.h"
+
+const std::string atoms[] = { "#", "//", "(", ")", "[", "]", "{", "}" };
+const int numAtoms = 8;
+
+int oldChartype(char c) {
+    if (c >= '0' && c <= '9') return ALPHANUM;
+    else if (c >= 'a' && c <= 'z') return ALPHANUM;
+    else if (c >= 'A' && c <= 'Z') return ALPHANUM;
+    else if (std::string("~_$@").find(c) != std::string::npos) return ALPHANUM;
+    else if (c == '\t' || c == ' ' || c == '\n' || c == '\r') return SPACE;
+    else if (std::string("()[]{}").find(c) != std::string::npos) return BRACK;
+    else if (c == '"') return DQUOTE;
+    else if (c == '\'') return SQUOTE;
+    else return SYMB;
+}
+
+std::vector<Node> oldTokenize(std::string inp, Metadata metadata, bool lispMode) {
+    int curtype = SPACE;
+    unsigned pos = 0;
+    int lastNewline = 0;
+    metadata.ch = 0;
+    std::string cur;
+    std::vector<Node> out;
+
+    inp += " ";
+    while (pos < inp.length()) {
+        int headtype = oldChartype(inp[pos]);
+        if (lispMode) {
+            if (inp[pos] == '\'') headtype = ALPHANUM;
+        }
+        if (curtype == SQUOTE || curtype == DQUOTE) {
+            if (headtype == curtype) {
+                cur += inp[pos];
+                out.push_back(token(cur, metadata));
+                cur = "";
+                metadata.ch = pos - lastNewline;
+                curtype = SPACE;
+                pos += 1;
+            }
+            else if (inp.length() >= pos + 2 && inp[pos] == '\\') {
+                cur += inp[pos];
+                cur += inp[pos + 1];
+                pos += 2;
+            }
+            else {
+                cur += inp[pos];
+                pos += 1;
+            }
+        }
+        else {
+            for (int i = 0; i < numAtoms; i++) {
+                int split = cur.length() - atoms[i].length();
+                if (split >= 0 && cur.substr(split) == atoms[i]) {
+                    if (split > 0) {
+                        out.push_back(token(cur.substr(0, split), metadata));
+                    }
+                    metadata.ch += split;
+                    out.push_back(token(cur.substr(split), metadata));
+                    metadata.ch = pos - lastNewline;
+                    cur = "";
+                    curtype = SPACE;
+                }
+            }
+            if (cur.length() > 1 && (cur.substr(cur.length() - 1) == "-"
+                                  || cur.substr(cur.length() - 1) == "!")) {
+                out.push_back(token(cur.substr(0, cur.length() - 1), metadata));
+                out.push_back(token(cur.substr(cur.length() - 1), metadata));
+                cur = "";
+            }
+            if (headtype != curtype) {
+                if (curtype != SPACE && cur != "") {
+                    out.push_back(token(cur, metadata));
+                }
+                metadata.ch = pos - lastNewline;
+                cur = "";
+            }
+            cur += inp[pos];
+            curtype = headtype;
+            pos += 1;
+        }
+        if (inp[pos] == '\n') {
+            lastNewline = pos;
+            metadata.ch = 0;
+            metadata.ln += 1;
+        }
+    }
+    return out;
+}
+
+double now() {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+bool same(const std::vector<Node> &a, const std::vector<Node> &b) {
+    if (a.size() != b.size()) return false;
+    for (unsigned i = 0; i < a.size(); i++) {
+        if (a[i].val != b[i].val
+                || a[i].metadata.ln != b[i].metadata.ln
+                || a[i].metadata.ch != b[i].metadata.ch)
+            return false;
+    }
+    return true;
+}
+
+// Tokenizes the whole corpus until at least 0.5s have passed
+template <typename F>
+double throughput(const std::vector<std::string> &corpus, F f) {
+    double bytes = 0, start = now(), end;
+    do {
+        for (unsigned i = 0; i < corpus.size(); i++) {
+            f(corpus[i]);
+            bytes += corpus[i].length();
+        }
+        end = now();
+    } while (end - start < 0.5);
+    return bytes / (end - start) / 1e6;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: tokenize <file.se> ...\n";
+        return 1;
+    }
+    std::vector<std::string> corpus;
+    double total = 0;
+    for (int i = 1; i < argc; i++) {
+        corpus.push_back(get_file_contents(argv[i]));
+        total += corpus.back().length();
+        if (!same(oldTokenize(corpus.back(), Metadata(), false),
+                  tokenize(corpus.back(), Metadata(), false))) {
+            std::cerr << "Token mismatch on " << argv[i] << "\n";
+            return 1;
+        }
+    }
+    printf("%d files, %.0f bytes\n", argc - 1, total);
+    double o = throughput(corpus, [](const std::string &s) {
+        oldTokenize(s, Metadata(), false);
+    });
+    double n = throughput(corpus, [](const std::string &s) {
+        tokenize(s, Metadata(), false);
+    });
+    printf("%-28s %10.2f MB/s\n", "old tokenize", o);
+    printf("%-28s %10.2f MB/s %8.1fx\n", "tokenize", n, n / o);
+    // Data tables and long text literals
+    std::string big;
+    for (int i = 0; i < 2000; i++) {
+        big += "                self.table[" + unsignedToDecimal(i) + "] = "
+             + "0x0123456789abcdef0123456789abcdef0123456789abcdef01234567\n";
+        big += "                log(text(\"";
+        for (int j = 0; j < 8; j++)
+            big += "the quick brown fox jumps over the lazy dog, ";
+        big += "\"))\n";
+    }
+    std::vector<std::string> generated(1, big);
+    if (!same(oldTokenize(big, Metadata(), false),
+              tokenize(big, Metadata(), false))) {
+        std::cerr << "Token mismatch on generated source\n";
+        return 1;
+    }
+    const char *levels[] = { "scalar", "sse4.2", "avx2" };
+    for (int l = LEXSCAN_SCALAR; l <= lexScanSupported(); l++) {
+        setLexScanLevel(l);
+        double a = throughput(corpus, [](const std::string &s) {
+            tokenizeSpans(s, Metadata(), false);
+        });
+        double b = throughput(generated, [](const std::string &s) {
+            tokenizeSpans(s, Metadata(), false);
+        });
+        printf("tokenizeSpans %-14s %10.2f MB/s %8.1fx   generated: %8.2f MB/s\n",
+               levels[l], a, a / o, b);
+    }
+    return 0;
+}
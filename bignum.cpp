@@ -2,87 +2,289 @@
 #include <iostream>
 #include <vector>
 #include <map>
+#include <stdint.h>
 #include "bignum.h"
 
-//Integer to string conversion
-std::string unsignedToDecimal(unsigned branch) {
-    if (branch < 10) return nums.substr(branch, 1);
-    else return unsignedToDecimal(branch / 10) + nums.substr(branch % 10,1);
+// Arbitrary precision values are kept as little-endian limbs in base
+// 10^9, so that converting to and from decimal strings is linear
+#define limbvec std::vector<uint32_t>
+
+const uint32_t LIMB_BASE = 1000000000;
+const unsigned LIMB_DIGITS = 9;
+
+// Below this many limbs schoolbook multiplication beats Karatsuba
+const unsigned KARATSUBA_THRESHOLD = 32;
+
+// Drop leading zero limbs (zero is the empty vector)
+static void trim(limbvec &a) {
+    while (a.size() && a.back() == 0) a.pop_back();
 }
 
-//Add two strings representing decimal values
-std::string decimalAdd(std::string a, std::string b) {
-    std::string o = a;
-    while (b.length() < a.length()) b = "0" + b;
-    while (o.length() < b.length()) o = "0" + o;
-    bool carry = false;
-    for (int i = o.length() - 1; i >= 0; i--) {
-        o[i] = o[i] + b[i] - '0';
-        if (carry) o[i]++;
-        if (o[i] > '9') {
-            o[i] -= 10;
-            carry = true;
-        }
-        else carry = false;
+static limbvec fromDecimal(const std::string &s) {
+    limbvec o;
+    for (int end = s.size(); end > 0; end -= LIMB_DIGITS) {
+        int start = end > (int)LIMB_DIGITS ? end - LIMB_DIGITS : 0;
+        uint32_t v = 0;
+        for (int i = start; i < end; i++) v = v * 10 + (s[i] - '0');
+        o.push_back(v);
     }
-    if (carry) o = "1" + o;
+    trim(o);
     return o;
 }
 
-//Helper function for decimalMul
-std::string decimalDigitMul(std::string a, int dig) {
-    if (dig == 0) return "0";
-    else return decimalAdd(a, decimalDigitMul(a, dig - 1));
+static std::string toDecimal(const limbvec &a) {
+    if (!a.size()) return "0";
+    std::string o(a.size() * LIMB_DIGITS, '0');
+    unsigned pos = o.size();
+    for (unsigned i = 0; i < a.size(); i++) {
+        uint32_t v = a[i];
+        for (unsigned k = 0; k < LIMB_DIGITS; k++) {
+            o[--pos] = '0' + v % 10;
+            v /= 10;
+        }
+    }
+    unsigned lead = 0;
+    while (lead + 1 < o.size() && o[lead] == '0') lead++;
+    return o.substr(lead);
+}
+
+static int compare(const limbvec &a, const limbvec &b) {
+    if (a.size() != b.size()) return a.size() < b.size() ? -1 : 1;
+    for (int i = a.size() - 1; i >= 0; i--) {
+        if (a[i] != b[i]) return a[i] < b[i] ? -1 : 1;
+    }
+    return 0;
 }
 
-//Multiply two strings representing decimal values
-std::string decimalMul(std::string a, std::string b) {
-    std::string o = "0";
-	for (unsigned i = 0; i < b.length(); i++) {
-        std::string n = decimalDigitMul(a, b[i] - '0');
-        if (n != "0") {
-			for (unsigned j = i + 1; j < b.length(); j++) n += "0";
+// a += b << (LIMB_DIGITS * shift)
+static void addInto(limbvec &a, const limbvec &b, unsigned shift=0) {
+    if (a.size() < b.size() + shift) a.resize(b.size() + shift, 0);
+    uint32_t carry = 0;
+    unsigned i = 0;
+    for (; i < b.size() || carry; i++) {
+        if (i + shift == a.size()) a.push_back(0);
+        uint32_t s = a[i + shift] + carry + (i < b.size() ? b[i] : 0);
+        carry = s >= LIMB_BASE;
+        a[i + shift] = carry ? s - LIMB_BASE : s;
+    }
+}
+
+// a -= b, requires a >= b
+static void subFrom(limbvec &a, const limbvec &b) {
+    int64_t borrow = 0;
+    for (unsigned i = 0; i < a.size() && (i < b.size() || borrow); i++) {
+        int64_t d = (int64_t)a[i] - borrow - (i < b.size() ? b[i] : 0);
+        borrow = d < 0;
+        a[i] = (uint32_t)(borrow ? d + LIMB_BASE : d);
+    }
+    trim(a);
+}
+
+static limbvec mulSchoolbook(const limbvec &a, const limbvec &b) {
+    if (!a.size() || !b.size()) return limbvec();
+    limbvec o(a.size() + b.size(), 0);
+    for (unsigned i = 0; i < a.size(); i++) {
+        uint64_t carry = 0;
+        for (unsigned j = 0; j < b.size(); j++) {
+            uint64_t cur = o[i + j] + (uint64_t)a[i] * b[j] + carry;
+            o[i + j] = (uint32_t)(cur % LIMB_BASE);
+            carry = cur / LIMB_BASE;
+        }
+        for (unsigned k = i + b.size(); carry; k++) {
+            uint64_t cur = o[k] + carry;
+            o[k] = (uint32_t)(cur % LIMB_BASE);
+            carry = cur / LIMB_BASE;
         }
-        o = decimalAdd(o, n);
     }
+    trim(o);
     return o;
 }
 
-//Modexp
-std::string decimalModExp(std::string b, std::string e, std::string m) {
-    if (e == "0") return "1";
-    else if (e == "1") return b;
-    else if (decimalMod(e, "2") == "0") {
-        std::string o = decimalModExp(b, decimalDiv(e, "2"), m);
-        return decimalMod(decimalMul(o, o), m);
+static limbvec mulLimbs(const limbvec &a, const limbvec &b);
+
+// Karatsuba: with a = a1*B^h + a0 and b = b1*B^h + b0,
+// a*b = z2*B^2h + ((a0+a1)(b0+b1) - z2 - z0)*B^h + z0
+static limbvec mulKaratsuba(const limbvec &a, const limbvec &b) {
+    unsigned h = (a.size() > b.size() ? a.size() : b.size()) / 2;
+    limbvec a0(a.begin(), a.begin() + (a.size() < h ? a.size() : h));
+    limbvec a1(a.size() > h ? a.begin() + h : a.end(), a.end());
+    limbvec b0(b.begin(), b.begin() + (b.size() < h ? b.size() : h));
+    limbvec b1(b.size() > h ? b.begin() + h : b.end(), b.end());
+    trim(a0);
+    trim(b0);
+    limbvec z0 = mulLimbs(a0, b0);
+    limbvec z2 = mulLimbs(a1, b1);
+    addInto(a0, a1);
+    addInto(b0, b1);
+    limbvec z1 = mulLimbs(a0, b0);
+    subFrom(z1, z0);
+    subFrom(z1, z2);
+    limbvec o = z0;
+    addInto(o, z1, h);
+    addInto(o, z2, 2 * h);
+    trim(o);
+    return o;
+}
+
+static limbvec mulLimbs(const limbvec &a, const limbvec &b) {
+    if (a.size() < KARATSUBA_THRESHOLD || b.size() < KARATSUBA_THRESHOLD)
+        return mulSchoolbook(a, b);
+    return mulKaratsuba(a, b);
+}
+
+// Multiply by a single limb-sized factor
+static limbvec mulSmall(const limbvec &a, uint32_t m) {
+    limbvec o;
+    uint64_t carry = 0;
+    for (unsigned i = 0; i < a.size() || carry; i++) {
+        uint64_t cur = (i < a.size() ? a[i] : 0) * (uint64_t)m + carry;
+        o.push_back((uint32_t)(cur % LIMB_BASE));
+        carry = cur / LIMB_BASE;
     }
-    else {
-        std::string o = decimalModExp(b, decimalDiv(e, "2"), m);
-        return decimalMod(decimalMul(decimalMul(o, o), b), m);
+    trim(o);
+    return o;
+}
+
+// Divide by a single limb-sized divisor, returning the remainder
+static uint32_t divSmall(limbvec &a, uint32_t d) {
+    uint64_t rem = 0;
+    for (int i = a.size() - 1; i >= 0; i--) {
+        uint64_t cur = a[i] + rem * LIMB_BASE;
+        a[i] = (uint32_t)(cur / d);
+        rem = cur % d;
     }
+    trim(a);
+    return (uint32_t)rem;
 }
 
-// Helper function for exponentiation
-std::string _decimalExp(std::string b, std::string e) {
-    if (e == "0") return "1";
-    else if (e == "1") return b;
-    else if (decimalMod(e, "2") == "0") {
-        std::string o = _decimalExp(b, decimalDiv(e, "2"));
-        return decimalMul(o, o);
+// Knuth's algorithm D (TAOCP 4.3.1): q = u / v, r = u % v, v nonzero
+static void divModLimbs(const limbvec &u, const limbvec &v,
+                        limbvec &q, limbvec &r) {
+    if (compare(u, v) < 0) {
+        q = limbvec();
+        r = u;
+        return;
+    }
+    if (v.size() == 1) {
+        q = u;
+        r = limbvec(1, divSmall(q, v[0]));
+        trim(r);
+        return;
     }
-    else {
-        std::string o = _decimalExp(b, decimalDiv(e, "2"));
-        return decimalMul(decimalMul(o, o), b);
+    // Normalize so that the top limb of the divisor is at least base/2
+    uint32_t d = LIMB_BASE / (v.back() + 1);
+    limbvec un = mulSmall(u, d), vn = mulSmall(v, d);
+    unsigned n = vn.size(), m = u.size() - v.size();
+    un.resize(u.size() + 1, 0);
+    q = limbvec(m + 1, 0);
+    for (int j = m; j >= 0; j--) {
+        // Estimate the quotient limb, then correct it by at most two
+        uint64_t num = (uint64_t)un[j + n] * LIMB_BASE + un[j + n - 1];
+        uint64_t qhat = num / vn[n - 1];
+        uint64_t rhat = num % vn[n - 1];
+        while (qhat >= LIMB_BASE ||
+               qhat * vn[n - 2] > rhat * LIMB_BASE + un[j + n - 2]) {
+            qhat -= 1;
+            rhat += vn[n - 1];
+            if (rhat >= LIMB_BASE) break;
+        }
+        // Multiply and subtract
+        uint64_t carry = 0;
+        int64_t borrow = 0;
+        for (unsigned i = 0; i < n; i++) {
+            uint64_t p = qhat * vn[i] + carry;
+            carry = p / LIMB_BASE;
+            int64_t t = (int64_t)un[i + j] - (int64_t)(p % LIMB_BASE) - borrow;
+            borrow = t < 0;
+            un[i + j] = (uint32_t)(borrow ? t + LIMB_BASE : t);
+        }
+        int64_t t = (int64_t)un[j + n] - (int64_t)carry - borrow;
+        borrow = t < 0;
+        un[j + n] = (uint32_t)(borrow ? t + LIMB_BASE : t);
+        q[j] = (uint32_t)qhat;
+        // Estimate was one too high: add the divisor back
+        if (borrow) {
+            q[j] -= 1;
+            uint32_t c = 0;
+            for (unsigned i = 0; i < n; i++) {
+                uint32_t s = un[i + j] + vn[i] + c;
+                c = s >= LIMB_BASE;
+                un[i + j] = c ? s - LIMB_BASE : s;
+            }
+            un[j + n] = (un[j + n] + c) % LIMB_BASE;
+        }
+    }
+    trim(q);
+    un.resize(n);
+    trim(un);
+    divSmall(un, d);
+    r = un;
+}
+
+static limbvec modLimbs(const limbvec &a, const limbvec &m) {
+    limbvec q, r;
+    divModLimbs(a, m, q, r);
+    return r;
+}
+
+// Square-and-multiply, reducing modulo m when m is nonempty
+static limbvec expLimbs(limbvec b, limbvec e, const limbvec &m) {
+    limbvec o(1, 1);
+    if (m.size()) b = modLimbs(b, m);
+    while (e.size()) {
+        if (divSmall(e, 2)) {
+            o = mulLimbs(o, b);
+            if (m.size()) o = modLimbs(o, m);
+        }
+        if (e.size()) {
+            b = mulLimbs(b, b);
+            if (m.size()) b = modLimbs(b, m);
+        }
     }
+    return o;
+}
+
+//Integer to string conversion
+std::string unsignedToDecimal(unsigned branch) {
+    char buf[16];
+    sprintf(buf, "%u", branch);
+    return buf;
+}
+
+//Add two strings representing decimal values (directly on the digits,
+//which is already linear)
+std::string decimalAdd(std::string a, std::string b) {
+    if (a.length() < b.length()) a.swap(b);
+    int carry = 0;
+    for (int i = a.length() - 1, j = b.length() - 1; i >= 0; i--, j--) {
+        if (j < 0 && !carry) break;
+        int d = a[i] - '0' + carry + (j >= 0 ? b[j] - '0' : 0);
+        carry = d > 9;
+        a[i] = '0' + (carry ? d - 10 : d);
+    }
+    if (carry) a = "1" + a;
+    return a;
+}
+
+//Multiply two strings representing decimal values
+std::string decimalMul(std::string a, std::string b) {
+    return toDecimal(mulLimbs(fromDecimal(a), fromDecimal(b)));
+}
+
+//Modexp
+std::string decimalModExp(std::string b, std::string e, std::string m) {
+    if (e == "0") return "1";
+    else if (e == "1") return b;
+    return toDecimal(expLimbs(fromDecimal(b), fromDecimal(e), fromDecimal(m)));
 }
 
 // Safety wrapper for exponentiation
 std::string decimalExp(std::string b, std::string e) {
-    if (b != "0" && b != "1" && 
+    if (b != "0" && b != "1" &&
             (e.size() > 5 || b.size() * decimalToUnsigned(e) > 33333)) {
         throw("Exponent way too large: "+e);
     }
-    std::string o = _decimalExp(b, e);
+    std::string o = toDecimal(expLimbs(fromDecimal(b), fromDecimal(e), limbvec()));
     if (o.size() > 10000)
         throw("Out of bounds (maximum 10000 digits)");
     return o;
@@ -94,45 +296,33 @@ bool decimalGt(std::string a, std::string b, bool eqAllowed) {
     return (a.length() > b.length()) || (a.length() >= b.length() && a > b);
 }
 
-//Subtract the two strings representing decimal values
+//Subtract the two strings representing decimal values (a >= b)
 std::string decimalSub(std::string a, std::string b) {
-    if (b == "0") return a;
-    if (b == a) return "0";
-    while (b.length() < a.length()) b = "0" + b;
-    std::string c = b;
-	for (unsigned i = 0; i < c.length(); i++) c[i] = '0' + ('9' - c[i]);
-    std::string o = decimalAdd(decimalAdd(a, c).substr(1), "1");
-    while (o.size() > 1 && o[0] == '0') o = o.substr(1);
-    return o;
+    limbvec o = fromDecimal(a), s = fromDecimal(b);
+    if (compare(o, s) < 0) return "0";
+    subFrom(o, s);
+    return toDecimal(o);
 }
 
 //Divide the two strings representing decimal values
 std::string decimalDiv(std::string a, std::string b) {
-    std::string c = b;
-    if (decimalGt(c, a)) return "0";
-    int zeroes = -1;
-    while (decimalGt(a, c, true)) {
-        zeroes += 1;
-        c = c + "0";
-    }
-    c = c.substr(0, c.size() - 1);
-    std::string quot = "0";
-    while (decimalGt(a, c, true)) {
-        a = decimalSub(a, c);
-        quot = decimalAdd(quot, "1");
-    }
-    for (int i = 0; i < zeroes; i++) quot += "0";
-    return decimalAdd(quot, decimalDiv(a, b));
+    limbvec d = fromDecimal(b), q, r;
+    if (!d.size()) return "0";
+    divModLimbs(fromDecimal(a), d, q, r);
+    return toDecimal(q);
 }
 
 //Modulo the two strings representing decimal values
 std::string decimalMod(std::string a, std::string b) {
-    return decimalSub(a, decimalMul(decimalDiv(a, b), b));
+    limbvec d = fromDecimal(b), q, r;
+    if (!d.size()) return "0";
+    divModLimbs(fromDecimal(a), d, q, r);
+    return toDecimal(r);
 }
 
 //String to int conversion
 unsigned decimalToUnsigned(std::string a) {
-    if (a.size() == 0) return 0;
-    else return (a[a.size() - 1] - '0') 
-        + decimalToUnsigned(a.substr(0,a.size()-1)) * 10;
+    unsigned o = 0;
+    for (unsigned i = 0; i < a.size(); i++) o = o * 10 + (a[i] - '0');
+    return o;
 }
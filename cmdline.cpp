@@ -3,7 +3,9 @@
 #include <iostream>
 #include <vector>
 #include <map>
+#include <fstream>
 #include "funcs.h"
+#include "batch.h"
 
 int main(int argv, char** argc) {
     if (argv == 1) {
@@ -18,10 +20,61 @@ int main(int argv, char** argc) {
         std::cout << "where command: \n";
         std::cout << " parse:          Just parses and returns s-expression code.\n";
         std::cout << " rewrite:        Parse, use rewrite rules print s-expressions of result.\n";
+        std::cout << "                 rewrite --stats also reports what each rule did\n";
         std::cout << " compile:        Return resulting compiled EVM code in hex.\n";
         std::cout << " assemble:       Return result from step before compilation.\n";
+        std::cout << "serpent -j threads command input compiles the functions of a contract on threads\n";
+        std::cout << "serpent --time-passes command input reports the time each compilation phase takes\n";
+        std::cout << "serpent --trace file.json command input writes the phases out as a Chrome trace\n";
+        std::cout << " batch:          Compile many files on worker threads: serpent batch [-j threads]\n";
+        std::cout << "                 [-m manifest] [--lll] [--signature] -o outdir [file.se ...]\n";
         return 0;
     }
+    // serpent -j threads command ...: compile functions, and parse the
+    // files they include, on threads
+    // serpent --time-passes command ...: report the time, size and peak
+    // heap of each phase of the compilation
+    // serpent --trace file.json command ...: write the phases out as a
+    // Chrome trace
+    bool timePasses = false;
+    std::string traceFile;
+    while (argv > 3) {
+        std::string opt = argc[1];
+        if (opt == "-j") {
+            setCompileThreads(decimalToUnsigned(argc[2]));
+            setParseThreads(decimalToUnsigned(argc[2]));
+            argc[2] = argc[0];
+            argc += 2;
+            argv -= 2;
+        }
+        else if (opt == "--trace") {
+            traceFile = argc[2];
+            argc[2] = argc[0];
+            argc += 2;
+            argv -= 2;
+        }
+        else if (opt == "--time-passes") {
+            timePasses = true;
+            argc[1] = argc[0];
+            argc++;
+            argv--;
+        }
+        else break;
+    }
+    passTimings timings;
+    passTimingScope timingScope(timePasses || traceFile.size() ?
+                                &timings : 0);
+    if (std::string(argc[1]) == "batch")
+        return batchMain(argv - 2, argc + 2);
+    // serpent rewrite --stats input: also report what each rule did
+    bool stats = false;
+    if (argv > 3 && std::string(argc[1]) == "rewrite"
+            && std::string(argc[2]) == "--stats") {
+        stats = true;
+        argc[2] = argc[1];
+        argc++;
+        argv--;
+    }
         
     std::string flag = "";
     std::string command = argc[1];
@@ -50,7 +103,10 @@ int main(int argv, char** argc) {
         std::cout << printAST(parseSerpent(input), haveSec) << "\n";
     }
     else if (command == "rewrite") {
+        rewriteStats s;
+        rewriteProfile profile(stats ? &s : 0);
         std::cout << printAST(rewrite(parseLLL(input, true)), haveSec) << "\n";
+        if (stats) std::cerr << s.report();
     }
     else if (command == "compile_to_lll") {
         std::cout << printAST(compileToLLL(input), haveSec) << "\n";
@@ -91,6 +147,9 @@ int main(int argv, char** argc) {
     else if (command == "mk_full_signature") {
         std::cout << mkFullSignature(input) << "\n";
     }
+    else if (command == "source_map") {
+        std::cout << mkSourceMap(input) << "\n";
+    }
     else if (command == "mk_contract_info_decl") {
         std::cout << mkContractInfoDecl(input) << "\n";
     }
@@ -111,4 +170,9 @@ int main(int argv, char** argc) {
         std::cout << "Opcode: " << n[pos].val << ", file: " << m.file << 
              ", line: " << m.ln << ", char: " << m.ch << "\n";
     }
+    if (timePasses) std::cerr << timings.report();
+    if (traceFile.size()) {
+        std::ofstream trace(traceFile.c_str());
+        trace << timings.chromeTrace();
+    }
 }
@@ -2,13 +2,18 @@
 #include <iostream>
 #include <vector>
 #include <map>
+#include <set>
+#include <algorithm>
 #include "util.h"
 #include "bignum.h"
+#include "uint256.h"
 #include "opcodes.h"
+#include "compiler.h"
 
 // Auxiliary data that is gathered while compiling
 struct programAux {
     std::map<std::string, std::string> vars;
+    std::map<std::string, int> labels;
     int nextVarMem;
     bool allocUsed;
     bool calldataUsed;
@@ -77,17 +82,58 @@ Node popwrap(Node node) {
     return multiToken(nodelist, 2, node.metadata);
 }
 
-// Turns LLL tree into tree of code fragments
+// Units of the program being compiled by buildFragmentTree, if any
+struct unitTable {
+    const std::vector<Node> *units;
+    const std::vector<std::string> *ids;
+    fragmentCache *cache;
+    int threads;
+    // Units compiled ahead on other threads, with what compiling them
+    // reported, which is passed on when the unit is reached
+    bool prepared;
+    std::map<unsigned, fragmentCache::entry> ready;
+    std::map<unsigned, jobOutcome> outcomes;
+};
+
+thread_local unitTable *activeUnits = 0;
+
+// Code compiled from one node, and the number of values it leaves on
+// the stack
+struct programFragment {
+    Node code;
+    int outs;
+};
+
+programFragment fragment(Node code, int outs=0) {
+    programFragment o;
+    o.code = code;
+    o.outs = outs;
+    return o;
+}
+
+programFragment opcodeifyUnit(unsigned index, programAux &aux,
+                              programVerticalAux vaux);
+
 programData opcodeify(Node node,
                       programAux aux=Aux(),
-                      programVerticalAux vaux=verticalAux()) {
+                      programVerticalAux vaux=verticalAux());
+
+// Turns LLL tree into tree of code fragments. The auxiliary data is
+// threaded through the whole tree, so it is updated in place rather than
+// copied at every node
+programFragment opcodeifyNode(const Node &node, programAux &aux,
+                              programVerticalAux vaux) {
+    if (activeUnits && node.val == SYM_COMMENT) {
+        int index = unitPlaceholderIndex(node);
+        if (index >= 0) return opcodeifyUnit(index, aux, vaux);
+    }
     std::string symb = "_"+mkUniqueToken();
     Metadata m = node.metadata;
     // Numbers
     if (node.type == TOKEN) {
-        return pd(aux, nodeToNumeric(node), 1);
+        return fragment(nodeToNumeric(node), 1);
     }
-    else if (node.val == "ref" || node.val == "get" || node.val == "set") {
+    else if (node.val == SYM_REF || node.val == SYM_GET || node.val == SYM_SET) {
         std::string varname = node.args[0].val;
         // Determine reference to variable
         if (!aux.vars.count(node.args[0].val)) {
@@ -97,8 +143,8 @@ programData opcodeify(Node node,
         Node varNode = tkn(aux.vars[varname], m);
         //std::cerr << varname << " " << printSimple(varNode) << "\n";
         // Set variable
-        if (node.val == "set") {
-            programData sub = opcodeify(node.args[1], aux, vaux);
+        if (node.val == SYM_SET) {
+            programFragment sub = opcodeifyNode(node.args[1], aux, vaux);
             if (!sub.outs)
                 err("Value to set variable must have nonzero arity!", m);
             // What if we are setting a stack variable?
@@ -110,7 +156,7 @@ programData opcodeify(Node node,
                     token("SWAP"+unsignedToDecimal(h), m),
                     token("POP", m)
                 };
-                return pd(sub.aux, multiToken(nodelist, 3, m), 0);                   
+                return fragment(multiToken(nodelist, 3, m), 0);                   
             }
             // Setting a memory variable
             else {
@@ -119,38 +165,38 @@ programData opcodeify(Node node,
                     varNode,
                     token("MSTORE", m),
                 };
-                return pd(sub.aux, multiToken(nodelist, 3, m), 0);                   
+                return fragment(multiToken(nodelist, 3, m), 0);                   
             }
         }
         // Get variable
-        else if (node.val == "get") {
+        else if (node.val == SYM_GET) {
             // Getting a stack variable
             if (vaux.dupvars.count(node.args[0].val)) {
                  int h = vaux.height - vaux.dupvars[node.args[0].val];
                 if (h > 16) err("Too deep for stack variable (max 16)", m);
-                return pd(aux, token("DUP"+unsignedToDecimal(h)), 1);                   
+                return fragment(token("DUP"+unsignedToDecimal(h)), 1);                   
             }
             // Getting a memory variable
             else {
                 Node nodelist[] = 
                      { varNode, token("MLOAD", m) };
-                return pd(aux, multiToken(nodelist, 2, m), 1);
+                return fragment(multiToken(nodelist, 2, m), 1);
             }
         }
         // Refer variable
-        else if (node.val == "ref") {
+        else if (node.val == SYM_REF) {
             if (vaux.dupvars.count(node.args[0].val))
                 err("Cannot ref stack variable!", m);
-            return pd(aux, varNode, 1);
+            return fragment(varNode, 1);
         }
     }
     // Comments do nothing
-    else if (node.val == "comment") {
-        return pd(aux, astnode("_", m), 0);
+    else if (node.val == SYM_COMMENT) {
+        return fragment(astnode("_", m), 0);
     }
     // Custom operation sequence
     // eg. (ops bytez id msize swap1 msize add 0 swap1 mstore) == alloc
-    if (node.val == "ops") {
+    if (node.val == SYM_OPS) {
         std::vector<Node>  subs2;
         int depth = 0;
         for (unsigned i = 0; i < node.args.size(); i++) {
@@ -158,8 +204,7 @@ programData opcodeify(Node node,
             if (node.args[i].type == ASTNODE || opinputs(op) == -1) {
                 programVerticalAux vaux2 = vaux;
                 vaux2.height = vaux.height - i - 1 + node.args.size();
-                programData sub = opcodeify(node.args[i], aux, vaux2);
-                aux = sub.aux;
+                programFragment sub = opcodeifyNode(node.args[i], aux, vaux2);
                 depth += sub.outs;
                 subs2.push_back(sub.code);
             }
@@ -169,14 +214,14 @@ programData opcodeify(Node node,
             }
         }
         if (depth < 0 || depth > 1) err("Stack depth mismatch", m);
-        return pd(aux, astnode("_", subs2, m), 0);
+        return fragment(astnode("_", subs2, m), 0);
     }
     // Code blocks
-    if (node.val == "lll" && node.args.size() == 2) {
-        if (node.args[1].val != "0") aux.allocUsed = true;
+    if (node.val == SYM_LLL && node.args.size() == 2) {
+        if (node.args[1].val != SYM_ZERO) aux.allocUsed = true;
         std::vector<Node> o;
         o.push_back(finalize(opcodeify(node.args[0])));
-        programData sub = opcodeify(node.args[1], aux, vaux);
+        programFragment sub = opcodeifyNode(node.args[1], aux, vaux);
         Node code = astnode("____CODE", o, m);
         Node nodelist[] = {
             token("$begincode"+symb+".endcode"+symb, m), token("DUP1", m),
@@ -185,47 +230,45 @@ programData opcodeify(Node node,
             token("~begincode"+symb, m), code, 
             token("~endcode"+symb, m), token("JUMPDEST", m)
         };
-        return pd(sub.aux, multiToken(nodelist, 11, m), 1);
+        return fragment(multiToken(nodelist, 11, m), 1);
     }
     // Stack variables
-    if (node.val == "with") {
-        programData initial = opcodeify(node.args[1], aux, vaux);
+    if (node.val == SYM_WITH) {
+        programFragment initial = opcodeifyNode(node.args[1], aux, vaux);
         programVerticalAux vaux2 = vaux;
         vaux2.dupvars[node.args[0].val] = vaux.height;
         vaux2.height += 1;
         if (!initial.outs)
             err("Initial variable value must have nonzero arity!", m);
-        programData sub = opcodeify(node.args[2], initial.aux, vaux2);
+        programFragment sub = opcodeifyNode(node.args[2], aux, vaux2);
         Node nodelist[] = {
             initial.code,
             sub.code
         };
-        programData o = pd(sub.aux, multiToken(nodelist, 2, m), sub.outs);
+        programFragment o = fragment(multiToken(nodelist, 2, m), sub.outs);
         if (sub.outs)
             o.code.args.push_back(token("SWAP1", m));
         o.code.args.push_back(token("POP", m));
         return o;
     }
     // Seq of multiple statements
-    if (node.val == "seq") {
+    if (node.val == SYM_SEQ) {
         std::vector<Node> children;
         int lastOut = 0;
         for (unsigned i = 0; i < node.args.size(); i++) {
-            programData sub = opcodeify(node.args[i], aux, vaux);
-            aux = sub.aux;
+            programFragment sub = opcodeifyNode(node.args[i], aux, vaux);
             if (sub.outs == 1) {
                 if (i < node.args.size() - 1) sub.code = popwrap(sub.code);
                 else lastOut = 1;
             }
             children.push_back(sub.code);
         }
-        return pd(aux, astnode("_", children, m), lastOut);
+        return fragment(astnode("_", children, m), lastOut);
     }
     // 2-part conditional (if gets rewritten to unless in rewrites)
-    else if (node.val == "unless" && node.args.size() == 2) {
-        programData cond = opcodeify(node.args[0], aux, vaux);
-        programData action = opcodeify(node.args[1], cond.aux, vaux);
-        aux = action.aux;
+    else if (node.val == SYM_UNLESS && node.args.size() == 2) {
+        programFragment cond = opcodeifyNode(node.args[0], aux, vaux);
+        programFragment action = opcodeifyNode(node.args[1], aux, vaux);
         if (!cond.outs) err("Condition of if/unless statement has arity 0", m);
         if (action.outs) action.code = popwrap(action.code);
         Node nodelist[] = {
@@ -234,14 +277,13 @@ programData opcodeify(Node node,
             action.code,
             token("~endif"+symb, m), token("JUMPDEST", m)
         };
-        return pd(aux, multiToken(nodelist, 6, m), 0);
+        return fragment(multiToken(nodelist, 6, m), 0);
     }
     // 3-part conditional
-    else if (node.val == "if" && node.args.size() == 3) {
-        programData ifd = opcodeify(node.args[0], aux, vaux);
-        programData thend = opcodeify(node.args[1], ifd.aux, vaux);
-        programData elsed = opcodeify(node.args[2], thend.aux, vaux);
-        aux = elsed.aux;
+    else if (node.val == SYM_IF && node.args.size() == 3) {
+        programFragment ifd = opcodeifyNode(node.args[0], aux, vaux);
+        programFragment thend = opcodeifyNode(node.args[1], aux, vaux);
+        programFragment elsed = opcodeifyNode(node.args[2], aux, vaux);
         if (!ifd.outs)
             err("Condition of if/unless statement has arity 0", m);
         // Handle cases where one conditional outputs something
@@ -259,13 +301,12 @@ programData opcodeify(Node node,
             elsed.code,
             token("~endif"+symb, m), token("JUMPDEST", m)
         };
-        return pd(aux, multiToken(nodelist, 12, m), outs);
+        return fragment(multiToken(nodelist, 12, m), outs);
     }
     // While (rewritten to this in rewrites)
-    else if (node.val == "until") {
-        programData cond = opcodeify(node.args[0], aux, vaux);
-        programData action = opcodeify(node.args[1], cond.aux, vaux);
-        aux = action.aux;
+    else if (node.val == SYM_UNTIL) {
+        programFragment cond = opcodeifyNode(node.args[0], aux, vaux);
+        programFragment action = opcodeifyNode(node.args[1], aux, vaux);
         if (!cond.outs)
             err("Condition of while/until loop has arity 0", m);
         if (action.outs) action.code = popwrap(action.code);
@@ -277,12 +318,11 @@ programData opcodeify(Node node,
             token("$beg"+symb, m), token("JUMP", m),
             token("~end"+symb, m), token("JUMPDEST", m),
         };
-        return pd(aux, multiToken(nodelist, 10, m));
+        return fragment(multiToken(nodelist, 10, m));
     }
     // Memory allocations
-    else if (node.val == "alloc") {
-        programData bytez = opcodeify(node.args[0], aux, vaux);
-        aux = bytez.aux;
+    else if (node.val == SYM_ALLOC) {
+        programFragment bytez = opcodeifyNode(node.args[0], aux, vaux);
         if (!bytez.outs)
             err("Alloc input has arity 0", m);
         aux.allocUsed = true;
@@ -292,12 +332,12 @@ programData opcodeify(Node node,
             token("ADD", m), 
             token("0", m), token("SWAP1", m), token("MSTORE", m)
         };
-        return pd(aux, multiToken(nodelist, 8, m), 1);
+        return fragment(multiToken(nodelist, 8, m), 1);
     }
     // All other functions/operators
     else {
         std::vector<Node>  subs2;
-        int depth = opinputs(upperCase(node.val));
+        int depth = opinputs(node.val);
         if (depth == -1)
             err("Not a function or opcode: "+node.val, m);
         if ((int)node.args.size() != depth)
@@ -305,18 +345,22 @@ programData opcodeify(Node node,
         for (int i = node.args.size() - 1; i >= 0; i--) {
             programVerticalAux vaux2 = vaux;
             vaux2.height = vaux.height - i - 1 + node.args.size();
-            programData sub = opcodeify(node.args[i], aux, vaux2);
-            aux = sub.aux;
+            programFragment sub = opcodeifyNode(node.args[i], aux, vaux2);
             if (!sub.outs)
                 err("Input "+unsignedToDecimal(i)+" has arity 0", sub.code.metadata);
             subs2.push_back(sub.code);
         }
         subs2.push_back(token(upperCase(node.val), m));
-        int outdepth = opoutputs(upperCase(node.val));
-        return pd(aux, astnode("_", subs2, m), outdepth);
+        int outdepth = opoutputs(node.val);
+        return fragment(astnode("_", subs2, m), outdepth);
     }
 }
 
+programData opcodeify(Node node, programAux aux, programVerticalAux vaux) {
+    programFragment f = opcodeifyNode(node, aux, vaux);
+    return pd(aux, f.code, f.outs);
+}
+
 // Adds necessary wrappers to a program
 Node finalize(programData c) {
     std::vector<Node> bottom;
@@ -336,9 +380,245 @@ Node finalize(programData c) {
     return astnode("_", bottom, m);
 }
 
+// opcodeify and finalize, each timed as a phase
+Node fragmentTree(Node node) {
+    programData c;
+    {
+        phaseScope phase("opcodeify", node);
+        c = opcodeify(node);
+        phase.out(c.code);
+    }
+    phaseScope phase("finalize", c.code);
+    Node o = finalize(c);
+    phase.out(o);
+    return o;
+}
+
 //LLL -> code fragment tree
 Node buildFragmentTree(Node node) {
-    return finalize(opcodeify(node));
+    compilationScope scope;
+    phaseScope phase("buildFragmentTree", node);
+    Node o = fragmentTree(node);
+    phase.out(o);
+    return o;
+}
+
+// The name is quoted like a variable's, so that the rewriter leaves it be
+// should it ever look inside
+Node unitPlaceholder(unsigned index, Metadata m) {
+    return astnode("comment", token("'__unit", m),
+                   token(unsignedToDecimal(index), m), m);
+}
+
+int unitPlaceholderIndex(const Node &n) {
+    if (n.val != SYM_COMMENT || n.args.size() != 2
+            || n.args[0].val != "'__unit" || !isDecimal(n.args[1].val))
+        return -1;
+    return decimalToUnsigned(n.args[1].val);
+}
+
+void fragmentCache::sweep() {
+    std::set<std::string> ids;
+    std::map<std::string, entry>::iterator it = fragments.begin();
+    while (it != fragments.end()) {
+        if (it->second.generation != generation) fragments.erase(it++);
+        else {
+            ids.insert(it->first.substr(0, it->first.find(' ')));
+            it++;
+        }
+    }
+    std::map<std::string, bool>::iterator m = movable.begin();
+    while (m != movable.end()) {
+        if (!ids.count(m->first)) movable.erase(m++);
+        else m++;
+    }
+    generation++;
+}
+
+// Units allocate their memory variables from here, and the addresses
+// are replaced with the real ones when the code is used
+const int UNIT_VAR_BASE = 1 << 30;
+const int UNIT_VAR_WINDOW = 1 << 24;
+
+// Does a unit have a constant that could be mistaken for one of the
+// stand-in variable addresses?
+bool hasStandInConstant(const Node &node) {
+    if (node.type == TOKEN) {
+        std::string v = nodeToNumeric(node).val;
+        if (!isDecimal(v) || v.size() > 10) return false;
+        unsigned long long n = 0;
+        for (unsigned i = 0; i < v.size(); i++) n = n * 10 + (v[i] - '0');
+        return n >= (unsigned long long)UNIT_VAR_BASE
+            && n < (unsigned long long)UNIT_VAR_BASE + UNIT_VAR_WINDOW;
+    }
+    for (unsigned i = 0; i < node.args.size(); i++)
+        if (hasStandInConstant(node.args[i])) return true;
+    return false;
+}
+
+Node relocate(const Node &node, const std::map<std::string, std::string> &to) {
+    if (node.type == TOKEN) {
+        std::map<std::string, std::string>::const_iterator it =
+            to.find(node.val);
+        return it == to.end() ? node : token(it->second, node.metadata);
+    }
+    Node o = node;
+    for (unsigned i = 0; i < o.args.size(); i++)
+        o.args[i] = relocate(node.args[i], to);
+    return o;
+}
+
+// A unit's code depends on nothing but the unit and the stack variables
+// in scope: its labels are its own, and its memory variables are at
+// stand-in addresses
+std::string unitKey(const std::string &id, programVerticalAux &vaux) {
+    std::string key = id + " " + unsignedToDecimal(vaux.height);
+    std::map<std::string, int>::iterator d;
+    for (d = vaux.dupvars.begin(); d != vaux.dupvars.end(); d++)
+        key += " " + d->first + "=" + unsignedToDecimal(d->second);
+    return key;
+}
+
+fragmentCache::entry compileUnit(const Node &unit, const std::string &id,
+                                 programAux aux, programVerticalAux vaux) {
+    // The flags are only ever set, so keep just what the unit sets
+    aux.vars.clear();
+    aux.nextVarMem = UNIT_VAR_BASE;
+    aux.allocUsed = false;
+    aux.calldataUsed = false;
+    programData sub;
+    {
+        uniqueTokenScope scope("u" + id.substr(0, 12) + "_");
+        sub = opcodeify(unit, aux, vaux);
+    }
+    if (sub.aux.nextVarMem - UNIT_VAR_BASE > UNIT_VAR_WINDOW)
+        err("Too many variables in one function", unit.metadata);
+    fragmentCache::entry e;
+    e.code = sub.code;
+    e.outs = sub.outs;
+    std::vector<std::pair<unsigned, std::string> > order;
+    std::map<std::string, std::string>::iterator v;
+    for (v = sub.aux.vars.begin(); v != sub.aux.vars.end(); v++)
+        order.push_back(std::make_pair(decimalToUnsigned(v->second),
+                                       v->first));
+    std::sort(order.begin(), order.end());
+    for (unsigned i = 0; i < order.size(); i++)
+        e.vars.push_back(std::make_pair(order[i].second,
+                                        sub.aux.vars[order[i].second]));
+    e.allocUsed = sub.aux.allocUsed;
+    e.calldataUsed = sub.aux.calldataUsed;
+    e.placedCode = e.code;
+    return e;
+}
+
+bool unitMovable(unsigned index) {
+    const std::string &id = (*activeUnits->ids)[index];
+    std::map<std::string, bool> &movable = activeUnits->cache->movable;
+    if (!movable.count(id))
+        movable[id] = !hasStandInConstant((*activeUnits->units)[index]);
+    return movable[id];
+}
+
+// Compiles every unit that is not cached yet on a pool of threads. All
+// the units of a contract sit side by side, so the stack variables where
+// the first one goes are those the rest are compiled with
+void prepareUnits(programAux &aux, programVerticalAux &vaux) {
+    unitTable &t = *activeUnits;
+    t.prepared = true;
+    if (t.threads < 2) return;
+    std::vector<unsigned> todo;
+    for (unsigned i = 0; i < t.units->size(); i++) {
+        if (unitMovable(i)
+                && !t.cache->fragments.count(unitKey((*t.ids)[i], vaux)))
+            todo.push_back(i);
+    }
+    if (todo.size() < 2) return;
+    std::vector<fragmentCache::entry> done(todo.size());
+    std::vector<jobOutcome> outcomes =
+        runJobs(todo.size(), t.threads, [&](unsigned j) {
+            done[j] = compileUnit((*t.units)[todo[j]], (*t.ids)[todo[j]],
+                                  aux, vaux);
+        });
+    for (unsigned j = 0; j < todo.size(); j++) {
+        t.outcomes[todo[j]] = outcomes[j];
+        if (!outcomes[j].error) t.ready[todo[j]] = done[j];
+    }
+}
+
+// Compiles a unit at a point in the program, or reuses its code if it
+// was compiled with the same stack variables before
+programFragment opcodeifyUnit(unsigned index, programAux &aux,
+                              programVerticalAux vaux) {
+    const Node &unit = (*activeUnits->units)[index];
+    const std::string &id = (*activeUnits->ids)[index];
+    fragmentCache &cache = *activeUnits->cache;
+    if (!unitMovable(index)) {
+        uniqueTokenScope scope("u" + id.substr(0, 12) + "_");
+        return opcodeifyNode(unit, aux, vaux);
+    }
+    if (!activeUnits->prepared) prepareUnits(aux, vaux);
+    std::string key = unitKey(id, vaux);
+    std::map<std::string, fragmentCache::entry>::iterator it =
+        cache.fragments.find(key);
+    if (it == cache.fragments.end()) {
+        cache.misses++;
+        fragmentCache::entry e;
+        if (activeUnits->outcomes.count(index)) {
+            activeUnits->outcomes[index].replay();
+            e = activeUnits->ready[index];
+        }
+        else e = compileUnit(unit, id, aux, vaux);
+        it = cache.fragments.insert(std::make_pair(key, e)).first;
+    }
+    else cache.hits++;
+    fragmentCache::entry &e = it->second;
+    e.generation = cache.generation;
+    // Variables not allocated yet go in the next free memory, in the
+    // order the unit allocates them, as they would had it been compiled
+    // here
+    std::map<std::string, std::string> moves;
+    std::string placement;
+    for (unsigned i = 0; i < e.vars.size(); i++) {
+        const std::string &name = e.vars[i].first;
+        if (!aux.vars.count(name)) {
+            aux.vars[name] = utd(aux.nextVarMem);
+            aux.nextVarMem += 32;
+        }
+        moves[e.vars[i].second] = aux.vars[name];
+        placement += aux.vars[name] + " ";
+    }
+    if (placement != e.placement) {
+        e.placedCode = relocate(e.code, moves);
+        e.placement = placement;
+    }
+    aux.allocUsed = aux.allocUsed || e.allocUsed;
+    aux.calldataUsed = aux.calldataUsed || e.calldataUsed;
+    return fragment(e.placedCode, e.outs);
+}
+
+Node buildFragmentTree(Node program, const std::vector<Node> &units,
+                       const std::vector<std::string> &unitIds,
+                       fragmentCache &cache, int threads) {
+    compilationScope scope;
+    unitTable table;
+    table.units = &units;
+    table.ids = &unitIds;
+    table.cache = &cache;
+    table.threads = threads;
+    table.prepared = false;
+    unitTable *outer = activeUnits;
+    activeUnits = &table;
+    try {
+        phaseScope phase("buildFragmentTree", program);
+        Node o = fragmentTree(program);
+        phase.out(o);
+        activeUnits = outer;
+        return o;
+    }
+    catch (...) {
+        activeUnits = outer;
+        throw;
+    }
 }
 
 
@@ -348,10 +628,14 @@ void buildDict(Node program, programAux &aux, int labelLength) {
     // Token
     if (program.type == TOKEN) {
         if (isNumberLike(program)) {
-            aux.step += 1 + toByteArr(program.val, m).size();
+            uint256 v;
+            if (u256FromDecimal(program.val, v))
+                aux.step += 1 + u256ToBytes(v).size();
+            else
+                aux.step += 1 + toByteArr(program.val, m).size();
         }
         else if (program.val[0] == '~') {
-            aux.vars[program.val.substr(1)] = unsignedToDecimal(aux.step);
+            aux.labels[program.val.substr(1)] = aux.step;
         }
         else if (program.val[0] == '$') {
             aux.step += labelLength + 1;
@@ -359,7 +643,7 @@ void buildDict(Node program, programAux &aux, int labelLength) {
         else aux.step += 1;
     }
     // A sub-program (ie. LLL)
-    else if (program.val == "____CODE") {
+    else if (program.val == SYM_CODE) {
         int step = aux.step;
         aux.step = 0;
         for (unsigned i = 0; i < program.args.size(); i++) {
@@ -375,8 +659,15 @@ void buildDict(Node program, programAux &aux, int labelLength) {
     }
 }
 
+// Position of a label, as found by buildDict
+uint256 labelPosition(const programAux &aux, std::string label) {
+    std::map<std::string, int>::const_iterator it = aux.labels.find(label);
+    return uint256(it == aux.labels.end() ? 0 : it->second);
+}
+
 // Applies that dictionary
-void substDict(Node program, programAux aux, int labelLength, std::vector<Node> &out) {
+void substDict(Node program, const programAux &aux, int labelLength,
+               std::vector<Node> &out) {
     Metadata m = program.metadata;
     std::vector<Node> inner;
     if (program.type == TOKEN) {
@@ -384,17 +675,17 @@ void substDict(Node program, programAux aux, int labelLength, std::vector<Node>
             std::string tokStr = "PUSH"+unsignedToDecimal(labelLength);
             out.push_back(token(tokStr, m));
             int dotLoc = program.val.find('.');
+            uint256 pos;
             if (dotLoc == -1) {
-                std::string val = aux.vars[program.val.substr(1)];
-                inner = toByteArr(val, m, labelLength);
+                pos = labelPosition(aux, program.val.substr(1));
             }
             else {
-                std::string start = aux.vars[program.val.substr(1, dotLoc-1)],
-                            end = aux.vars[program.val.substr(dotLoc + 1)],
-                            dist = decimalSub(end, start);
-                inner = toByteArr(dist, m, labelLength);
+                pos = labelPosition(aux, program.val.substr(dotLoc + 1))
+                    - labelPosition(aux, program.val.substr(1, dotLoc-1));
             }
-            for (unsigned i = 0; i < inner.size(); i++) out.push_back(inner[i]);
+            std::vector<uint8_t> bytes = u256ToBytes(pos, labelLength);
+            for (unsigned i = 0; i < bytes.size(); i++)
+                out.push_back(token(unsignedToDecimal(bytes[i]), m));
         }
         else if (program.val[0] == '~') { }
         else if (isNumberLike(program)) {
@@ -413,6 +704,7 @@ void substDict(Node program, programAux aux, int labelLength, std::vector<Node>
 
 // Compiled fragtree -> compiled fragtree without labels
 std::vector<Node> dereference(Node program) {
+    phaseScope phase("dereference", program);
     int sz = treeSize(program) * 33;
     int labelLength = 1;
     while (sz >= 256) { labelLength += 1; sz /= 256; }
@@ -420,11 +712,13 @@ std::vector<Node> dereference(Node program) {
     buildDict(program, aux, labelLength);
     std::vector<Node> o;
     substDict(program, aux, labelLength, o);
+    phase.out(o);
     return o;
 }
 
 // Opcodes -> bin
 std::string serialize(std::vector<Node> codons) {
+    phaseScope phase("serialize", codons);
     std::string o;
     for (unsigned i = 0; i < codons.size(); i++) {
         int v;
@@ -442,6 +736,20 @@ std::string serialize(std::vector<Node> codons) {
     return o;
 }
 
+// Opcodes -> source map
+std::string sourceMap(const std::vector<Node> &codons) {
+    std::string o, prev;
+    for (unsigned i = 0; i < codons.size(); i++) {
+        const Metadata &m = codons[i].metadata;
+        std::string entry = m.file + ":" + unsignedToDecimal(m.ln + 1)
+                          + ":" + unsignedToDecimal(m.ch < 0 ? 0 : m.ch);
+        if (i) o += ";";
+        if (entry != prev) o += entry;
+        prev = entry;
+    }
+    return o;
+}
+
 // Bin -> opcodes
 std::vector<Node> deserialize(std::string ser) {
     std::vector<Node> o;
@@ -13,6 +13,59 @@ std::vector<Node> dereference(Node program);
 // LLL -> fragtree
 Node buildFragmentTree(Node program);
 
+// Stands in a program for a unit compiled on its own (see below)
+Node unitPlaceholder(unsigned index, Metadata m);
+
+// Index of the unit a node stands for, -1 if it is not a placeholder
+int unitPlaceholderIndex(const Node &n);
+
+// Code fragments of program units, by unit and by the stack variables
+// in scope where the unit goes. Units are compiled as if no memory
+// variable had been allocated yet, and their variables are given their
+// real addresses wherever the code is used
+class fragmentCache {
+    public:
+        fragmentCache() {
+            generation = 0;
+            hits = 0;
+            misses = 0;
+        }
+        // Drops the fragments not used since the last sweep
+        void sweep();
+        class entry {
+            public:
+                Node code;
+                int outs;
+                // Memory variables the unit uses, in the order it
+                // allocates them, and the stand-in addresses in the code
+                std::vector<std::pair<std::string, std::string> > vars;
+                bool allocUsed;
+                bool calldataUsed;
+                // The code with the variables at the addresses they were
+                // given last
+                std::string placement;
+                Node placedCode;
+                unsigned generation;
+        };
+        std::map<std::string, entry> fragments;
+        // Whether a unit's code can be moved to other memory, by unit id.
+        // Units with constants that look like stand-in addresses cannot,
+        // and are compiled where they are every time
+        std::map<std::string, bool> movable;
+        unsigned generation;
+        unsigned hits;
+        unsigned misses;
+};
+
+// LLL -> fragtree, where unitPlaceholder(i) nodes stand for units[i].
+// A unit's id must change whenever its LLL does; its code is taken from
+// the cache when it has been compiled with the same stack variables
+// before. With more than one thread, the units that are not cached are
+// compiled concurrently; the result is the same
+Node buildFragmentTree(Node program, const std::vector<Node> &units,
+                       const std::vector<std::string> &unitIds,
+                       fragmentCache &cache, int threads=1);
+
 // opcodes -> bin
 std::string serialize(std::vector<Node> codons);
 
@@ -31,4 +84,8 @@ std::vector<Node> prettyCompileLLL(Node program);
 // bin -> opcodes
 std::vector<Node> deserialize(std::string ser);
 
+// opcodes -> source map: one file:line:char entry per byte of code,
+// separated by semicolons, left empty where it repeats the one before
+std::string sourceMap(const std::vector<Node> &codons);
+
 #endif
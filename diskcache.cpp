@@ -0,0 +1,320 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <limits.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <errno.h>
+#include <utime.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <sys/file.h>
+#include "util.h"
+#include "bignum.h"
+#include "parser.h"
+#include "rewriter.h"
+#include "compiler.h"
+#include "preprocess.h"
+#include "diskcache.h"
+
+// Identifies the compiler's output in cache keys, so that entries made
+// by other builds are not found: a hash of the compiler's sources,
+// written to buildid.cpp by the build
+extern const char *compilerBuild;
+
+// Changes whenever the layout of an entry does
+const char *entryFormat = "serpent-cache 1";
+
+// Entries are spread over this many subdirectories (0-f), each of which
+// is trimmed to its share of the size limit on its own
+const unsigned CACHE_FANOUT = 16;
+
+std::mutex diskCacheLock;
+bool diskCacheConfigured = false;
+std::string diskCacheDir;
+uint64_t diskCacheLimit = 256 * 1024 * 1024;
+
+void configureDiskCache() {
+    if (diskCacheConfigured) return;
+    diskCacheConfigured = true;
+    const char *dir = getenv("SERPENT_CACHE_DIR");
+    if (dir) diskCacheDir = dir;
+    const char *size = getenv("SERPENT_CACHE_SIZE");
+    if (size && atoi(size) > 0)
+        diskCacheLimit = (uint64_t)atoi(size) * 1024 * 1024;
+}
+
+void setDiskCacheDir(std::string dir) {
+    std::lock_guard<std::mutex> l(diskCacheLock);
+    configureDiskCache();
+    while (dir.size() > 1 && dir[dir.size() - 1] == '/')
+        dir = dir.substr(0, dir.size() - 1);
+    diskCacheDir = dir;
+}
+
+void setDiskCacheLimit(uint64_t bytes) {
+    std::lock_guard<std::mutex> l(diskCacheLock);
+    configureDiskCache();
+    diskCacheLimit = bytes;
+}
+
+std::string cacheDir() {
+    std::lock_guard<std::mutex> l(diskCacheLock);
+    configureDiskCache();
+    return diskCacheDir;
+}
+
+uint64_t cacheLimit() {
+    std::lock_guard<std::mutex> l(diskCacheLock);
+    configureDiskCache();
+    return diskCacheLimit;
+}
+
+bool diskCacheEnabled() {
+    return cacheDir().size() > 0;
+}
+
+// Entries are sequences of length-prefixed fields
+void putField(std::string &o, const std::string &s) {
+    o += unsignedToDecimal(s.size()) + ":" + s + "\n";
+}
+
+bool getField(const std::string &in, size_t &pos, std::string &o) {
+    size_t colon = in.find(':', pos);
+    if (colon == std::string::npos || colon == pos) return false;
+    size_t len = 0;
+    for (size_t i = pos; i < colon; i++) {
+        if (in[i] < '0' || in[i] > '9') return false;
+        len = len * 10 + (in[i] - '0');
+    }
+    if (colon + 1 + len + 1 > in.size() || in[colon + 1 + len] != '\n')
+        return false;
+    o = in.substr(colon + 1, len);
+    pos = colon + 1 + len + 1;
+    return true;
+}
+
+// Path of the entry for some serpent code or file. Relative inset and
+// import paths resolve against the working directory, so it is part of
+// the key too
+std::string entryPath(const std::string &dir, const std::string &input) {
+    bool isFile = exists(input);
+    char cwd[PATH_MAX];
+    std::string k;
+    putField(k, entryFormat);
+    putField(k, compilerBuild);
+    // Options: compile() has none that change its output yet
+    putField(k, "compile");
+    putField(k, getcwd(cwd, sizeof(cwd)) ? cwd : "");
+    putField(k, isFile ? input : "main");
+    putField(k, isFile ? get_file_contents(input) : input);
+    std::string key = binToHex(contentHash(k));
+    return dir + "/" + key.substr(0, 1) + "/" + key.substr(1);
+}
+
+std::string encodeEntry(const fileHashes &files, const compiledArtifacts &a) {
+    std::string o;
+    putField(o, entryFormat);
+    putField(o, unsignedToDecimal(files.size()));
+    for (unsigned i = 0; i < files.size(); i++) {
+        putField(o, files[i].first);
+        putField(o, files[i].second);
+    }
+    putField(o, a.code);
+    putField(o, a.hasSignature ? "1" : "0");
+    putField(o, a.signature);
+    putField(o, a.sourceMap);
+    putField(o, a.parseWarnings);
+    putField(o, a.signatureWarnings);
+    putField(o, a.codeWarnings);
+    // A torn or corrupted entry fails this check and is treated as a miss
+    putField(o, contentHash(o));
+    return o;
+}
+
+// Reads an entry, which is only good if it is intact and every file it
+// was compiled from is unchanged
+bool decodeEntry(const std::string &in, compiledArtifacts &a) {
+    size_t pos = 0;
+    std::string format, count, path, hash, sig, check;
+    if (!getField(in, pos, format) || format != entryFormat) return false;
+    if (!getField(in, pos, count)) return false;
+    unsigned n = decimalToUnsigned(count);
+    fileHashes files;
+    for (unsigned i = 0; i < n; i++) {
+        if (!getField(in, pos, path) || !getField(in, pos, hash))
+            return false;
+        files.push_back(std::make_pair(path, hash));
+    }
+    if (!getField(in, pos, a.code) || !getField(in, pos, sig)
+            || !getField(in, pos, a.signature)
+            || !getField(in, pos, a.sourceMap)
+            || !getField(in, pos, a.parseWarnings)
+            || !getField(in, pos, a.signatureWarnings)
+            || !getField(in, pos, a.codeWarnings))
+        return false;
+    size_t end = pos;
+    if (!getField(in, pos, check) || pos != in.size()
+            || check != contentHash(in.substr(0, end)))
+        return false;
+    a.hasSignature = sig == "1";
+    for (unsigned i = 0; i < files.size(); i++) {
+        try {
+            if (contentHash(get_file_contents(files[i].first))
+                    != files[i].second)
+                return false;
+        }
+        catch (...) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool readEntry(const std::string &path, compiledArtifacts &o) {
+    std::string contents;
+    try {
+        contents = get_file_contents(path);
+    }
+    catch (...) {
+        return false;
+    }
+    compiledArtifacts a;
+    if (!decodeEntry(contents, a)) return false;
+    // Eviction goes by modification time, so a hit keeps an entry alive
+    utime(path.c_str(), 0);
+    o = a;
+    return true;
+}
+
+std::atomic<unsigned> tempCounter(0);
+
+// Deletes the least recently used entries of one subdirectory until it
+// is back under its share of the limit. Only one process trims a given
+// subdirectory at a time; the others skip it
+void trimCacheDir(const std::string &sub, uint64_t limit) {
+    std::string lockPath = sub + "/lock";
+    int fd = open(lockPath.c_str(), O_RDWR | O_CREAT, 0666);
+    if (fd < 0) return;
+    if (flock(fd, LOCK_EX | LOCK_NB)) {
+        close(fd);
+        return;
+    }
+    std::vector<std::pair<time_t, std::string> > entries;
+    uint64_t total = 0;
+    time_t now = time(0);
+    DIR *d = opendir(sub.c_str());
+    if (d) {
+        struct dirent *e;
+        while ((e = readdir(d))) {
+            std::string name = e->d_name;
+            if (name == "." || name == ".." || name == "lock") continue;
+            std::string path = sub + "/" + name;
+            struct stat st;
+            if (stat(path.c_str(), &st) || !S_ISREG(st.st_mode)) continue;
+            // Left behind by a process that died while writing
+            if (name.substr(0, 4) == "tmp." && now - st.st_mtime > 3600) {
+                unlink(path.c_str());
+                continue;
+            }
+            entries.push_back(std::make_pair(st.st_mtime, path));
+            total += st.st_size;
+        }
+        closedir(d);
+    }
+    if (total > limit) {
+        std::sort(entries.begin(), entries.end());
+        // Trim a little below the limit, so that the next few stores do
+        // not each have to trim again
+        uint64_t target = limit - limit / 10;
+        for (unsigned i = 0; i < entries.size() && total > target; i++) {
+            struct stat st;
+            if (stat(entries[i].second.c_str(), &st)) continue;
+            if (!unlink(entries[i].second.c_str())) total -= st.st_size;
+        }
+    }
+    flock(fd, LOCK_UN);
+    close(fd);
+}
+
+// Stores an entry. Written to a temporary file and renamed into place,
+// so readers in other processes see either nothing or the whole entry.
+// Failures are ignored: the cache only ever saves work
+void writeEntry(const std::string &path, const fileHashes &files,
+                const compiledArtifacts &a) {
+    std::string dir = path.substr(0, path.rfind("/"));
+    std::string root = dir.substr(0, dir.rfind("/"));
+    mkdir(root.c_str(), 0777);
+    mkdir(dir.c_str(), 0777);
+    std::string temp = dir + "/tmp." + unsignedToDecimal(getpid()) + "."
+        + unsignedToDecimal(std::hash<std::thread::id>()(
+                                std::this_thread::get_id()))
+        + "." + unsignedToDecimal(tempCounter++);
+    std::ofstream out(temp.c_str(), std::ios::out | std::ios::binary);
+    out << encodeEntry(files, a);
+    out.close();
+    if (!out || rename(temp.c_str(), path.c_str())) {
+        unlink(temp.c_str());
+        return;
+    }
+    trimCacheDir(dir, cacheLimit() / CACHE_FANOUT);
+}
+
+bool cachedArtifacts(std::string input, compiledArtifacts &o) {
+    std::string dir = cacheDir();
+    return dir.size() && readEntry(entryPath(dir, input), o);
+}
+
+void reportWarnings(const std::string &warnings) {
+    std::vector<std::string> lines = splitLines(warnings);
+    for (unsigned i = 0; i < lines.size(); i++) {
+        if (lines[i].size()) reportDiagnostic(lines[i]);
+    }
+}
+
+compiledArtifacts compileArtifacts(std::string input) {
+    std::string dir = cacheDir();
+    std::string path = dir.size() ? entryPath(dir, input) : "";
+    compiledArtifacts a;
+    if (path.size() && readEntry(path, a)) return a;
+    compilationScope scope;
+    fileHashes files;
+    std::string *outerSink = diagnosticsSink;
+    std::string *step = &a.parseWarnings;
+    diagnosticsSink = step;
+    try {
+        Node n = parseSerpent(input, files);
+        // Not every contract that compiles has a signature; mkFullSignature
+        // reports the error if it is asked for
+        diagnosticsSink = step = &a.signatureWarnings;
+        try {
+            a.signature = mkFullExtern(n);
+            a.hasSignature = true;
+        }
+        catch (...) {
+            a.signatureWarnings = "";
+        }
+        diagnosticsSink = step = &a.codeWarnings;
+        std::vector<Node> ops = prettyCompileLLL(rewrite(n));
+        a.code = serialize(ops);
+        a.sourceMap = sourceMap(ops);
+    }
+    catch (...) {
+        diagnosticsSink = outerSink;
+        reportWarnings(a.parseWarnings);
+        if (step == &a.codeWarnings) reportWarnings(a.codeWarnings);
+        throw;
+    }
+    diagnosticsSink = outerSink;
+    if (path.size()) writeEntry(path, files, a);
+    return a;
+}
@@ -0,0 +1,57 @@
+#ifndef ETHSERP_DISKCACHE
+#define ETHSERP_DISKCACHE
+
+#include <stdio.h>
+#include <iostream>
+#include <vector>
+#include <string>
+#include <stdint.h>
+#include "util.h"
+
+// Everything compile(), mkFullSignature() and mkContractInfoDecl()
+// produce for one contract
+class compiledArtifacts {
+    public:
+        compiledArtifacts() {
+            hasSignature = false;
+        }
+        std::string code;
+        // Full signature JSON; missing if making it failed
+        bool hasSignature;
+        std::string signature;
+        // See sourceMap in compiler.h
+        std::string sourceMap;
+        // Warnings raised while parsing, making the signature and making
+        // the code, one per line, so that a cache hit reports the same as
+        // the compilation it replaces
+        std::string parseWarnings;
+        std::string signatureWarnings;
+        std::string codeWarnings;
+};
+
+// The on-disk cache is a directory of compiledArtifacts keyed by a hash
+// of the compiler's sources, the options, the working directory and the
+// source, and only reused while every file the source insets, imports or
+// creates still hashes the same. Any number of threads and processes can
+// share one directory. It is off unless a directory is set, here or with
+// the SERPENT_CACHE_DIR environment variable ("" turns it off)
+void setDiskCacheDir(std::string dir);
+
+// Size the cache directory is trimmed back to, least recently used
+// entries first. Defaults to 256 MB, or SERPENT_CACHE_SIZE megabytes
+void setDiskCacheLimit(uint64_t bytes);
+
+bool diskCacheEnabled();
+
+// Serpent code or file -> compiledArtifacts, from the cache if possible
+// (and stored in it otherwise). Warnings are left for the caller to
+// report; errors are reported and thrown as usual
+compiledArtifacts compileArtifacts(std::string input);
+
+// Reports saved warnings as if they had just been raised
+void reportWarnings(const std::string &warnings);
+
+// Cached compiledArtifacts for serpent code or a file, if there are any
+bool cachedArtifacts(std::string input, compiledArtifacts &o);
+
+#endif
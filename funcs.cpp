@@ -10,28 +10,52 @@
 #include "rewriter.h"
 #include "tokenize.h"
 #include "preprocess.h"
+#include "diskcache.h"
+#include "incremental.h"
 
 Node compileToLLL(std::string input) {
+    compilationScope scope;
     return rewrite(parseSerpent(input));
 }
 
 Node compileChunkToLLL(std::string input) {
+    compilationScope scope;
     return rewriteChunk(parseSerpent(input));
 }
 
+std::atomic<int> compileThreads(1);
+
+void setCompileThreads(int n) {
+    compileThreads = n < 1 ? 1 : n;
+}
+
 std::string compile(std::string input) {
+    if (diskCacheEnabled()) {
+        compiledArtifacts a = compileArtifacts(input);
+        reportWarnings(a.parseWarnings + a.codeWarnings);
+        return a.code;
+    }
+    if (compileThreads > 1) {
+        incrementalCompiler c;
+        c.threads = compileThreads;
+        return c.compile(input);
+    }
+    compilationScope scope;
     return compileLLL(compileToLLL(input));
 }
 
 std::vector<Node> prettyCompile(std::string input) {
+    compilationScope scope;
     return prettyCompileLLL(compileToLLL(input));
 }
 
 std::string compileChunk(std::string input) {
+    compilationScope scope;
     return compileLLL(compileChunkToLLL(input));
 }
 
 std::vector<Node> prettyCompileChunk(std::string input) {
+    compilationScope scope;
     return prettyCompileLLL(compileChunkToLLL(input));
 }
 
@@ -40,13 +64,43 @@ std::string mkSignature(std::string input) {
 }
 
 std::string mkFullSignature(std::string input) {
+    // Only worth it if the contract has been compiled already
+    compiledArtifacts a;
+    if (cachedArtifacts(input, a) && a.hasSignature) {
+        reportWarnings(a.parseWarnings + a.signatureWarnings);
+        return a.signature;
+    }
     return mkFullExtern(parseSerpent(input));
 }
 
+std::string mkSourceMap(std::string input) {
+    compiledArtifacts a = compileArtifacts(input);
+    reportWarnings(a.parseWarnings + a.codeWarnings);
+    return a.sourceMap;
+}
+
 std::string mkContractInfoDecl(std::string input) {
-    Node n = parseSerpent(input);
-    std::string s = mkFullExtern(n);
-    std::string c = compileLLL(rewrite(n));
+    compilationScope scope;
+    std::string s, c;
+    if (diskCacheEnabled()) {
+        compiledArtifacts a = compileArtifacts(input);
+        c = a.code;
+        if (a.hasSignature) {
+            reportWarnings(a.parseWarnings + a.signatureWarnings
+                           + a.codeWarnings);
+            s = a.signature;
+        }
+        else {
+            // Making it failed; fail the same way, parse warnings first
+            s = mkFullExtern(parseSerpent(input));
+            reportWarnings(a.codeWarnings);
+        }
+    }
+    else {
+        Node n = parseSerpent(input);
+        s = mkFullExtern(n);
+        c = compileLLL(rewrite(n));
+    }
     return "{\n" 
            "    \"code\": \"0x" + binToHex(c) + "\",\n" 
            "    \"info\": {\n" 
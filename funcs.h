@@ -27,6 +27,11 @@ Node compileToLLL(std::string input);
 
 std::string compile(std::string input);
 
+// Threads compile() rewrites and compiles a contract's functions on
+// (default 1: the contract is compiled as a whole). The code is the same
+// either way
+void setCompileThreads(int n);
+
 std::vector<Node> prettyCompile(std::string input);
 
 std::vector<Node> prettyCompile(std::string input);
@@ -35,6 +40,9 @@ std::string mkSignature(std::string input);
 
 std::string mkFullSignature(std::string input);
 
+// serpent -> source map (see sourceMap in compiler.h)
+std::string mkSourceMap(std::string input);
+
 std::string mkContractInfoDecl(std::string input);
 
 unsigned int getPrefix(std::string signature);
@@ -0,0 +1,196 @@
+#include <stdio.h>
+#include <iostream>
+#include <vector>
+#include <map>
+#include <functional>
+#include "util.h"
+#include "bignum.h"
+#include "parser.h"
+#include "rewriteutils.h"
+#include "preprocess.h"
+#include "rewriter.h"
+#include "compiler.h"
+#include "incremental.h"
+
+// Unambiguous serialization of a tree, without metadata
+void fingerprint(const Node &n, std::string &o) {
+    const std::string &val = n.val;
+    o += (n.type == TOKEN ? "t" : "a") + unsignedToDecimal(val.size())
+       + ":" + val;
+    if (n.type == ASTNODE) {
+        o += unsignedToDecimal(n.args.size()) + "(";
+        for (unsigned i = 0; i < n.args.size(); i++) fingerprint(n.args[i], o);
+        o += ")";
+    }
+}
+
+void fingerprint(const std::string &s, std::string &o) {
+    o += unsignedToDecimal(s.size()) + ":" + s;
+}
+
+void fingerprint(const strvec &v, std::string &o) {
+    o += unsignedToDecimal(v.size()) + "[";
+    for (unsigned i = 0; i < v.size(); i++) fingerprint(v[i], o);
+    o += "]";
+}
+
+void fingerprint(const std::map<std::string, functionMetadata> &m,
+                 std::string &o) {
+    std::map<std::string, functionMetadata>::const_iterator it;
+    o += unsignedToDecimal(m.size()) + "{";
+    for (it = m.begin(); it != m.end(); it++) {
+        const functionMetadata &f = it->second;
+        fingerprint(it->first, o);
+        fingerprint(std::string(f.prefix.begin(), f.prefix.end()), o);
+        fingerprint(f.argTypes, o);
+        fingerprint(f.argNames, o);
+        for (unsigned i = 0; i < f.indexed.size(); i++)
+            o += f.indexed[i] ? "1" : "0";
+        fingerprint(f.outType, o);
+        o += f.ambiguous ? "a" : "-";
+        o += f.constant ? "c" : "-";
+    }
+    o += "}";
+}
+
+// Everything contract-level that rewriting a function can depend on
+std::string auxFingerprint(const preprocessAux &aux) {
+    std::string o;
+    fingerprint(aux.externs, o);
+    fingerprint(aux.interns, o);
+    fingerprint(aux.events, o);
+    std::map<int, rewriteRuleSet>::const_iterator m;
+    for (m = aux.customMacros.begin(); m != aux.customMacros.end(); m++) {
+        o += "m" + unsignedToDecimal(m->first) + "(";
+        std::map<Symbol, std::vector<rewriteRule> >::const_iterator r;
+        for (r = m->second.ruleLists.begin();
+                r != m->second.ruleLists.end(); r++) {
+            for (unsigned i = 0; i < r->second.size(); i++) {
+                fingerprint(r->second[i].pattern, o);
+                fingerprint(r->second[i].substitution, o);
+            }
+        }
+        o += ")";
+    }
+    std::map<std::string, std::string>::const_iterator t;
+    o += "t(";
+    for (t = aux.types.begin(); t != aux.types.end(); t++) {
+        fingerprint(t->first, o);
+        fingerprint(t->second, o);
+    }
+    const svObj &sv = aux.storageVars;
+    o += ")s(";
+    for (t = sv.offsets.begin(); t != sv.offsets.end(); t++) {
+        fingerprint(t->first, o);
+        fingerprint(t->second, o);
+    }
+    std::map<std::string, int>::const_iterator i;
+    for (i = sv.indices.begin(); i != sv.indices.end(); i++) {
+        fingerprint(i->first, o);
+        o += unsignedToDecimal(i->second);
+    }
+    std::map<std::string, std::vector<std::string> >::const_iterator c;
+    for (c = sv.coefficients.begin(); c != sv.coefficients.end(); c++) {
+        fingerprint(c->first, o);
+        fingerprint(c->second, o);
+    }
+    std::map<std::string, bool>::const_iterator n;
+    for (n = sv.nonfinal.begin(); n != sv.nonfinal.end(); n++) {
+        fingerprint(n->first, o);
+        o += n->second ? "1" : "0";
+    }
+    fingerprint(sv.globalOffset, o);
+    o += ")";
+    return o;
+}
+
+// Is this one of the (if (eq (get __funid) prefix) ...) blocks that
+// convFunction makes out of a def?
+bool isFunctionBlock(const Node &n) {
+    if (n.val != "if" || n.args.size() != 2) return false;
+    const Node &cond = n.args[0];
+    return cond.val == "eq" && cond.args.size() == 2
+        && cond.args[0].val == "get" && cond.args[0].args.size() == 1
+        && cond.args[0].args[0].val == "__funid"
+        && cond.args[1].type == TOKEN && isDecimal(cond.args[1].val);
+}
+
+// Takes the function blocks out of a preprocessed contract, leaving
+// placeholders. They sit in the seq under (with __funid ...), which
+// preprocessInit puts in the code block under the contract's top level
+Node splitUnits(Node n, std::vector<Node> &units) {
+    if (n.type != ASTNODE) return n;
+    if (n.val == "with" && n.args.size() == 3 && n.args[0].val == "__funid"
+            && n.args[2].val == "seq") {
+        Node &code = n.args[2];
+        for (unsigned i = 0; i < code.args.size(); i++) {
+            const Node &f = static_cast<const NodeList &>(code.args)[i];
+            if (isFunctionBlock(f)) {
+                units.push_back(f);
+                code.args[i] = unitPlaceholder(units.size() - 1, f.metadata);
+            }
+        }
+        return n;
+    }
+    if (n.val == "seq" || n.val == "~return" || n.val == "lll") {
+        for (unsigned i = 0; i < n.args.size(); i++)
+            n.args[i] = splitUnits(n.args[i], units);
+    }
+    return n;
+}
+
+std::string incrementalCompiler::compile(std::string input) {
+    compilationScope scope;
+    files.clear();
+    preprocessResult pr = preprocess(flattenSeq(parseSerpent(input, files)));
+    std::vector<Node> found;
+    pr.first = splitUnits(pr.first, found);
+    std::string context = contentHash(auxFingerprint(pr.second));
+    std::vector<std::string> ids;
+    std::vector<unsigned> todo;
+    reused = 0;
+    rewritten = 0;
+    for (unsigned i = 0; i < found.size(); i++) {
+        std::string f = context;
+        fingerprint(found[i], f);
+        ids.push_back(binToHex(contentHash(f)));
+        if (units.count(ids[i])) reused++;
+        else todo.push_back(i);
+    }
+    rewritten = todo.size();
+    // The function's temporary names are its own, so that its LLL does
+    // not depend on what was rewritten before it
+    std::vector<Node> done(todo.size());
+    std::function<void(unsigned)> rewriteUnit = [&](unsigned j) {
+        uniqueTokenScope names("f" + ids[todo[j]].substr(0, 12) + "_");
+        done[j] = rewritePreprocessed(preprocessResult(found[todo[j]],
+                                                       pr.second));
+    };
+    if (threads > 1 && todo.size() > 1) {
+        std::vector<jobOutcome> outcomes =
+            runJobs(todo.size(), threads, rewriteUnit);
+        for (unsigned j = 0; j < todo.size(); j++) outcomes[j].replay();
+    }
+    else {
+        for (unsigned j = 0; j < todo.size(); j++) rewriteUnit(j);
+    }
+    for (unsigned j = 0; j < todo.size(); j++)
+        units[ids[todo[j]]].lll = done[j];
+    std::vector<Node> lll;
+    for (unsigned i = 0; i < found.size(); i++) {
+        units[ids[i]].generation = generation;
+        lll.push_back(units[ids[i]].lll);
+    }
+    Node program = rewritePreprocessed(pr);
+    Node fragTree = buildFragmentTree(program, lll, ids, fragments,
+                                      threads);
+    // Only what the latest version of the contract uses is kept
+    std::map<std::string, cachedUnit>::iterator it = units.begin();
+    while (it != units.end()) {
+        if (it->second.generation != generation) units.erase(it++);
+        else it++;
+    }
+    generation++;
+    fragments.sweep();
+    return assemble(fragTree);
+}
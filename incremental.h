@@ -0,0 +1,48 @@
+#ifndef ETHSERP_INCREMENTAL
+#define ETHSERP_INCREMENTAL
+
+#include <stdio.h>
+#include <iostream>
+#include <vector>
+#include <map>
+#include "util.h"
+#include "parser.h"
+#include "compiler.h"
+
+// Compiles a contract over and over as it is edited, redoing only the
+// functions that changed. Each def is rewritten and turned into code
+// fragments on its own, and both results are kept between compilations:
+// the LLL by the function's preprocessed body together with everything
+// contract-level it can see (externs, the other functions' signatures,
+// events, macros, types and the data layout), the fragments by that LLL
+// and the state of the program where the function's code goes. The
+// output is the same as compile()'s
+class incrementalCompiler {
+    public:
+        incrementalCompiler() {
+            generation = 0;
+            reused = 0;
+            rewritten = 0;
+            threads = 1;
+        }
+        // serpent -> EVM code
+        std::string compile(std::string input);
+        // Functions whose LLL was reused and redone by the last compile
+        unsigned reused;
+        unsigned rewritten;
+        // Files read by the last compile
+        fileHashes files;
+        // Threads the functions that changed are rewritten and compiled on
+        int threads;
+        fragmentCache fragments;
+    private:
+        class cachedUnit {
+            public:
+                Node lll;
+                unsigned generation;
+        };
+        std::map<std::string, cachedUnit> units;
+        unsigned generation;
+};
+
+#endif
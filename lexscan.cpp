@@ -0,0 +1,202 @@
+#include <stdio.h>
+#include <iostream>
+#include <atomic>
+#include "util.h"
+#include "tokenize.h"
+#include "lexscan.h"
+
+// The vector kernels are compiled with per-function target attributes, so
+// the rest of the library does not need -msse4.2/-mavx2 and still runs on
+// CPUs without them
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define ETHSERP_LEXSCAN_X86
+#include <immintrin.h>
+#endif
+
+unsigned identScalar(const char *s, unsigned pos, unsigned n) {
+    while (pos < n && charClasses[(unsigned char)s[pos]] == ALPHANUM) pos++;
+    return pos;
+}
+
+unsigned blanksScalar(const char *s, unsigned pos, unsigned n) {
+    while (pos < n && (s[pos] == ' ' || s[pos] == '\t' || s[pos] == '\r'))
+        pos++;
+    return pos;
+}
+
+unsigned stringScalar(const char *s, unsigned pos, unsigned n, char quote) {
+    while (pos < n && s[pos] != quote && s[pos] != '\\' && s[pos] != '\n')
+        pos++;
+    return pos;
+}
+
+#ifdef ETHSERP_LEXSCAN_X86
+
+// SSE4.2: PCMPESTRI finds the first byte in (or, with negative polarity,
+// not in) a set of up to 16 bytes or 8 ranges
+const int ESTRI_RANGES = _SIDD_UBYTE_OPS | _SIDD_CMP_RANGES
+                       | _SIDD_NEGATIVE_POLARITY | _SIDD_LEAST_SIGNIFICANT;
+const int ESTRI_NOT_ANY = _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY
+                        | _SIDD_NEGATIVE_POLARITY | _SIDD_LEAST_SIGNIFICANT;
+const int ESTRI_ANY = _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY
+                    | _SIDD_LEAST_SIGNIFICANT;
+
+__attribute__((target("sse4.2")))
+unsigned identSSE42(const char *s, unsigned pos, unsigned n) {
+    const __m128i ranges = _mm_setr_epi8('0', '9', 'A', 'Z', 'a', 'z',
+                                         '_', '_', '~', '~', '$', '$',
+                                         '@', '@', 0, 0);
+    while (pos + 16 <= n) {
+        __m128i d = _mm_loadu_si128((const __m128i *)(s + pos));
+        int i = _mm_cmpestri(ranges, 14, d, 16, ESTRI_RANGES);
+        if (i < 16) return pos + i;
+        pos += 16;
+    }
+    return identScalar(s, pos, n);
+}
+
+__attribute__((target("sse4.2")))
+unsigned blanksSSE42(const char *s, unsigned pos, unsigned n) {
+    const __m128i set = _mm_setr_epi8(' ', '\t', '\r', 0, 0, 0, 0, 0,
+                                      0, 0, 0, 0, 0, 0, 0, 0);
+    while (pos + 16 <= n) {
+        __m128i d = _mm_loadu_si128((const __m128i *)(s + pos));
+        int i = _mm_cmpestri(set, 3, d, 16, ESTRI_NOT_ANY);
+        if (i < 16) return pos + i;
+        pos += 16;
+    }
+    return blanksScalar(s, pos, n);
+}
+
+__attribute__((target("sse4.2")))
+unsigned stringSSE42(const char *s, unsigned pos, unsigned n, char quote) {
+    const __m128i set = _mm_setr_epi8(quote, '\\', '\n', 0, 0, 0, 0, 0,
+                                      0, 0, 0, 0, 0, 0, 0, 0);
+    while (pos + 16 <= n) {
+        __m128i d = _mm_loadu_si128((const __m128i *)(s + pos));
+        int i = _mm_cmpestri(set, 3, d, 16, ESTRI_ANY);
+        if (i < 16) return pos + i;
+        pos += 16;
+    }
+    return stringScalar(s, pos, n, quote);
+}
+
+// AVX2: classify 32 bytes with compares and take the first set bit of
+// the movemask. Signed compares are fine for the ASCII ranges, as bytes
+// >= 0x80 compare as negative and fall outside all of them
+__attribute__((target("avx2")))
+inline __m256i inRange(__m256i d, char lo, char hi) {
+    return _mm256_and_si256(_mm256_cmpgt_epi8(d, _mm256_set1_epi8(lo - 1)),
+                            _mm256_cmpgt_epi8(_mm256_set1_epi8(hi + 1), d));
+}
+
+__attribute__((target("avx2")))
+inline __m256i isByte(__m256i d, char c) {
+    return _mm256_cmpeq_epi8(d, _mm256_set1_epi8(c));
+}
+
+__attribute__((target("avx2")))
+unsigned identAVX2(const char *s, unsigned pos, unsigned n) {
+    while (pos + 32 <= n) {
+        __m256i d = _mm256_loadu_si256((const __m256i *)(s + pos));
+        // Setting bit 5 folds A-Z onto a-z
+        __m256i lower = _mm256_or_si256(d, _mm256_set1_epi8(0x20));
+        __m256i m = _mm256_or_si256(
+            _mm256_or_si256(inRange(d, '0', '9'), inRange(lower, 'a', 'z')),
+            _mm256_or_si256(
+                _mm256_or_si256(isByte(d, '_'), isByte(d, '~')),
+                _mm256_or_si256(isByte(d, '$'), isByte(d, '@'))));
+        uint32_t stop = ~(uint32_t)_mm256_movemask_epi8(m);
+        if (stop) return pos + __builtin_ctz(stop);
+        pos += 32;
+    }
+    return identScalar(s, pos, n);
+}
+
+__attribute__((target("avx2")))
+unsigned blanksAVX2(const char *s, unsigned pos, unsigned n) {
+    while (pos + 32 <= n) {
+        __m256i d = _mm256_loadu_si256((const __m256i *)(s + pos));
+        __m256i m = _mm256_or_si256(isByte(d, ' '),
+            _mm256_or_si256(isByte(d, '\t'), isByte(d, '\r')));
+        uint32_t stop = ~(uint32_t)_mm256_movemask_epi8(m);
+        if (stop) return pos + __builtin_ctz(stop);
+        pos += 32;
+    }
+    return blanksScalar(s, pos, n);
+}
+
+__attribute__((target("avx2")))
+unsigned stringAVX2(const char *s, unsigned pos, unsigned n, char quote) {
+    while (pos + 32 <= n) {
+        __m256i d = _mm256_loadu_si256((const __m256i *)(s + pos));
+        __m256i m = _mm256_or_si256(isByte(d, quote),
+            _mm256_or_si256(isByte(d, '\\'), isByte(d, '\n')));
+        uint32_t stop = (uint32_t)_mm256_movemask_epi8(m);
+        if (stop) return pos + __builtin_ctz(stop);
+        pos += 32;
+    }
+    return stringScalar(s, pos, n, quote);
+}
+
+#endif
+
+int lexScanSupported() {
+#ifdef ETHSERP_LEXSCAN_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return LEXSCAN_AVX2;
+    if (__builtin_cpu_supports("sse4.2")) return LEXSCAN_SSE42;
+#endif
+    return LEXSCAN_SCALAR;
+}
+
+// -1 until the first scan picks a level
+std::atomic<int> currentLexScanLevel(-1);
+
+int lexScanLevel() {
+    int level = currentLexScanLevel.load(std::memory_order_relaxed);
+    if (level < 0) {
+        // Most runs in real source are shorter than 16 bytes, where the
+        // single PCMPESTRI beats the wider AVX2 compare chain
+        level = lexScanSupported();
+        if (level > LEXSCAN_SSE42) level = LEXSCAN_SSE42;
+        currentLexScanLevel.store(level, std::memory_order_relaxed);
+    }
+    return level;
+}
+
+bool setLexScanLevel(int level) {
+    if (level < LEXSCAN_SCALAR || level > lexScanSupported()) return false;
+    currentLexScanLevel.store(level, std::memory_order_relaxed);
+    return true;
+}
+
+unsigned scanIdentifier(const char *s, unsigned pos, unsigned n) {
+#ifdef ETHSERP_LEXSCAN_X86
+    switch (lexScanLevel()) {
+        case LEXSCAN_AVX2: return identAVX2(s, pos, n);
+        case LEXSCAN_SSE42: return identSSE42(s, pos, n);
+    }
+#endif
+    return identScalar(s, pos, n);
+}
+
+unsigned scanBlanks(const char *s, unsigned pos, unsigned n) {
+#ifdef ETHSERP_LEXSCAN_X86
+    switch (lexScanLevel()) {
+        case LEXSCAN_AVX2: return blanksAVX2(s, pos, n);
+        case LEXSCAN_SSE42: return blanksSSE42(s, pos, n);
+    }
+#endif
+    return blanksScalar(s, pos, n);
+}
+
+unsigned scanString(const char *s, unsigned pos, unsigned n, char quote) {
+#ifdef ETHSERP_LEXSCAN_X86
+    switch (lexScanLevel()) {
+        case LEXSCAN_AVX2: return stringAVX2(s, pos, n, quote);
+        case LEXSCAN_SSE42: return stringSSE42(s, pos, n, quote);
+    }
+#endif
+    return stringScalar(s, pos, n, quote);
+}
@@ -0,0 +1,41 @@
+#ifndef ETHSERP_LEXSCAN
+#define ETHSERP_LEXSCAN
+
+#include <stdio.h>
+#include <iostream>
+#include <vector>
+#include <map>
+
+// Bulk scanning kernels used by the tokenizer. Each one starts at pos and
+// returns the first position before n whose byte ends the run (or n).
+// They may also stop early, eg. at a NUL byte, so callers must treat the
+// result as a lower bound and carry on one byte at a time from there.
+
+// Identifier characters: 0-9 A-Z a-z _ ~ $ @
+unsigned scanIdentifier(const char *s, unsigned pos, unsigned n);
+
+// Blanks other than newline: space, tab, carriage return
+unsigned scanBlanks(const char *s, unsigned pos, unsigned n);
+
+// Inside a string literal: stops at the quote character, a backslash or
+// a newline
+unsigned scanString(const char *s, unsigned pos, unsigned n, char quote);
+
+// Kernel sets: scalar, SSE4.2 (16 bytes at a time) and AVX2 (32 bytes
+// at a time). SSE4.2 is used by default when the CPU has it, as it is
+// the fastest on typical contracts; AVX2 only pays off on long runs
+const int LEXSCAN_SCALAR = 0,
+          LEXSCAN_SSE42 = 1,
+          LEXSCAN_AVX2 = 2;
+
+// Kernel set in use
+int lexScanLevel();
+
+// Highest kernel set the CPU supports
+int lexScanSupported();
+
+// Switches to the given kernel set (for testing and benchmarks); fails
+// if the CPU does not support it
+bool setLexScanLevel(int level);
+
+#endif
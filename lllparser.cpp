@@ -2,60 +2,72 @@
 #include <iostream>
 #include <vector>
 #include <map>
+#include <utility>
 #include "util.h"
 #include "lllparser.h"
 #include "tokenize.h"
 
-struct _parseOutput {
-    Node node;
-    int newpos;
+// A bracket whose closing token has not been seen yet
+struct _parseFrame {
+    Metadata met;
+    Symbol fun;
+    std::vector<Node> args;
 };
 
-// Helper, returns subtree and position of start of next node
-_parseOutput _parse(std::vector<Node> inp, int pos) {
-    Metadata met = inp[pos].metadata;
-    _parseOutput o;
-    // Bracket: keep grabbing tokens until we get to the
-    // corresponding closing bracket
-    if (inp[pos].val == "(" || inp[pos].val == "[") {
-        std::string fun, rbrack;
-        std::vector<Node> args;
-        pos += 1;
-        if (inp[pos].val == "[") {
-            fun = "access";
-            rbrack = "]";
-        }
-        else rbrack = ")";
-        // First argument is the function
-        while (inp[pos].val != ")") {
-            _parseOutput po = _parse(inp, pos);
-            if (fun.length() == 0 && po.node.type == 1) {
-                std::cerr << "Error: first arg must be function\n";
-                fun = po.node.val;
-            }
-            else if (fun.length() == 0) {
-                fun = po.node.val;
-            }
-            else {
-                args.push_back(po.node);
-            }
-            pos = po.newpos;
-        }
-        o.newpos = pos + 1;
-        o.node = astnode(fun, args, met);
+// Adds a finished subtree to the innermost open bracket; the first one
+// becomes the function
+void _addChild(_parseFrame &f, const Node &node) {
+    if (f.fun.empty() && node.type == ASTNODE) {
+        std::cerr << "Error: first arg must be function\n";
+        f.fun = node.val;
+    }
+    else if (f.fun.empty()) {
+        f.fun = node.val;
     }
-    // Normal token, return it and advance to next token
     else {
-        o.newpos = pos + 1;
-        o.node = token(inp[pos].val, met);
+        f.args.push_back(node);
     }
-    return o;
 }
 
 // stream of tokens -> lisp parse tree
-Node parseLLLTokenStream(std::vector<Node> inp) {
-    _parseOutput o = _parse(inp, 0);
-    return o.node;
+//
+// Single pass over the tokens with an explicit stack of open brackets,
+// so the time is linear in the input and deep nesting cannot overflow
+// the call stack. Only the first expression is parsed; anything after
+// it is ignored
+Node parseLLLTokenStream(const std::vector<Node> &inp) {
+    std::vector<_parseFrame> stack;
+    unsigned pos = 0;
+    while (1) {
+        if (pos >= inp.size()) {
+            if (!stack.size()) err("Empty LLL input", Metadata());
+            err("Unclosed bracket", stack.back().met);
+        }
+        const Node &tok = inp[pos];
+        pos += 1;
+        Node done;
+        // Closing bracket: the innermost open bracket is finished (both
+        // kinds are closed by ")")
+        if (tok.val == ")" && stack.size()) {
+            _parseFrame &f = stack.back();
+            done = astnode(f.fun, std::move(f.args), f.met);
+            stack.pop_back();
+        }
+        // Opening bracket: keep grabbing subtrees until we get to the
+        // corresponding closing bracket. A "[" straight after it makes
+        // the node an access
+        else if (tok.val == "(" || tok.val == "[") {
+            stack.push_back(_parseFrame());
+            stack.back().met = tok.metadata;
+            if (pos < inp.size() && inp[pos].val == "[")
+                stack.back().fun = Symbol("access");
+            continue;
+        }
+        // Normal token
+        else done = token(tok.val, tok.metadata);
+        if (!stack.size()) return done;
+        _addChild(stack.back(), done);
+    }
 }
 
 // Parses LLL
@@ -66,5 +78,5 @@ Node parseLLL(std::string s, bool allowFileRead) {
         file = s;
         input = get_file_contents(s);
     }
-    return parseLLLTokenStream(tokenize(s, Metadata(file, 0, 0), true));
+    return parseLLLTokenStream(tokenize(input, Metadata(file, 0, 0), true));
 }
@@ -0,0 +1,404 @@
+#include <string>
+#include "macrosource.h"
+
+// Rewrite rules
+std::string macros[][2] = {
+    {
+        "(seq $x)",
+        "$x"
+    },
+    {
+        "(seq (seq) $x)",
+        "$x"
+    },
+    {
+        "(+= $a $b)",
+        "(set $a (+ $a $b))"
+    },
+    {
+        "(*= $a $b)",
+        "(set $a (* $a $b))"
+    },
+    {
+        "(-= $a $b)",
+        "(set $a (- $a $b))"
+    },
+    {
+        "(/= $a $b)",
+        "(set $a (/ $a $b))"
+    },
+    {
+        "(%= $a $b)",
+        "(set $a (% $a $b))"
+    },
+    {
+        "(^= $a $b)",
+        "(set $a (^ $a $b))"
+    },
+    {
+        "(!= $a $b)",
+        "(iszero (eq $a $b))"
+    },
+    {
+        "(assert $x)",
+        "(jumpi (pc) (iszero $x))"
+    },
+    {
+        "(min $a $b)",
+        "(with $1 $a (with $2 $b (if (slt $1 $2) $1 $2)))"
+    },
+    {
+        "(max $a $b)",
+        "(with $1 $a (with $2 $b (if (slt $1 $2) $2 $1)))"
+    },
+    {
+        "(unsigned_min $a $b)",
+        "(with $1 $a (with $2 $b (if (lt $1 $2) $1 $2)))"
+    },
+    {
+        "(unsigned_max $a $b)",
+        "(with $1 $a (with $2 $b (if (lt $1 $2) $2 $1)))"
+    },
+    {
+        "(if $cond $do (else $else))",
+        "(if $cond $do $else)"
+    },
+    {
+        "(code $code)",
+        "$code"
+    },
+    {
+        "(array $len)",
+        "(with $l $len (with $x (alloc (add 32 (mul 32 $l))) (seq (mstore $x $l) (add $x 32))))"
+    },
+    {
+        "(string $len)",
+        "(with $l $len (with $x (alloc (add 32 $l)) (seq (mstore $x $l) (add $x 32))))"
+    },
+    {
+        "(shrink $arr $sz)",
+        "(mstore (sub $arr 32) $sz)"
+    },
+    {
+        "(slice $arr (= items $start) (= items $end))",  
+        "(with _s $start (with _l (sub $end _s) (with _a (array _l) (seq (mcopy _a (add $arr (mul 32 _s)) (mul 32 _l)) _a))))"
+    },
+    {
+        "(slice $arr (= chars $start) (= chars $end))",  
+        "(with _s $start (with _l (sub $end _s) (with _a (string _l) (seq (mcopy _a (add $arr _s) _l) _a))))"
+    },
+    {
+        "(len $x)",
+        "(mload (sub $x 32))"
+    },
+    {
+        "(ceil32 $x)",
+        "(mul 32 (div (add $x 31) 32))"
+    },
+    {
+        "(while $cond $do)",
+        "(until (iszero $cond) $do)",
+    },
+    {
+        "(while (iszero $cond) $do)",
+        "(until $cond $do)",
+    },
+    {
+        "(if $cond $do)",
+        "(unless (iszero $cond) $do)",
+    },
+    {
+        "(if (iszero $cond) $do)",
+        "(unless $cond $do)",
+    },
+    {
+        "(access (. self storage) $ind)",
+        "(sload $ind)"
+    },
+    {
+        "(access $var $ind)",
+        "(mload (add $var (mul 32 $ind)))"
+    },
+    {
+        "(set (access (. self storage) $ind) $val)",
+        "(sstore $ind $val)"
+    },
+    {
+        "(set (sload $ind) $val)",
+        "(sstore $ind $val)"
+    },
+    {
+        "(set (access $var $ind) $val)",
+        "(mstore (add $var (mul 32 $ind)) $val)"
+    },
+    {
+        "(getch $var $ind)",
+        "(mod (mload (sub (add $var $ind) 31)) 256)"
+    },
+    {
+        "(setch $var $ind $val)",
+        "(mstore8 (add $var $ind) (or (byte 0 $val) (byte 31 $val)))",
+    },
+    {
+        "(send $to $value)",
+        "(~call 0 $to $value 0 0 0 0)"
+    },
+    {
+        "(send $gas $to $value)",
+        "(~call $gas $to $value 0 0 0 0)"
+    },
+    {
+        "(id $0)",
+        "$0"
+    },
+    {
+        "(return (: $x (access $y)))",
+        "(return (: $x arr))"
+    },
+    {
+        "(return (: $x bytes))",
+        "(return (: $x str))"
+    },
+    {
+        "(return (: $x arr))",
+        "(with $0 $x (seq (mstore (sub $0 64) 32) (~return (sub $0 64) (add 64 (= items (mload (sub $0 32)))))))"
+    },
+    {
+        "(return (: $x str))",
+        "(with $0 $x (seq (mstore (sub $0 64) 32) (~return (sub $0 64) (ceil32 (add 64 (= chars (mload (sub $0 32))))))))"
+    },
+    {
+        "(return (: $x $y))",
+        "(return $x)"
+    },
+    {
+        "(return $arr (= $type $sz))",
+        "(with _a $arr (with _size $sz (seq (mstore (sub _a 64) 32) (mstore (sub _a 32) _size) (~return (sub _a 64) (ceil32 (add (= $type _size) 64))))))"
+    },
+    {
+        "(return $arr $sz)",
+        "(error \"when returning you must do return(x) for values, return(x:arr) for arrays or return(x:str) for strings; return(arr, len) by itself is no longer valid. Uses of return(arr, len) should be substituted with return(arr, items=len) or ideally actual arrays.\")"
+    },
+    {
+        "(return $x)",
+        "(seq (set $1 $x) (~return (ref $1) 32))"
+    },
+    {
+        "(&& $x $y)",
+        "(if $x $y 0)"
+    },
+    {
+        "(|| $x $y)",
+        "(with $1 $x (if $1 $1 $y))"
+    },
+    {
+        "(>= $x $y)",
+        "(iszero (slt $x $y))"
+    },
+    {
+        "(<= $x $y)",
+        "(iszero (sgt $x $y))"
+    },
+    {
+        "(create $code)",
+        "(create 0 $code)"
+    },
+    {
+        "(create $endowment $code)",
+        "(with $1 (msize) (create $endowment (get $1) (lll $code (msize))))"
+    },
+    {
+        "(sha3 (: $x arr))",
+        "(with $0 $x (~sha3 $0 (= items (mload (sub $0 32)))))"
+    },
+    {
+        "(sha3 (: $x str))",
+        "(with $0 $x (~sha3 $0 (= chars (mload (sub $0 32)))))"
+    },
+    {
+        "(sha3 $arr (= $type $sz))",
+        "(~sha3 $arr (= $type $sz))"
+    },
+    {
+        "(sha3 $arr $sz)",
+        "(error \"when hashing you must do sha3(x) for values, sha3(arr, items=len) for arrays or sha3(arr, chars=len) for strings; sha3(arr, len) by itself is no longer valid\")"
+    },
+    {
+        "(sha3 $x)",
+        "(seq (set $1 $x) (~sha3 (ref $1) 32))"
+    },
+    {
+        "(sha256 (: $x arr))",
+        "(with $0 $x (_sha256 $0 (= items (mload (sub $0 32)))))"
+    },
+    {
+        "(sha256 (: $x str))",
+        "(with $0 $x (_sha256 $0 (= chars (mload (sub $0 32)))))"
+    },
+    {
+        "(sha256 $arr (= $type $sz))",
+        "(_sha256 $arr (= $type $sz))"
+    },
+    {
+        "(sha256 (: $x str))",
+        "(with $0 $x (_sha256 $0 (= chars (mload (sub $0 32)))))"
+    },
+    {
+        "(sha256 $x)",
+        "(seq (set $1 $x) (_sha256 (ref $1) (= items 1)))",
+    },
+    {
+        "(_sha256 $arr $sz)",
+        "(with $0 $sz (with $1 (alloc 32) (with $gas (add 72 $0) (seq (pop (~call $gas 2 0 $arr $0 (get $1) 32)) (mload (get $1))))))"
+    },
+    {
+        "(sha256 $arr $sz)",
+        "(error \"when hashing you must do sha256(x) for values, sha256(arr, items=len) for arrays or sha256(arr, chars=len) for strings; sha256(arr, len) by itself is no longer valid\")"
+    },
+    {
+        "(ripemd160 (: $x arr))",
+        "(with $0 $x (_ripemd160 $0 (= items (mload (sub $0 32)))))"
+    },
+    {
+        "(ripemd160 (: $x str))",
+        "(with $0 $x (_ripemd160 $0 (= chars (mload (sub $0 32)))))"
+    },
+    {
+        "(ripemd160 $arr (= $type $sz))",
+        "(_ripemd160 $arr (= $type $sz))"
+    },
+    {
+        "(ripemd160 $x)",
+        "(seq (set $1 $x) (_ripemd160 (ref $1) (= items 1)))",
+    },
+    {
+        "(_ripemd160 $arr $sz)",
+        "(with $0 $sz (with $1 (alloc 32) (with $gas (add 720 (mul 4 $0)) (seq (pop (~call $gas 3 0 $arr $0 (get $1) 32)) (mload (get $1))))))"
+    },
+    {
+        "(ripemd160 $arr $sz)",
+        "(error \"when hashing you must do ripemd(x) for values, ripemd160(arr, items=len) for arrays or ripemd160(arr, chars=len) for strings; ripemd160(arr, len) by itself is no longer valid\")"
+    },
+    {
+        "(set chars $x)",
+        "$x",
+    },
+    {
+        "(set items $x)",
+        "(mul $x 32)",
+    },
+    {
+        "(ecrecover $h $v $r $s)",
+        "(with $1 (alloc 160) (seq (mstore (get $1) $h) (mstore (add (get $1) 32) $v) (mstore (add (get $1) 64) $r) (mstore (add (get $1) 96) $s) (pop (~call 3000 1 0 (get $1) 128 (add (get $1) 128) 32)) (mload (add (get $1) 128))))"
+    },
+    {
+        "(inset $x)",
+        "$x"
+    },
+    {
+        "(create $x)",
+        "(with $1 (msize) (create $val (get $1) (lll $code (get $1))))"
+    },
+    {
+        "(with (= $var $val) $cond)",
+        "(with $var $val $cond)"
+    },
+    {
+        "(save $loc (: $array arr))",
+        "(with $0 $array (save $loc $0 (= items (len $0))))"
+    },
+    {
+        "(save $loc (: $string str))",
+        "(with $0 $string (save $loc $0 (= chars (len $0))))"
+    },
+    {
+        "(save $loc $array (= items $count))",
+        "(with $location (ref $loc) (with $end $count (with $i 0 (while (slt $i $end) (seq (sstore (add $i $location) (access $array $i)) (set $i (add $i 1)))))))"
+    },
+    {
+        "(save $loc $array $count)",
+        "(with $location (ref $loc) (with $c $count (with $end (div $c 32) (with $i 0 (seq (while (slt $i $end) (seq (sstore (add $i $location) (access $array $i)) (set $i (add $i 1)))) (sstore (add $i $location) (~and (access $array $i) (sub 0 (exp 256 (sub 32 (mod $c 32)))))))))))"
+    },
+    {
+        "(load $loc (= items $count))",
+        "(with $location (ref $loc) (with $c $count (with $a (array $c) (with $i 0 (seq (while (slt $i $c) (seq (set (access $a $i) (sload (add $location $i))) (set $i (add $i 1)))) $a)))))"
+    },
+    {
+        "(load $loc $count)",
+        "(with $location (ref $loc) (with $c $count (with $a (string $c) (with $i 0 (seq (while (slt $i (div $c 32)) (seq (set (access $a $i) (sload (add $location $i))) (set $i (add $i 1)))) (set (access $a $i) (~and (sload (add $location $i)) (sub 0 (exp 256 (sub 32 (mod $c 32)))))) $a)))))"
+    },
+    {
+        "(safe_call $gas $to $value $datain $datainsz $dataout $dataoutsz)",
+        "(unless (~call $gas $to $value $datain $datainsz $dataout $dataoutsz) (invalid))"
+    },
+    {
+        "(mcopy $to $from $sz)",
+        "(with _sz $sz (with $gas (+ 18 (/ _sz 10)) (safe_call $gas 4 0 $from _sz $to _sz)))"
+    },
+    {
+        "(waste $n)",
+        "(call $n (create (lll (invalid))) 0 0 0 0 0)"
+    },
+    {
+        "(selfdestruct $a)",
+        "(suicide $a)"
+    },
+    {
+        "(~delegatecall $a $b $value $c $d $e $f)",
+        "(~delegatecall $a $b $c $d $e $f)",
+    },
+    { "(. msg sender)", "(caller)" },
+    { "(. msg value)", "(callvalue)" },
+    { "(. msg gas)", "(gas)" },
+    { "(. tx gasprice)", "(gasprice)" },
+    { "(. tx origin)", "(origin)" },
+    { "(. tx gas)", "(error \"Replace tx.gas with msg.gas\")" },
+    { "(. $x balance)", "(balance $x)" },
+    { "self", "(address)" },
+    { "(. block prevhash)", "(blockhash (sub (number) 1))" },
+    { "(fun (. block prevhash) $n)", "(blockhash (sub (number) $n))" },
+    { "(. block coinbase)", "(coinbase)" },
+    { "(. block timestamp)", "(timestamp)" },
+    { "(. block number)", "(number)" },
+    { "(. block difficulty)", "(difficulty)" },
+    { "(. block gaslimit)", "(gaslimit)" },
+    { "stop", "(stop)" },
+    { "---END---", "" } //Keep this line at the end of the list
+};
+
+// Token synonyms
+std::string synonyms[][2] = {
+    { "or", "||" },
+    { "and", "&&" },
+    { "|", "~or" },
+    { "&", "~and" },
+    { "elif", "if" },
+    { "!", "iszero" },
+    { "~", "~not" },
+    { "not", "iszero" },
+    { "+", "add" },
+    { "-", "sub" },
+    { "*", "mul" },
+    { "/", "sdiv" },
+    { "^", "exp" },
+    { "**", "exp" },
+    { "%", "smod" },
+    { "<", "slt" },
+    { ">", "sgt" },
+    { "=", "set" },
+    { "==", "eq" },
+    { ":", "kv" },
+    { "---END---", "" } //Keep this line at the end of the list
+};
+
+// Custom setters (need to be registered separately
+// for use with managed storage)
+std::string setters[][2] = {
+    { "+=", "+" },
+    { "-=", "-" },
+    { "*=", "*" },
+    { "/=", "/" },
+    { "%=", "%" },
+    { "^=", "^" },
+    { "---END---", "" } //Keep this line at the end of the list
+};
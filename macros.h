@@ -0,0 +1,30 @@
+#ifndef ETHSERP_MACROS
+#define ETHSERP_MACROS
+
+// The built-in rewrite rules, parsed ahead of time by mkmacros from the
+// rules as written (macrosource.h)
+
+// One node of a parsed rule, in preorder: a token if args is -1,
+// otherwise a node name followed by that many arguments
+struct macroNode {
+    const char *val;
+    int args;
+    int ln;
+    int ch;
+};
+
+// Where a rule's pattern and substitution start in macroNodes
+struct macroRule {
+    unsigned pattern;
+    unsigned substitution;
+};
+
+extern const macroNode macroNodes[];
+extern const macroRule nodeMacroTable[];
+extern const unsigned nodeMacroCount;
+extern const macroRule setterMacroTable[];
+extern const unsigned setterMacroCount;
+extern const char *const synonymTable[][2];
+extern const unsigned synonymCount;
+
+#endif
@@ -0,0 +1,14 @@
+#ifndef ETHSERP_MACROSOURCE
+#define ETHSERP_MACROSOURCE
+
+#include <string>
+
+// The built-in rewrite rules as written (macros.cpp). Only mkmacros
+// reads these: it parses them and writes them out as the tables of
+// macros.h (macrotables.cpp), so that a compilation does not start by
+// running the LLL parser over every rule. Not part of the library
+extern std::string macros[][2];
+extern std::string synonyms[][2];
+extern std::string setters[][2];
+
+#endif
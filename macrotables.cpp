@@ -0,0 +1,1543 @@
+// Generated by mkmacros from the tables in macros.cpp; do not edit
+#include "macros.h"
+
+constexpr macroNode macroNodes[] = {
+    // (seq $x) -> $x
+    { "seq", 1, 0, 0 },
+    { "$x", -1, 0, 5 },
+    { "$x", -1, 0, 0 },
+    // (seq (seq) $x) -> $x
+    { "seq", 2, 0, 0 },
+    { "seq", 0, 0, 5 },
+    { "$x", -1, 0, 11 },
+    { "$x", -1, 0, 0 },
+    // (+= $a $b) -> (set $a (+ $a $b))
+    { "+=", 2, 0, 0 },
+    { "$a", -1, 0, 4 },
+    { "$b", -1, 0, 7 },
+    { "set", 2, 0, 0 },
+    { "$a", -1, 0, 5 },
+    { "+", 2, 0, 8 },
+    { "$a", -1, 0, 11 },
+    { "$b", -1, 0, 14 },
+    // (*= $a $b) -> (set $a (* $a $b))
+    { "*=", 2, 0, 0 },
+    { "$a", -1, 0, 4 },
+    { "$b", -1, 0, 7 },
+    { "set", 2, 0, 0 },
+    { "$a", -1, 0, 5 },
+    { "*", 2, 0, 8 },
+    { "$a", -1, 0, 11 },
+    { "$b", -1, 0, 14 },
+    // (-= $a $b) -> (set $a (- $a $b))
+    { "-=", 2, 0, 0 },
+    { "$a", -1, 0, 4 },
+    { "$b", -1, 0, 7 },
+    { "set", 2, 0, 0 },
+    { "$a", -1, 0, 5 },
+    { "-", 2, 0, 8 },
+    { "$a", -1, 0, 11 },
+    { "$b", -1, 0, 14 },
+    // (/= $a $b) -> (set $a (/ $a $b))
+    { "/=", 2, 0, 0 },
+    { "$a", -1, 0, 4 },
+    { "$b", -1, 0, 7 },
+    { "set", 2, 0, 0 },
+    { "$a", -1, 0, 5 },
+    { "/", 2, 0, 8 },
+    { "$a", -1, 0, 11 },
+    { "$b", -1, 0, 14 },
+    // (%= $a $b) -> (set $a (% $a $b))
+    { "%=", 2, 0, 0 },
+    { "$a", -1, 0, 4 },
+    { "$b", -1, 0, 7 },
+    { "set", 2, 0, 0 },
+    { "$a", -1, 0, 5 },
+    { "%", 2, 0, 8 },
+    { "$a", -1, 0, 11 },
+    { "$b", -1, 0, 14 },
+    // (^= $a $b) -> (set $a (^ $a $b))
+    { "^=", 2, 0, 0 },
+    { "$a", -1, 0, 4 },
+    { "$b", -1, 0, 7 },
+    { "set", 2, 0, 0 },
+    { "$a", -1, 0, 5 },
+    { "^", 2, 0, 8 },
+    { "$a", -1, 0, 11 },
+    { "$b", -1, 0, 14 },
+    // (!= $a $b) -> (iszero (eq $a $b))
+    { "!=", 2, 0, 0 },
+    { "$a", -1, 0, 4 },
+    { "$b", -1, 0, 7 },
+    { "iszero", 1, 0, 0 },
+    { "eq", 2, 0, 8 },
+    { "$a", -1, 0, 12 },
+    { "$b", -1, 0, 15 },
+    // (assert $x) -> (jumpi (pc) (iszero $x))
+    { "assert", 1, 0, 0 },
+    { "$x", -1, 0, 8 },
+    { "jumpi", 2, 0, 0 },
+    { "pc", 0, 0, 7 },
+    { "iszero", 1, 0, 12 },
+    { "$x", -1, 0, 20 },
+    // (min $a $b) -> (with $1 $a (with $2 $b (if (slt $1 $2) $1 $2)))
+    { "min", 2, 0, 0 },
+    { "$a", -1, 0, 5 },
+    { "$b", -1, 0, 8 },
+    { "with", 3, 0, 0 },
+    { "$1", -1, 0, 6 },
+    { "$a", -1, 0, 9 },
+    { "with", 3, 0, 12 },
+    { "$2", -1, 0, 18 },
+    { "$b", -1, 0, 21 },
+    { "if", 3, 0, 24 },
+    { "slt", 2, 0, 28 },
+    { "$1", -1, 0, 33 },
+    { "$2", -1, 0, 36 },
+    { "$1", -1, 0, 40 },
+    { "$2", -1, 0, 43 },
+    // (max $a $b) -> (with $1 $a (with $2 $b (if (slt $1 $2) $2 $1)))
+    { "max", 2, 0, 0 },
+    { "$a", -1, 0, 5 },
+    { "$b", -1, 0, 8 },
+    { "with", 3, 0, 0 },
+    { "$1", -1, 0, 6 },
+    { "$a", -1, 0, 9 },
+    { "with", 3, 0, 12 },
+    { "$2", -1, 0, 18 },
+    { "$b", -1, 0, 21 },
+    { "if", 3, 0, 24 },
+    { "slt", 2, 0, 28 },
+    { "$1", -1, 0, 33 },
+    { "$2", -1, 0, 36 },
+    { "$2", -1, 0, 40 },
+    { "$1", -1, 0, 43 },
+    // (unsigned_min $a $b) -> (with $1 $a (with $2 $b (if (lt $1 $2) $1 $2)))
+    { "unsigned_min", 2, 0, 0 },
+    { "$a", -1, 0, 14 },
+    { "$b", -1, 0, 17 },
+    { "with", 3, 0, 0 },
+    { "$1", -1, 0, 6 },
+    { "$a", -1, 0, 9 },
+    { "with", 3, 0, 12 },
+    { "$2", -1, 0, 18 },
+    { "$b", -1, 0, 21 },
+    { "if", 3, 0, 24 },
+    { "lt", 2, 0, 28 },
+    { "$1", -1, 0, 32 },
+    { "$2", -1, 0, 35 },
+    { "$1", -1, 0, 39 },
+    { "$2", -1, 0, 42 },
+    // (unsigned_max $a $b) -> (with $1 $a (with $2 $b (if (lt $1 $2) $2 $1)))
+    { "unsigned_max", 2, 0, 0 },
+    { "$a", -1, 0, 14 },
+    { "$b", -1, 0, 17 },
+    { "with", 3, 0, 0 },
+    { "$1", -1, 0, 6 },
+    { "$a", -1, 0, 9 },
+    { "with", 3, 0, 12 },
+    { "$2", -1, 0, 18 },
+    { "$b", -1, 0, 21 },
+    { "if", 3, 0, 24 },
+    { "lt", 2, 0, 28 },
+    { "$1", -1, 0, 32 },
+    { "$2", -1, 0, 35 },
+    { "$2", -1, 0, 39 },
+    { "$1", -1, 0, 42 },
+    // (if $cond $do (else $else)) -> (if $cond $do $else)
+    { "if", 3, 0, 0 },
+    { "$cond", -1, 0, 4 },
+    { "$do", -1, 0, 10 },
+    { "else", 1, 0, 14 },
+    { "$else", -1, 0, 20 },
+    { "if", 3, 0, 0 },
+    { "$cond", -1, 0, 4 },
+    { "$do", -1, 0, 10 },
+    { "$else", -1, 0, 14 },
+    // (code $code) -> $code
+    { "code", 1, 0, 0 },
+    { "$code", -1, 0, 6 },
+    { "$code", -1, 0, 0 },
+    // (array $len) -> (with $l $len (with $x (alloc (add 32 (mul 32 $l))) (seq (mstore $x $l) (add $x 32))))
+    { "array", 1, 0, 0 },
+    { "$len", -1, 0, 7 },
+    { "with", 3, 0, 0 },
+    { "$l", -1, 0, 6 },
+    { "$len", -1, 0, 9 },
+    { "with", 3, 0, 14 },
+    { "$x", -1, 0, 20 },
+    { "alloc", 1, 0, 23 },
+    { "add", 2, 0, 30 },
+    { "32", -1, 0, 35 },
+    { "mul", 2, 0, 38 },
+    { "32", -1, 0, 43 },
+    { "$l", -1, 0, 46 },
+    { "seq", 2, 0, 52 },
+    { "mstore", 2, 0, 57 },
+    { "$x", -1, 0, 65 },
+    { "$l", -1, 0, 68 },
+    { "add", 2, 0, 72 },
+    { "$x", -1, 0, 77 },
+    { "32", -1, 0, 80 },
+    // (string $len) -> (with $l $len (with $x (alloc (add 32 $l)) (seq (mstore $x $l) (add $x 32))))
+    { "string", 1, 0, 0 },
+    { "$len", -1, 0, 8 },
+    { "with", 3, 0, 0 },
+    { "$l", -1, 0, 6 },
+    { "$len", -1, 0, 9 },
+    { "with", 3, 0, 14 },
+    { "$x", -1, 0, 20 },
+    { "alloc", 1, 0, 23 },
+    { "add", 2, 0, 30 },
+    { "32", -1, 0, 35 },
+    { "$l", -1, 0, 38 },
+    { "seq", 2, 0, 43 },
+    { "mstore", 2, 0, 48 },
+    { "$x", -1, 0, 56 },
+    { "$l", -1, 0, 59 },
+    { "add", 2, 0, 63 },
+    { "$x", -1, 0, 68 },
+    { "32", -1, 0, 71 },
+    // (shrink $arr $sz) -> (mstore (sub $arr 32) $sz)
+    { "shrink", 2, 0, 0 },
+    { "$arr", -1, 0, 8 },
+    { "$sz", -1, 0, 13 },
+    { "mstore", 2, 0, 0 },
+    { "sub", 2, 0, 8 },
+    { "$arr", -1, 0, 13 },
+    { "32", -1, 0, 18 },
+    { "$sz", -1, 0, 22 },
+    // (slice $arr (= items $start) (= items $end)) -> (with _s $start (with _l (sub $end _s) (with _a (array _l) (seq (mcopy _a (add $arr (mul 32 _s)) (mul 32 _l)) _a))))
+    { "slice", 3, 0, 0 },
+    { "$arr", -1, 0, 7 },
+    { "=", 2, 0, 12 },
+    { "items", -1, 0, 15 },
+    { "$start", -1, 0, 21 },
+    { "=", 2, 0, 29 },
+    { "items", -1, 0, 32 },
+    { "$end", -1, 0, 38 },
+    { "with", 3, 0, 0 },
+    { "_s", -1, 0, 6 },
+    { "$start", -1, 0, 9 },
+    { "with", 3, 0, 16 },
+    { "_l", -1, 0, 22 },
+    { "sub", 2, 0, 25 },
+    { "$end", -1, 0, 30 },
+    { "_s", -1, 0, 35 },
+    { "with", 3, 0, 39 },
+    { "_a", -1, 0, 45 },
+    { "array", 1, 0, 48 },
+    { "_l", -1, 0, 55 },
+    { "seq", 2, 0, 59 },
+    { "mcopy", 3, 0, 64 },
+    { "_a", -1, 0, 71 },
+    { "add", 2, 0, 74 },
+    { "$arr", -1, 0, 79 },
+    { "mul", 2, 0, 84 },
+    { "32", -1, 0, 89 },
+    { "_s", -1, 0, 92 },
+    { "mul", 2, 0, 97 },
+    { "32", -1, 0, 102 },
+    { "_l", -1, 0, 105 },
+    { "_a", -1, 0, 110 },
+    // (slice $arr (= chars $start) (= chars $end)) -> (with _s $start (with _l (sub $end _s) (with _a (string _l) (seq (mcopy _a (add $arr _s) _l) _a))))
+    { "slice", 3, 0, 0 },
+    { "$arr", -1, 0, 7 },
+    { "=", 2, 0, 12 },
+    { "chars", -1, 0, 15 },
+    { "$start", -1, 0, 21 },
+    { "=", 2, 0, 29 },
+    { "chars", -1, 0, 32 },
+    { "$end", -1, 0, 38 },
+    { "with", 3, 0, 0 },
+    { "_s", -1, 0, 6 },
+    { "$start", -1, 0, 9 },
+    { "with", 3, 0, 16 },
+    { "_l", -1, 0, 22 },
+    { "sub", 2, 0, 25 },
+    { "$end", -1, 0, 30 },
+    { "_s", -1, 0, 35 },
+    { "with", 3, 0, 39 },
+    { "_a", -1, 0, 45 },
+    { "string", 1, 0, 48 },
+    { "_l", -1, 0, 56 },
+    { "seq", 2, 0, 60 },
+    { "mcopy", 3, 0, 65 },
+    { "_a", -1, 0, 72 },
+    { "add", 2, 0, 75 },
+    { "$arr", -1, 0, 80 },
+    { "_s", -1, 0, 85 },
+    { "_l", -1, 0, 89 },
+    { "_a", -1, 0, 93 },
+    // (len $x) -> (mload (sub $x 32))
+    { "len", 1, 0, 0 },
+    { "$x", -1, 0, 5 },
+    { "mload", 1, 0, 0 },
+    { "sub", 2, 0, 7 },
+    { "$x", -1, 0, 12 },
+    { "32", -1, 0, 15 },
+    // (ceil32 $x) -> (mul 32 (div (add $x 31) 32))
+    { "ceil32", 1, 0, 0 },
+    { "$x", -1, 0, 8 },
+    { "mul", 2, 0, 0 },
+    { "32", -1, 0, 5 },
+    { "div", 2, 0, 8 },
+    { "add", 2, 0, 13 },
+    { "$x", -1, 0, 18 },
+    { "31", -1, 0, 21 },
+    { "32", -1, 0, 25 },
+    // (while $cond $do) -> (until (iszero $cond) $do)
+    { "while", 2, 0, 0 },
+    { "$cond", -1, 0, 7 },
+    { "$do", -1, 0, 13 },
+    { "until", 2, 0, 0 },
+    { "iszero", 1, 0, 7 },
+    { "$cond", -1, 0, 15 },
+    { "$do", -1, 0, 22 },
+    // (while (iszero $cond) $do) -> (until $cond $do)
+    { "while", 2, 0, 0 },
+    { "iszero", 1, 0, 7 },
+    { "$cond", -1, 0, 15 },
+    { "$do", -1, 0, 22 },
+    { "until", 2, 0, 0 },
+    { "$cond", -1, 0, 7 },
+    { "$do", -1, 0, 13 },
+    // (if $cond $do) -> (unless (iszero $cond) $do)
+    { "if", 2, 0, 0 },
+    { "$cond", -1, 0, 4 },
+    { "$do", -1, 0, 10 },
+    { "unless", 2, 0, 0 },
+    { "iszero", 1, 0, 8 },
+    { "$cond", -1, 0, 16 },
+    { "$do", -1, 0, 23 },
+    // (if (iszero $cond) $do) -> (unless $cond $do)
+    { "if", 2, 0, 0 },
+    { "iszero", 1, 0, 4 },
+    { "$cond", -1, 0, 12 },
+    { "$do", -1, 0, 19 },
+    { "unless", 2, 0, 0 },
+    { "$cond", -1, 0, 8 },
+    { "$do", -1, 0, 14 },
+    // (access (. self storage) $ind) -> (sload $ind)
+    { "access", 2, 0, 0 },
+    { ".", 2, 0, 8 },
+    { "self", -1, 0, 11 },
+    { "storage", -1, 0, 16 },
+    { "$ind", -1, 0, 25 },
+    { "sload", 1, 0, 0 },
+    { "$ind", -1, 0, 7 },
+    // (access $var $ind) -> (mload (add $var (mul 32 $ind)))
+    { "access", 2, 0, 0 },
+    { "$var", -1, 0, 8 },
+    { "$ind", -1, 0, 13 },
+    { "mload", 1, 0, 0 },
+    { "add", 2, 0, 7 },
+    { "$var", -1, 0, 12 },
+    { "mul", 2, 0, 17 },
+    { "32", -1, 0, 22 },
+    { "$ind", -1, 0, 25 },
+    // (set (access (. self storage) $ind) $val) -> (sstore $ind $val)
+    { "set", 2, 0, 0 },
+    { "access", 2, 0, 5 },
+    { ".", 2, 0, 13 },
+    { "self", -1, 0, 16 },
+    { "storage", -1, 0, 21 },
+    { "$ind", -1, 0, 30 },
+    { "$val", -1, 0, 36 },
+    { "sstore", 2, 0, 0 },
+    { "$ind", -1, 0, 8 },
+    { "$val", -1, 0, 13 },
+    // (set (sload $ind) $val) -> (sstore $ind $val)
+    { "set", 2, 0, 0 },
+    { "sload", 1, 0, 5 },
+    { "$ind", -1, 0, 12 },
+    { "$val", -1, 0, 18 },
+    { "sstore", 2, 0, 0 },
+    { "$ind", -1, 0, 8 },
+    { "$val", -1, 0, 13 },
+    // (set (access $var $ind) $val) -> (mstore (add $var (mul 32 $ind)) $val)
+    { "set", 2, 0, 0 },
+    { "access", 2, 0, 5 },
+    { "$var", -1, 0, 13 },
+    { "$ind", -1, 0, 18 },
+    { "$val", -1, 0, 24 },
+    { "mstore", 2, 0, 0 },
+    { "add", 2, 0, 8 },
+    { "$var", -1, 0, 13 },
+    { "mul", 2, 0, 18 },
+    { "32", -1, 0, 23 },
+    { "$ind", -1, 0, 26 },
+    { "$val", -1, 0, 33 },
+    // (getch $var $ind) -> (mod (mload (sub (add $var $ind) 31)) 256)
+    { "getch", 2, 0, 0 },
+    { "$var", -1, 0, 7 },
+    { "$ind", -1, 0, 12 },
+    { "mod", 2, 0, 0 },
+    { "mload", 1, 0, 5 },
+    { "sub", 2, 0, 12 },
+    { "add", 2, 0, 17 },
+    { "$var", -1, 0, 22 },
+    { "$ind", -1, 0, 27 },
+    { "31", -1, 0, 33 },
+    { "256", -1, 0, 38 },
+    // (setch $var $ind $val) -> (mstore8 (add $var $ind) (or (byte 0 $val) (byte 31 $val)))
+    { "setch", 3, 0, 0 },
+    { "$var", -1, 0, 7 },
+    { "$ind", -1, 0, 12 },
+    { "$val", -1, 0, 17 },
+    { "mstore8", 2, 0, 0 },
+    { "add", 2, 0, 9 },
+    { "$var", -1, 0, 14 },
+    { "$ind", -1, 0, 19 },
+    { "or", 2, 0, 25 },
+    { "byte", 2, 0, 29 },
+    { "0", -1, 0, 35 },
+    { "$val", -1, 0, 37 },
+    { "byte", 2, 0, 43 },
+    { "31", -1, 0, 49 },
+    { "$val", -1, 0, 52 },
+    // (send $to $value) -> (~call 0 $to $value 0 0 0 0)
+    { "send", 2, 0, 0 },
+    { "$to", -1, 0, 6 },
+    { "$value", -1, 0, 10 },
+    { "~call", 7, 0, 0 },
+    { "0", -1, 0, 7 },
+    { "$to", -1, 0, 9 },
+    { "$value", -1, 0, 13 },
+    { "0", -1, 0, 20 },
+    { "0", -1, 0, 22 },
+    { "0", -1, 0, 24 },
+    { "0", -1, 0, 26 },
+    // (send $gas $to $value) -> (~call $gas $to $value 0 0 0 0)
+    { "send", 3, 0, 0 },
+    { "$gas", -1, 0, 6 },
+    { "$to", -1, 0, 11 },
+    { "$value", -1, 0, 15 },
+    { "~call", 7, 0, 0 },
+    { "$gas", -1, 0, 7 },
+    { "$to", -1, 0, 12 },
+    { "$value", -1, 0, 16 },
+    { "0", -1, 0, 23 },
+    { "0", -1, 0, 25 },
+    { "0", -1, 0, 27 },
+    { "0", -1, 0, 29 },
+    // (id $0) -> $0
+    { "id", 1, 0, 0 },
+    { "$0", -1, 0, 4 },
+    { "$0", -1, 0, 0 },
+    // (return (: $x (access $y))) -> (return (: $x arr))
+    { "return", 1, 0, 0 },
+    { ":", 2, 0, 8 },
+    { "$x", -1, 0, 11 },
+    { "access", 1, 0, 14 },
+    { "$y", -1, 0, 22 },
+    { "return", 1, 0, 0 },
+    { ":", 2, 0, 8 },
+    { "$x", -1, 0, 11 },
+    { "arr", -1, 0, 14 },
+    // (return (: $x bytes)) -> (return (: $x str))
+    { "return", 1, 0, 0 },
+    { ":", 2, 0, 8 },
+    { "$x", -1, 0, 11 },
+    { "bytes", -1, 0, 14 },
+    { "return", 1, 0, 0 },
+    { ":", 2, 0, 8 },
+    { "$x", -1, 0, 11 },
+    { "str", -1, 0, 14 },
+    // (return (: $x arr)) -> (with $0 $x (seq (mstore (sub $0 64) 32) (~return (sub $0 64) (add 64 (= items (mload (sub $0 32)))))))
+    { "return", 1, 0, 0 },
+    { ":", 2, 0, 8 },
+    { "$x", -1, 0, 11 },
+    { "arr", -1, 0, 14 },
+    { "with", 3, 0, 0 },
+    { "$0", -1, 0, 6 },
+    { "$x", -1, 0, 9 },
+    { "seq", 2, 0, 12 },
+    { "mstore", 2, 0, 17 },
+    { "sub", 2, 0, 25 },
+    { "$0", -1, 0, 30 },
+    { "64", -1, 0, 33 },
+    { "32", -1, 0, 37 },
+    { "~return", 2, 0, 41 },
+    { "sub", 2, 0, 50 },
+    { "$0", -1, 0, 55 },
+    { "64", -1, 0, 58 },
+    { "add", 2, 0, 62 },
+    { "64", -1, 0, 67 },
+    { "=", 2, 0, 70 },
+    { "items", -1, 0, 73 },
+    { "mload", 1, 0, 79 },
+    { "sub", 2, 0, 86 },
+    { "$0", -1, 0, 91 },
+    { "32", -1, 0, 94 },
+    // (return (: $x str)) -> (with $0 $x (seq (mstore (sub $0 64) 32) (~return (sub $0 64) (ceil32 (add 64 (= chars (mload (sub $0 32))))))))
+    { "return", 1, 0, 0 },
+    { ":", 2, 0, 8 },
+    { "$x", -1, 0, 11 },
+    { "str", -1, 0, 14 },
+    { "with", 3, 0, 0 },
+    { "$0", -1, 0, 6 },
+    { "$x", -1, 0, 9 },
+    { "seq", 2, 0, 12 },
+    { "mstore", 2, 0, 17 },
+    { "sub", 2, 0, 25 },
+    { "$0", -1, 0, 30 },
+    { "64", -1, 0, 33 },
+    { "32", -1, 0, 37 },
+    { "~return", 2, 0, 41 },
+    { "sub", 2, 0, 50 },
+    { "$0", -1, 0, 55 },
+    { "64", -1, 0, 58 },
+    { "ceil32", 1, 0, 62 },
+    { "add", 2, 0, 70 },
+    { "64", -1, 0, 75 },
+    { "=", 2, 0, 78 },
+    { "chars", -1, 0, 81 },
+    { "mload", 1, 0, 87 },
+    { "sub", 2, 0, 94 },
+    { "$0", -1, 0, 99 },
+    { "32", -1, 0, 102 },
+    // (return (: $x $y)) -> (return $x)
+    { "return", 1, 0, 0 },
+    { ":", 2, 0, 8 },
+    { "$x", -1, 0, 11 },
+    { "$y", -1, 0, 14 },
+    { "return", 1, 0, 0 },
+    { "$x", -1, 0, 8 },
+    // (return $arr (= $type $sz)) -> (with _a $arr (with _size $sz (seq (mstore (sub _a 64) 32) (mstore (sub _a 32) _size) (~return (sub _a 64) (ceil32 (add (= $type _size) 64))))))
+    { "return", 2, 0, 0 },
+    { "$arr", -1, 0, 8 },
+    { "=", 2, 0, 13 },
+    { "$type", -1, 0, 16 },
+    { "$sz", -1, 0, 22 },
+    { "with", 3, 0, 0 },
+    { "_a", -1, 0, 6 },
+    { "$arr", -1, 0, 9 },
+    { "with", 3, 0, 14 },
+    { "_size", -1, 0, 20 },
+    { "$sz", -1, 0, 26 },
+    { "seq", 3, 0, 30 },
+    { "mstore", 2, 0, 35 },
+    { "sub", 2, 0, 43 },
+    { "_a", -1, 0, 48 },
+    { "64", -1, 0, 51 },
+    { "32", -1, 0, 55 },
+    { "mstore", 2, 0, 59 },
+    { "sub", 2, 0, 67 },
+    { "_a", -1, 0, 72 },
+    { "32", -1, 0, 75 },
+    { "_size", -1, 0, 79 },
+    { "~return", 2, 0, 86 },
+    { "sub", 2, 0, 95 },
+    { "_a", -1, 0, 100 },
+    { "64", -1, 0, 103 },
+    { "ceil32", 1, 0, 107 },
+    { "add", 2, 0, 115 },
+    { "=", 2, 0, 120 },
+    { "$type", -1, 0, 123 },
+    { "_size", -1, 0, 129 },
+    { "64", -1, 0, 136 },
+    // (return $arr $sz) -> (error "when returning you must do return(x) for values, return(x:arr) for arrays or return(x:str) for strings; return(arr, len) by itself is no longer valid. Uses of return(arr, len) should be substituted with return(arr, items=len) or ideally actual arrays.")
+    { "return", 2, 0, 0 },
+    { "$arr", -1, 0, 8 },
+    { "$sz", -1, 0, 13 },
+    { "error", 1, 0, 0 },
+    { "\"when returning you must do return(x) for values, return(x:arr) for arrays or return(x:str) for strings; return(arr, len) by itself is no longer valid. Uses of return(arr, len) should be substituted with return(arr, items=len) or ideally actual arrays.\"", -1, 0, 7 },
+    // (return $x) -> (seq (set $1 $x) (~return (ref $1) 32))
+    { "return", 1, 0, 0 },
+    { "$x", -1, 0, 8 },
+    { "seq", 2, 0, 0 },
+    { "set", 2, 0, 5 },
+    { "$1", -1, 0, 10 },
+    { "$x", -1, 0, 13 },
+    { "~return", 2, 0, 17 },
+    { "ref", 1, 0, 26 },
+    { "$1", -1, 0, 31 },
+    { "32", -1, 0, 35 },
+    // (&& $x $y) -> (if $x $y 0)
+    { "&&", 2, 0, 0 },
+    { "$x", -1, 0, 4 },
+    { "$y", -1, 0, 7 },
+    { "if", 3, 0, 0 },
+    { "$x", -1, 0, 4 },
+    { "$y", -1, 0, 7 },
+    { "0", -1, 0, 10 },
+    // (|| $x $y) -> (with $1 $x (if $1 $1 $y))
+    { "||", 2, 0, 0 },
+    { "$x", -1, 0, 4 },
+    { "$y", -1, 0, 7 },
+    { "with", 3, 0, 0 },
+    { "$1", -1, 0, 6 },
+    { "$x", -1, 0, 9 },
+    { "if", 3, 0, 12 },
+    { "$1", -1, 0, 16 },
+    { "$1", -1, 0, 19 },
+    { "$y", -1, 0, 22 },
+    // (>= $x $y) -> (iszero (slt $x $y))
+    { ">=", 2, 0, 0 },
+    { "$x", -1, 0, 4 },
+    { "$y", -1, 0, 7 },
+    { "iszero", 1, 0, 0 },
+    { "slt", 2, 0, 8 },
+    { "$x", -1, 0, 13 },
+    { "$y", -1, 0, 16 },
+    // (<= $x $y) -> (iszero (sgt $x $y))
+    { "<=", 2, 0, 0 },
+    { "$x", -1, 0, 4 },
+    { "$y", -1, 0, 7 },
+    { "iszero", 1, 0, 0 },
+    { "sgt", 2, 0, 8 },
+    { "$x", -1, 0, 13 },
+    { "$y", -1, 0, 16 },
+    // (create $code) -> (create 0 $code)
+    { "create", 1, 0, 0 },
+    { "$code", -1, 0, 8 },
+    { "create", 2, 0, 0 },
+    { "0", -1, 0, 8 },
+    { "$code", -1, 0, 10 },
+    // (create $endowment $code) -> (with $1 (msize) (create $endowment (get $1) (lll $code (msize))))
+    { "create", 2, 0, 0 },
+    { "$endowment", -1, 0, 8 },
+    { "$code", -1, 0, 19 },
+    { "with", 3, 0, 0 },
+    { "$1", -1, 0, 6 },
+    { "msize", 0, 0, 9 },
+    { "create", 3, 0, 17 },
+    { "$endowment", -1, 0, 25 },
+    { "get", 1, 0, 36 },
+    { "$1", -1, 0, 41 },
+    { "lll", 2, 0, 45 },
+    { "$code", -1, 0, 50 },
+    { "msize", 0, 0, 56 },
+    // (sha3 (: $x arr)) -> (with $0 $x (~sha3 $0 (= items (mload (sub $0 32)))))
+    { "sha3", 1, 0, 0 },
+    { ":", 2, 0, 6 },
+    { "$x", -1, 0, 9 },
+    { "arr", -1, 0, 12 },
+    { "with", 3, 0, 0 },
+    { "$0", -1, 0, 6 },
+    { "$x", -1, 0, 9 },
+    { "~sha3", 2, 0, 12 },
+    { "$0", -1, 0, 19 },
+    { "=", 2, 0, 22 },
+    { "items", -1, 0, 25 },
+    { "mload", 1, 0, 31 },
+    { "sub", 2, 0, 38 },
+    { "$0", -1, 0, 43 },
+    { "32", -1, 0, 46 },
+    // (sha3 (: $x str)) -> (with $0 $x (~sha3 $0 (= chars (mload (sub $0 32)))))
+    { "sha3", 1, 0, 0 },
+    { ":", 2, 0, 6 },
+    { "$x", -1, 0, 9 },
+    { "str", -1, 0, 12 },
+    { "with", 3, 0, 0 },
+    { "$0", -1, 0, 6 },
+    { "$x", -1, 0, 9 },
+    { "~sha3", 2, 0, 12 },
+    { "$0", -1, 0, 19 },
+    { "=", 2, 0, 22 },
+    { "chars", -1, 0, 25 },
+    { "mload", 1, 0, 31 },
+    { "sub", 2, 0, 38 },
+    { "$0", -1, 0, 43 },
+    { "32", -1, 0, 46 },
+    // (sha3 $arr (= $type $sz)) -> (~sha3 $arr (= $type $sz))
+    { "sha3", 2, 0, 0 },
+    { "$arr", -1, 0, 6 },
+    { "=", 2, 0, 11 },
+    { "$type", -1, 0, 14 },
+    { "$sz", -1, 0, 20 },
+    { "~sha3", 2, 0, 0 },
+    { "$arr", -1, 0, 7 },
+    { "=", 2, 0, 12 },
+    { "$type", -1, 0, 15 },
+    { "$sz", -1, 0, 21 },
+    // (sha3 $arr $sz) -> (error "when hashing you must do sha3(x) for values, sha3(arr, items=len) for arrays or sha3(arr, chars=len) for strings; sha3(arr, len) by itself is no longer valid")
+    { "sha3", 2, 0, 0 },
+    { "$arr", -1, 0, 6 },
+    { "$sz", -1, 0, 11 },
+    { "error", 1, 0, 0 },
+    { "\"when hashing you must do sha3(x) for values, sha3(arr, items=len) for arrays or sha3(arr, chars=len) for strings; sha3(arr, len) by itself is no longer valid\"", -1, 0, 7 },
+    // (sha3 $x) -> (seq (set $1 $x) (~sha3 (ref $1) 32))
+    { "sha3", 1, 0, 0 },
+    { "$x", -1, 0, 6 },
+    { "seq", 2, 0, 0 },
+    { "set", 2, 0, 5 },
+    { "$1", -1, 0, 10 },
+    { "$x", -1, 0, 13 },
+    { "~sha3", 2, 0, 17 },
+    { "ref", 1, 0, 24 },
+    { "$1", -1, 0, 29 },
+    { "32", -1, 0, 33 },
+    // (sha256 (: $x arr)) -> (with $0 $x (_sha256 $0 (= items (mload (sub $0 32)))))
+    { "sha256", 1, 0, 0 },
+    { ":", 2, 0, 8 },
+    { "$x", -1, 0, 11 },
+    { "arr", -1, 0, 14 },
+    { "with", 3, 0, 0 },
+    { "$0", -1, 0, 6 },
+    { "$x", -1, 0, 9 },
+    { "_sha256", 2, 0, 12 },
+    { "$0", -1, 0, 21 },
+    { "=", 2, 0, 24 },
+    { "items", -1, 0, 27 },
+    { "mload", 1, 0, 33 },
+    { "sub", 2, 0, 40 },
+    { "$0", -1, 0, 45 },
+    { "32", -1, 0, 48 },
+    // (sha256 (: $x str)) -> (with $0 $x (_sha256 $0 (= chars (mload (sub $0 32)))))
+    { "sha256", 1, 0, 0 },
+    { ":", 2, 0, 8 },
+    { "$x", -1, 0, 11 },
+    { "str", -1, 0, 14 },
+    { "with", 3, 0, 0 },
+    { "$0", -1, 0, 6 },
+    { "$x", -1, 0, 9 },
+    { "_sha256", 2, 0, 12 },
+    { "$0", -1, 0, 21 },
+    { "=", 2, 0, 24 },
+    { "chars", -1, 0, 27 },
+    { "mload", 1, 0, 33 },
+    { "sub", 2, 0, 40 },
+    { "$0", -1, 0, 45 },
+    { "32", -1, 0, 48 },
+    // (sha256 $arr (= $type $sz)) -> (_sha256 $arr (= $type $sz))
+    { "sha256", 2, 0, 0 },
+    { "$arr", -1, 0, 8 },
+    { "=", 2, 0, 13 },
+    { "$type", -1, 0, 16 },
+    { "$sz", -1, 0, 22 },
+    { "_sha256", 2, 0, 0 },
+    { "$arr", -1, 0, 9 },
+    { "=", 2, 0, 14 },
+    { "$type", -1, 0, 17 },
+    { "$sz", -1, 0, 23 },
+    // (sha256 (: $x str)) -> (with $0 $x (_sha256 $0 (= chars (mload (sub $0 32)))))
+    { "sha256", 1, 0, 0 },
+    { ":", 2, 0, 8 },
+    { "$x", -1, 0, 11 },
+    { "str", -1, 0, 14 },
+    { "with", 3, 0, 0 },
+    { "$0", -1, 0, 6 },
+    { "$x", -1, 0, 9 },
+    { "_sha256", 2, 0, 12 },
+    { "$0", -1, 0, 21 },
+    { "=", 2, 0, 24 },
+    { "chars", -1, 0, 27 },
+    { "mload", 1, 0, 33 },
+    { "sub", 2, 0, 40 },
+    { "$0", -1, 0, 45 },
+    { "32", -1, 0, 48 },
+    // (sha256 $x) -> (seq (set $1 $x) (_sha256 (ref $1) (= items 1)))
+    { "sha256", 1, 0, 0 },
+    { "$x", -1, 0, 8 },
+    { "seq", 2, 0, 0 },
+    { "set", 2, 0, 5 },
+    { "$1", -1, 0, 10 },
+    { "$x", -1, 0, 13 },
+    { "_sha256", 2, 0, 17 },
+    { "ref", 1, 0, 26 },
+    { "$1", -1, 0, 31 },
+    { "=", 2, 0, 35 },
+    { "items", -1, 0, 38 },
+    { "1", -1, 0, 44 },
+    // (_sha256 $arr $sz) -> (with $0 $sz (with $1 (alloc 32) (with $gas (add 72 $0) (seq (pop (~call $gas 2 0 $arr $0 (get $1) 32)) (mload (get $1))))))
+    { "_sha256", 2, 0, 0 },
+    { "$arr", -1, 0, 9 },
+    { "$sz", -1, 0, 14 },
+    { "with", 3, 0, 0 },
+    { "$0", -1, 0, 6 },
+    { "$sz", -1, 0, 9 },
+    { "with", 3, 0, 13 },
+    { "$1", -1, 0, 19 },
+    { "alloc", 1, 0, 22 },
+    { "32", -1, 0, 29 },
+    { "with", 3, 0, 33 },
+    { "$gas", -1, 0, 39 },
+    { "add", 2, 0, 44 },
+    { "72", -1, 0, 49 },
+    { "$0", -1, 0, 52 },
+    { "seq", 2, 0, 56 },
+    { "pop", 1, 0, 61 },
+    { "~call", 7, 0, 66 },
+    { "$gas", -1, 0, 73 },
+    { "2", -1, 0, 78 },
+    { "0", -1, 0, 80 },
+    { "$arr", -1, 0, 82 },
+    { "$0", -1, 0, 87 },
+    { "get", 1, 0, 90 },
+    { "$1", -1, 0, 95 },
+    { "32", -1, 0, 99 },
+    { "mload", 1, 0, 104 },
+    { "get", 1, 0, 111 },
+    { "$1", -1, 0, 116 },
+    // (sha256 $arr $sz) -> (error "when hashing you must do sha256(x) for values, sha256(arr, items=len) for arrays or sha256(arr, chars=len) for strings; sha256(arr, len) by itself is no longer valid")
+    { "sha256", 2, 0, 0 },
+    { "$arr", -1, 0, 8 },
+    { "$sz", -1, 0, 13 },
+    { "error", 1, 0, 0 },
+    { "\"when hashing you must do sha256(x) for values, sha256(arr, items=len) for arrays or sha256(arr, chars=len) for strings; sha256(arr, len) by itself is no longer valid\"", -1, 0, 7 },
+    // (ripemd160 (: $x arr)) -> (with $0 $x (_ripemd160 $0 (= items (mload (sub $0 32)))))
+    { "ripemd160", 1, 0, 0 },
+    { ":", 2, 0, 11 },
+    { "$x", -1, 0, 14 },
+    { "arr", -1, 0, 17 },
+    { "with", 3, 0, 0 },
+    { "$0", -1, 0, 6 },
+    { "$x", -1, 0, 9 },
+    { "_ripemd160", 2, 0, 12 },
+    { "$0", -1, 0, 24 },
+    { "=", 2, 0, 27 },
+    { "items", -1, 0, 30 },
+    { "mload", 1, 0, 36 },
+    { "sub", 2, 0, 43 },
+    { "$0", -1, 0, 48 },
+    { "32", -1, 0, 51 },
+    // (ripemd160 (: $x str)) -> (with $0 $x (_ripemd160 $0 (= chars (mload (sub $0 32)))))
+    { "ripemd160", 1, 0, 0 },
+    { ":", 2, 0, 11 },
+    { "$x", -1, 0, 14 },
+    { "str", -1, 0, 17 },
+    { "with", 3, 0, 0 },
+    { "$0", -1, 0, 6 },
+    { "$x", -1, 0, 9 },
+    { "_ripemd160", 2, 0, 12 },
+    { "$0", -1, 0, 24 },
+    { "=", 2, 0, 27 },
+    { "chars", -1, 0, 30 },
+    { "mload", 1, 0, 36 },
+    { "sub", 2, 0, 43 },
+    { "$0", -1, 0, 48 },
+    { "32", -1, 0, 51 },
+    // (ripemd160 $arr (= $type $sz)) -> (_ripemd160 $arr (= $type $sz))
+    { "ripemd160", 2, 0, 0 },
+    { "$arr", -1, 0, 11 },
+    { "=", 2, 0, 16 },
+    { "$type", -1, 0, 19 },
+    { "$sz", -1, 0, 25 },
+    { "_ripemd160", 2, 0, 0 },
+    { "$arr", -1, 0, 12 },
+    { "=", 2, 0, 17 },
+    { "$type", -1, 0, 20 },
+    { "$sz", -1, 0, 26 },
+    // (ripemd160 $x) -> (seq (set $1 $x) (_ripemd160 (ref $1) (= items 1)))
+    { "ripemd160", 1, 0, 0 },
+    { "$x", -1, 0, 11 },
+    { "seq", 2, 0, 0 },
+    { "set", 2, 0, 5 },
+    { "$1", -1, 0, 10 },
+    { "$x", -1, 0, 13 },
+    { "_ripemd160", 2, 0, 17 },
+    { "ref", 1, 0, 29 },
+    { "$1", -1, 0, 34 },
+    { "=", 2, 0, 38 },
+    { "items", -1, 0, 41 },
+    { "1", -1, 0, 47 },
+    // (_ripemd160 $arr $sz) -> (with $0 $sz (with $1 (alloc 32) (with $gas (add 720 (mul 4 $0)) (seq (pop (~call $gas 3 0 $arr $0 (get $1) 32)) (mload (get $1))))))
+    { "_ripemd160", 2, 0, 0 },
+    { "$arr", -1, 0, 12 },
+    { "$sz", -1, 0, 17 },
+    { "with", 3, 0, 0 },
+    { "$0", -1, 0, 6 },
+    { "$sz", -1, 0, 9 },
+    { "with", 3, 0, 13 },
+    { "$1", -1, 0, 19 },
+    { "alloc", 1, 0, 22 },
+    { "32", -1, 0, 29 },
+    { "with", 3, 0, 33 },
+    { "$gas", -1, 0, 39 },
+    { "add", 2, 0, 44 },
+    { "720", -1, 0, 49 },
+    { "mul", 2, 0, 53 },
+    { "4", -1, 0, 58 },
+    { "$0", -1, 0, 60 },
+    { "seq", 2, 0, 65 },
+    { "pop", 1, 0, 70 },
+    { "~call", 7, 0, 75 },
+    { "$gas", -1, 0, 82 },
+    { "3", -1, 0, 87 },
+    { "0", -1, 0, 89 },
+    { "$arr", -1, 0, 91 },
+    { "$0", -1, 0, 96 },
+    { "get", 1, 0, 99 },
+    { "$1", -1, 0, 104 },
+    { "32", -1, 0, 108 },
+    { "mload", 1, 0, 113 },
+    { "get", 1, 0, 120 },
+    { "$1", -1, 0, 125 },
+    // (ripemd160 $arr $sz) -> (error "when hashing you must do ripemd(x) for values, ripemd160(arr, items=len) for arrays or ripemd160(arr, chars=len) for strings; ripemd160(arr, len) by itself is no longer valid")
+    { "ripemd160", 2, 0, 0 },
+    { "$arr", -1, 0, 11 },
+    { "$sz", -1, 0, 16 },
+    { "error", 1, 0, 0 },
+    { "\"when hashing you must do ripemd(x) for values, ripemd160(arr, items=len) for arrays or ripemd160(arr, chars=len) for strings; ripemd160(arr, len) by itself is no longer valid\"", -1, 0, 7 },
+    // (set chars $x) -> $x
+    { "set", 2, 0, 0 },
+    { "chars", -1, 0, 5 },
+    { "$x", -1, 0, 11 },
+    { "$x", -1, 0, 0 },
+    // (set items $x) -> (mul $x 32)
+    { "set", 2, 0, 0 },
+    { "items", -1, 0, 5 },
+    { "$x", -1, 0, 11 },
+    { "mul", 2, 0, 0 },
+    { "$x", -1, 0, 5 },
+    { "32", -1, 0, 8 },
+    // (ecrecover $h $v $r $s) -> (with $1 (alloc 160) (seq (mstore (get $1) $h) (mstore (add (get $1) 32) $v) (mstore (add (get $1) 64) $r) (mstore (add (get $1) 96) $s) (pop (~call 3000 1 0 (get $1) 128 (add (get $1) 128) 32)) (mload (add (get $1) 128))))
+    { "ecrecover", 4, 0, 0 },
+    { "$h", -1, 0, 11 },
+    { "$v", -1, 0, 14 },
+    { "$r", -1, 0, 17 },
+    { "$s", -1, 0, 20 },
+    { "with", 3, 0, 0 },
+    { "$1", -1, 0, 6 },
+    { "alloc", 1, 0, 9 },
+    { "160", -1, 0, 16 },
+    { "seq", 6, 0, 21 },
+    { "mstore", 2, 0, 26 },
+    { "get", 1, 0, 34 },
+    { "$1", -1, 0, 39 },
+    { "$h", -1, 0, 43 },
+    { "mstore", 2, 0, 47 },
+    { "add", 2, 0, 55 },
+    { "get", 1, 0, 60 },
+    { "$1", -1, 0, 65 },
+    { "32", -1, 0, 69 },
+    { "$v", -1, 0, 73 },
+    { "mstore", 2, 0, 77 },
+    { "add", 2, 0, 85 },
+    { "get", 1, 0, 90 },
+    { "$1", -1, 0, 95 },
+    { "64", -1, 0, 99 },
+    { "$r", -1, 0, 103 },
+    { "mstore", 2, 0, 107 },
+    { "add", 2, 0, 115 },
+    { "get", 1, 0, 120 },
+    { "$1", -1, 0, 125 },
+    { "96", -1, 0, 129 },
+    { "$s", -1, 0, 133 },
+    { "pop", 1, 0, 137 },
+    { "~call", 7, 0, 142 },
+    { "3000", -1, 0, 149 },
+    { "1", -1, 0, 154 },
+    { "0", -1, 0, 156 },
+    { "get", 1, 0, 158 },
+    { "$1", -1, 0, 163 },
+    { "128", -1, 0, 167 },
+    { "add", 2, 0, 171 },
+    { "get", 1, 0, 176 },
+    { "$1", -1, 0, 181 },
+    { "128", -1, 0, 185 },
+    { "32", -1, 0, 190 },
+    { "mload", 1, 0, 195 },
+    { "add", 2, 0, 202 },
+    { "get", 1, 0, 207 },
+    { "$1", -1, 0, 212 },
+    { "128", -1, 0, 216 },
+    // (inset $x) -> $x
+    { "inset", 1, 0, 0 },
+    { "$x", -1, 0, 7 },
+    { "$x", -1, 0, 0 },
+    // (create $x) -> (with $1 (msize) (create $val (get $1) (lll $code (get $1))))
+    { "create", 1, 0, 0 },
+    { "$x", -1, 0, 8 },
+    { "with", 3, 0, 0 },
+    { "$1", -1, 0, 6 },
+    { "msize", 0, 0, 9 },
+    { "create", 3, 0, 17 },
+    { "$val", -1, 0, 25 },
+    { "get", 1, 0, 30 },
+    { "$1", -1, 0, 35 },
+    { "lll", 2, 0, 39 },
+    { "$code", -1, 0, 44 },
+    { "get", 1, 0, 50 },
+    { "$1", -1, 0, 55 },
+    // (with (= $var $val) $cond) -> (with $var $val $cond)
+    { "with", 2, 0, 0 },
+    { "=", 2, 0, 6 },
+    { "$var", -1, 0, 9 },
+    { "$val", -1, 0, 14 },
+    { "$cond", -1, 0, 20 },
+    { "with", 3, 0, 0 },
+    { "$var", -1, 0, 6 },
+    { "$val", -1, 0, 11 },
+    { "$cond", -1, 0, 16 },
+    // (save $loc (: $array arr)) -> (with $0 $array (save $loc $0 (= items (len $0))))
+    { "save", 2, 0, 0 },
+    { "$loc", -1, 0, 6 },
+    { ":", 2, 0, 11 },
+    { "$array", -1, 0, 14 },
+    { "arr", -1, 0, 21 },
+    { "with", 3, 0, 0 },
+    { "$0", -1, 0, 6 },
+    { "$array", -1, 0, 9 },
+    { "save", 3, 0, 16 },
+    { "$loc", -1, 0, 22 },
+    { "$0", -1, 0, 27 },
+    { "=", 2, 0, 30 },
+    { "items", -1, 0, 33 },
+    { "len", 1, 0, 39 },
+    { "$0", -1, 0, 44 },
+    // (save $loc (: $string str)) -> (with $0 $string (save $loc $0 (= chars (len $0))))
+    { "save", 2, 0, 0 },
+    { "$loc", -1, 0, 6 },
+    { ":", 2, 0, 11 },
+    { "$string", -1, 0, 14 },
+    { "str", -1, 0, 22 },
+    { "with", 3, 0, 0 },
+    { "$0", -1, 0, 6 },
+    { "$string", -1, 0, 9 },
+    { "save", 3, 0, 17 },
+    { "$loc", -1, 0, 23 },
+    { "$0", -1, 0, 28 },
+    { "=", 2, 0, 31 },
+    { "chars", -1, 0, 34 },
+    { "len", 1, 0, 40 },
+    { "$0", -1, 0, 45 },
+    // (save $loc $array (= items $count)) -> (with $location (ref $loc) (with $end $count (with $i 0 (while (slt $i $end) (seq (sstore (add $i $location) (access $array $i)) (set $i (add $i 1)))))))
+    { "save", 3, 0, 0 },
+    { "$loc", -1, 0, 6 },
+    { "$array", -1, 0, 11 },
+    { "=", 2, 0, 18 },
+    { "items", -1, 0, 21 },
+    { "$count", -1, 0, 27 },
+    { "with", 3, 0, 0 },
+    { "$location", -1, 0, 6 },
+    { "ref", 1, 0, 16 },
+    { "$loc", -1, 0, 21 },
+    { "with", 3, 0, 27 },
+    { "$end", -1, 0, 33 },
+    { "$count", -1, 0, 38 },
+    { "with", 3, 0, 45 },
+    { "$i", -1, 0, 51 },
+    { "0", -1, 0, 54 },
+    { "while", 2, 0, 56 },
+    { "slt", 2, 0, 63 },
+    { "$i", -1, 0, 68 },
+    { "$end", -1, 0, 71 },
+    { "seq", 2, 0, 77 },
+    { "sstore", 2, 0, 82 },
+    { "add", 2, 0, 90 },
+    { "$i", -1, 0, 95 },
+    { "$location", -1, 0, 98 },
+    { "access", 2, 0, 109 },
+    { "$array", -1, 0, 117 },
+    { "$i", -1, 0, 124 },
+    { "set", 2, 0, 129 },
+    { "$i", -1, 0, 134 },
+    { "add", 2, 0, 137 },
+    { "$i", -1, 0, 142 },
+    { "1", -1, 0, 145 },
+    // (save $loc $array $count) -> (with $location (ref $loc) (with $c $count (with $end (div $c 32) (with $i 0 (seq (while (slt $i $end) (seq (sstore (add $i $location) (access $array $i)) (set $i (add $i 1)))) (sstore (add $i $location) (~and (access $array $i) (sub 0 (exp 256 (sub 32 (mod $c 32)))))))))))
+    { "save", 3, 0, 0 },
+    { "$loc", -1, 0, 6 },
+    { "$array", -1, 0, 11 },
+    { "$count", -1, 0, 18 },
+    { "with", 3, 0, 0 },
+    { "$location", -1, 0, 6 },
+    { "ref", 1, 0, 16 },
+    { "$loc", -1, 0, 21 },
+    { "with", 3, 0, 27 },
+    { "$c", -1, 0, 33 },
+    { "$count", -1, 0, 36 },
+    { "with", 3, 0, 43 },
+    { "$end", -1, 0, 49 },
+    { "div", 2, 0, 54 },
+    { "$c", -1, 0, 59 },
+    { "32", -1, 0, 62 },
+    { "with", 3, 0, 66 },
+    { "$i", -1, 0, 72 },
+    { "0", -1, 0, 75 },
+    { "seq", 2, 0, 77 },
+    { "while", 2, 0, 82 },
+    { "slt", 2, 0, 89 },
+    { "$i", -1, 0, 94 },
+    { "$end", -1, 0, 97 },
+    { "seq", 2, 0, 103 },
+    { "sstore", 2, 0, 108 },
+    { "add", 2, 0, 116 },
+    { "$i", -1, 0, 121 },
+    { "$location", -1, 0, 124 },
+    { "access", 2, 0, 135 },
+    { "$array", -1, 0, 143 },
+    { "$i", -1, 0, 150 },
+    { "set", 2, 0, 155 },
+    { "$i", -1, 0, 160 },
+    { "add", 2, 0, 163 },
+    { "$i", -1, 0, 168 },
+    { "1", -1, 0, 171 },
+    { "sstore", 2, 0, 177 },
+    { "add", 2, 0, 185 },
+    { "$i", -1, 0, 190 },
+    { "$location", -1, 0, 193 },
+    { "~and", 2, 0, 204 },
+    { "access", 2, 0, 210 },
+    { "$array", -1, 0, 218 },
+    { "$i", -1, 0, 225 },
+    { "sub", 2, 0, 229 },
+    { "0", -1, 0, 234 },
+    { "exp", 2, 0, 236 },
+    { "256", -1, 0, 241 },
+    { "sub", 2, 0, 245 },
+    { "32", -1, 0, 250 },
+    { "mod", 2, 0, 253 },
+    { "$c", -1, 0, 258 },
+    { "32", -1, 0, 261 },
+    // (load $loc (= items $count)) -> (with $location (ref $loc) (with $c $count (with $a (array $c) (with $i 0 (seq (while (slt $i $c) (seq (set (access $a $i) (sload (add $location $i))) (set $i (add $i 1)))) $a)))))
+    { "load", 2, 0, 0 },
+    { "$loc", -1, 0, 6 },
+    { "=", 2, 0, 11 },
+    { "items", -1, 0, 14 },
+    { "$count", -1, 0, 20 },
+    { "with", 3, 0, 0 },
+    { "$location", -1, 0, 6 },
+    { "ref", 1, 0, 16 },
+    { "$loc", -1, 0, 21 },
+    { "with", 3, 0, 27 },
+    { "$c", -1, 0, 33 },
+    { "$count", -1, 0, 36 },
+    { "with", 3, 0, 43 },
+    { "$a", -1, 0, 49 },
+    { "array", 1, 0, 52 },
+    { "$c", -1, 0, 59 },
+    { "with", 3, 0, 63 },
+    { "$i", -1, 0, 69 },
+    { "0", -1, 0, 72 },
+    { "seq", 2, 0, 74 },
+    { "while", 2, 0, 79 },
+    { "slt", 2, 0, 86 },
+    { "$i", -1, 0, 91 },
+    { "$c", -1, 0, 94 },
+    { "seq", 2, 0, 98 },
+    { "set", 2, 0, 103 },
+    { "access", 2, 0, 108 },
+    { "$a", -1, 0, 116 },
+    { "$i", -1, 0, 119 },
+    { "sload", 1, 0, 123 },
+    { "add", 2, 0, 130 },
+    { "$location", -1, 0, 135 },
+    { "$i", -1, 0, 145 },
+    { "set", 2, 0, 151 },
+    { "$i", -1, 0, 156 },
+    { "add", 2, 0, 159 },
+    { "$i", -1, 0, 164 },
+    { "1", -1, 0, 167 },
+    { "$a", -1, 0, 173 },
+    // (load $loc $count) -> (with $location (ref $loc) (with $c $count (with $a (string $c) (with $i 0 (seq (while (slt $i (div $c 32)) (seq (set (access $a $i) (sload (add $location $i))) (set $i (add $i 1)))) (set (access $a $i) (~and (sload (add $location $i)) (sub 0 (exp 256 (sub 32 (mod $c 32)))))) $a)))))
+    { "load", 2, 0, 0 },
+    { "$loc", -1, 0, 6 },
+    { "$count", -1, 0, 11 },
+    { "with", 3, 0, 0 },
+    { "$location", -1, 0, 6 },
+    { "ref", 1, 0, 16 },
+    { "$loc", -1, 0, 21 },
+    { "with", 3, 0, 27 },
+    { "$c", -1, 0, 33 },
+    { "$count", -1, 0, 36 },
+    { "with", 3, 0, 43 },
+    { "$a", -1, 0, 49 },
+    { "string", 1, 0, 52 },
+    { "$c", -1, 0, 60 },
+    { "with", 3, 0, 64 },
+    { "$i", -1, 0, 70 },
+    { "0", -1, 0, 73 },
+    { "seq", 3, 0, 75 },
+    { "while", 2, 0, 80 },
+    { "slt", 2, 0, 87 },
+    { "$i", -1, 0, 92 },
+    { "div", 2, 0, 95 },
+    { "$c", -1, 0, 100 },
+    { "32", -1, 0, 103 },
+    { "seq", 2, 0, 108 },
+    { "set", 2, 0, 113 },
+    { "access", 2, 0, 118 },
+    { "$a", -1, 0, 126 },
+    { "$i", -1, 0, 129 },
+    { "sload", 1, 0, 133 },
+    { "add", 2, 0, 140 },
+    { "$location", -1, 0, 145 },
+    { "$i", -1, 0, 155 },
+    { "set", 2, 0, 161 },
+    { "$i", -1, 0, 166 },
+    { "add", 2, 0, 169 },
+    { "$i", -1, 0, 174 },
+    { "1", -1, 0, 177 },
+    { "set", 2, 0, 183 },
+    { "access", 2, 0, 188 },
+    { "$a", -1, 0, 196 },
+    { "$i", -1, 0, 199 },
+    { "~and", 2, 0, 203 },
+    { "sload", 1, 0, 209 },
+    { "add", 2, 0, 216 },
+    { "$location", -1, 0, 221 },
+    { "$i", -1, 0, 231 },
+    { "sub", 2, 0, 236 },
+    { "0", -1, 0, 241 },
+    { "exp", 2, 0, 243 },
+    { "256", -1, 0, 248 },
+    { "sub", 2, 0, 252 },
+    { "32", -1, 0, 257 },
+    { "mod", 2, 0, 260 },
+    { "$c", -1, 0, 265 },
+    { "32", -1, 0, 268 },
+    { "$a", -1, 0, 277 },
+    // (safe_call $gas $to $value $datain $datainsz $dataout $dataoutsz) -> (unless (~call $gas $to $value $datain $datainsz $dataout $dataoutsz) (invalid))
+    { "safe_call", 7, 0, 0 },
+    { "$gas", -1, 0, 11 },
+    { "$to", -1, 0, 16 },
+    { "$value", -1, 0, 20 },
+    { "$datain", -1, 0, 27 },
+    { "$datainsz", -1, 0, 35 },
+    { "$dataout", -1, 0, 45 },
+    { "$dataoutsz", -1, 0, 54 },
+    { "unless", 2, 0, 0 },
+    { "~call", 7, 0, 8 },
+    { "$gas", -1, 0, 15 },
+    { "$to", -1, 0, 20 },
+    { "$value", -1, 0, 24 },
+    { "$datain", -1, 0, 31 },
+    { "$datainsz", -1, 0, 39 },
+    { "$dataout", -1, 0, 49 },
+    { "$dataoutsz", -1, 0, 58 },
+    { "invalid", 0, 0, 70 },
+    // (mcopy $to $from $sz) -> (with _sz $sz (with $gas (+ 18 (/ _sz 10)) (safe_call $gas 4 0 $from _sz $to _sz)))
+    { "mcopy", 3, 0, 0 },
+    { "$to", -1, 0, 7 },
+    { "$from", -1, 0, 11 },
+    { "$sz", -1, 0, 17 },
+    { "with", 3, 0, 0 },
+    { "_sz", -1, 0, 6 },
+    { "$sz", -1, 0, 10 },
+    { "with", 3, 0, 14 },
+    { "$gas", -1, 0, 20 },
+    { "+", 2, 0, 25 },
+    { "18", -1, 0, 28 },
+    { "/", 2, 0, 31 },
+    { "_sz", -1, 0, 34 },
+    { "10", -1, 0, 38 },
+    { "safe_call", 7, 0, 43 },
+    { "$gas", -1, 0, 54 },
+    { "4", -1, 0, 59 },
+    { "0", -1, 0, 61 },
+    { "$from", -1, 0, 63 },
+    { "_sz", -1, 0, 69 },
+    { "$to", -1, 0, 73 },
+    { "_sz", -1, 0, 77 },
+    // (waste $n) -> (call $n (create (lll (invalid))) 0 0 0 0 0)
+    { "waste", 1, 0, 0 },
+    { "$n", -1, 0, 7 },
+    { "call", 7, 0, 0 },
+    { "$n", -1, 0, 6 },
+    { "create", 1, 0, 9 },
+    { "lll", 1, 0, 17 },
+    { "invalid", 0, 0, 22 },
+    { "0", -1, 0, 34 },
+    { "0", -1, 0, 36 },
+    { "0", -1, 0, 38 },
+    { "0", -1, 0, 40 },
+    { "0", -1, 0, 42 },
+    // (selfdestruct $a) -> (suicide $a)
+    { "selfdestruct", 1, 0, 0 },
+    { "$a", -1, 0, 14 },
+    { "suicide", 1, 0, 0 },
+    { "$a", -1, 0, 9 },
+    // (~delegatecall $a $b $value $c $d $e $f) -> (~delegatecall $a $b $c $d $e $f)
+    { "~delegatecall", 7, 0, 0 },
+    { "$a", -1, 0, 15 },
+    { "$b", -1, 0, 18 },
+    { "$value", -1, 0, 21 },
+    { "$c", -1, 0, 28 },
+    { "$d", -1, 0, 31 },
+    { "$e", -1, 0, 34 },
+    { "$f", -1, 0, 37 },
+    { "~delegatecall", 6, 0, 0 },
+    { "$a", -1, 0, 15 },
+    { "$b", -1, 0, 18 },
+    { "$c", -1, 0, 21 },
+    { "$d", -1, 0, 24 },
+    { "$e", -1, 0, 27 },
+    { "$f", -1, 0, 30 },
+    // (. msg sender) -> (caller)
+    { ".", 2, 0, 0 },
+    { "msg", -1, 0, 3 },
+    { "sender", -1, 0, 7 },
+    { "caller", 0, 0, 0 },
+    // (. msg value) -> (callvalue)
+    { ".", 2, 0, 0 },
+    { "msg", -1, 0, 3 },
+    { "value", -1, 0, 7 },
+    { "callvalue", 0, 0, 0 },
+    // (. msg gas) -> (gas)
+    { ".", 2, 0, 0 },
+    { "msg", -1, 0, 3 },
+    { "gas", -1, 0, 7 },
+    { "gas", 0, 0, 0 },
+    // (. tx gasprice) -> (gasprice)
+    { ".", 2, 0, 0 },
+    { "tx", -1, 0, 3 },
+    { "gasprice", -1, 0, 6 },
+    { "gasprice", 0, 0, 0 },
+    // (. tx origin) -> (origin)
+    { ".", 2, 0, 0 },
+    { "tx", -1, 0, 3 },
+    { "origin", -1, 0, 6 },
+    { "origin", 0, 0, 0 },
+    // (. tx gas) -> (error "Replace tx.gas with msg.gas")
+    { ".", 2, 0, 0 },
+    { "tx", -1, 0, 3 },
+    { "gas", -1, 0, 6 },
+    { "error", 1, 0, 0 },
+    { "\"Replace tx.gas with msg.gas\"", -1, 0, 7 },
+    // (. $x balance) -> (balance $x)
+    { ".", 2, 0, 0 },
+    { "$x", -1, 0, 3 },
+    { "balance", -1, 0, 6 },
+    { "balance", 1, 0, 0 },
+    { "$x", -1, 0, 9 },
+    // self -> (address)
+    { "self", -1, 0, 0 },
+    { "address", 0, 0, 0 },
+    // (. block prevhash) -> (blockhash (sub (number) 1))
+    { ".", 2, 0, 0 },
+    { "block", -1, 0, 3 },
+    { "prevhash", -1, 0, 9 },
+    { "blockhash", 1, 0, 0 },
+    { "sub", 2, 0, 11 },
+    { "number", 0, 0, 16 },
+    { "1", -1, 0, 25 },
+    // (fun (. block prevhash) $n) -> (blockhash (sub (number) $n))
+    { "fun", 2, 0, 0 },
+    { ".", 2, 0, 5 },
+    { "block", -1, 0, 8 },
+    { "prevhash", -1, 0, 14 },
+    { "$n", -1, 0, 24 },
+    { "blockhash", 1, 0, 0 },
+    { "sub", 2, 0, 11 },
+    { "number", 0, 0, 16 },
+    { "$n", -1, 0, 25 },
+    // (. block coinbase) -> (coinbase)
+    { ".", 2, 0, 0 },
+    { "block", -1, 0, 3 },
+    { "coinbase", -1, 0, 9 },
+    { "coinbase", 0, 0, 0 },
+    // (. block timestamp) -> (timestamp)
+    { ".", 2, 0, 0 },
+    { "block", -1, 0, 3 },
+    { "timestamp", -1, 0, 9 },
+    { "timestamp", 0, 0, 0 },
+    // (. block number) -> (number)
+    { ".", 2, 0, 0 },
+    { "block", -1, 0, 3 },
+    { "number", -1, 0, 9 },
+    { "number", 0, 0, 0 },
+    // (. block difficulty) -> (difficulty)
+    { ".", 2, 0, 0 },
+    { "block", -1, 0, 3 },
+    { "difficulty", -1, 0, 9 },
+    { "difficulty", 0, 0, 0 },
+    // (. block gaslimit) -> (gaslimit)
+    { ".", 2, 0, 0 },
+    { "block", -1, 0, 3 },
+    { "gaslimit", -1, 0, 9 },
+    { "gaslimit", 0, 0, 0 },
+    // stop -> (stop)
+    { "stop", -1, 0, 0 },
+    { "stop", 0, 0, 0 },
+    // += setter
+    { "+=", 2, -1, -1 },
+    { "$x", -1, -1, -1 },
+    { "$y", -1, -1, -1 },
+    { "=", 2, -1, -1 },
+    { "$x", -1, -1, -1 },
+    { "+", 2, -1, -1 },
+    { "$x", -1, -1, -1 },
+    { "$y", -1, -1, -1 },
+    // -= setter
+    { "-=", 2, -1, -1 },
+    { "$x", -1, -1, -1 },
+    { "$y", -1, -1, -1 },
+    { "=", 2, -1, -1 },
+    { "$x", -1, -1, -1 },
+    { "-", 2, -1, -1 },
+    { "$x", -1, -1, -1 },
+    { "$y", -1, -1, -1 },
+    // *= setter
+    { "*=", 2, -1, -1 },
+    { "$x", -1, -1, -1 },
+    { "$y", -1, -1, -1 },
+    { "=", 2, -1, -1 },
+    { "$x", -1, -1, -1 },
+    { "*", 2, -1, -1 },
+    { "$x", -1, -1, -1 },
+    { "$y", -1, -1, -1 },
+    // /= setter
+    { "/=", 2, -1, -1 },
+    { "$x", -1, -1, -1 },
+    { "$y", -1, -1, -1 },
+    { "=", 2, -1, -1 },
+    { "$x", -1, -1, -1 },
+    { "/", 2, -1, -1 },
+    { "$x", -1, -1, -1 },
+    { "$y", -1, -1, -1 },
+    // %= setter
+    { "%=", 2, -1, -1 },
+    { "$x", -1, -1, -1 },
+    { "$y", -1, -1, -1 },
+    { "=", 2, -1, -1 },
+    { "$x", -1, -1, -1 },
+    { "%", 2, -1, -1 },
+    { "$x", -1, -1, -1 },
+    { "$y", -1, -1, -1 },
+    // ^= setter
+    { "^=", 2, -1, -1 },
+    { "$x", -1, -1, -1 },
+    { "$y", -1, -1, -1 },
+    { "=", 2, -1, -1 },
+    { "$x", -1, -1, -1 },
+    { "^", 2, -1, -1 },
+    { "$x", -1, -1, -1 },
+    { "$y", -1, -1, -1 },
+};
+
+constexpr macroRule nodeMacroTable[] = {
+    { 0, 2 },
+    { 3, 6 },
+    { 7, 10 },
+    { 15, 18 },
+    { 23, 26 },
+    { 31, 34 },
+    { 39, 42 },
+    { 47, 50 },
+    { 55, 58 },
+    { 62, 64 },
+    { 68, 71 },
+    { 83, 86 },
+    { 98, 101 },
+    { 113, 116 },
+    { 128, 133 },
+    { 137, 139 },
+    { 140, 142 },
+    { 160, 162 },
+    { 178, 181 },
+    { 186, 194 },
+    { 218, 226 },
+    { 246, 248 },
+    { 252, 254 },
+    { 261, 264 },
+    { 268, 272 },
+    { 275, 278 },
+    { 282, 286 },
+    { 289, 294 },
+    { 296, 299 },
+    { 305, 312 },
+    { 315, 319 },
+    { 322, 327 },
+    { 334, 337 },
+    { 345, 349 },
+    { 360, 363 },
+    { 371, 375 },
+    { 383, 385 },
+    { 386, 391 },
+    { 395, 399 },
+    { 403, 407 },
+    { 428, 432 },
+    { 454, 458 },
+    { 460, 465 },
+    { 492, 495 },
+    { 497, 499 },
+    { 507, 510 },
+    { 514, 517 },
+    { 524, 527 },
+    { 531, 534 },
+    { 538, 540 },
+    { 543, 546 },
+    { 556, 560 },
+    { 571, 575 },
+    { 586, 591 },
+    { 596, 599 },
+    { 601, 603 },
+    { 611, 615 },
+    { 626, 630 },
+    { 641, 646 },
+    { 651, 655 },
+    { 666, 668 },
+    { 678, 681 },
+    { 707, 710 },
+    { 712, 716 },
+    { 727, 731 },
+    { 742, 747 },
+    { 752, 754 },
+    { 764, 767 },
+    { 795, 798 },
+    { 800, 803 },
+    { 804, 807 },
+    { 810, 815 },
+    { 860, 862 },
+    { 863, 865 },
+    { 876, 881 },
+    { 885, 890 },
+    { 900, 905 },
+    { 915, 921 },
+    { 948, 952 },
+    { 1002, 1007 },
+    { 1041, 1044 },
+    { 1098, 1106 },
+    { 1116, 1120 },
+    { 1138, 1140 },
+    { 1150, 1152 },
+    { 1154, 1162 },
+    { 1169, 1172 },
+    { 1173, 1176 },
+    { 1177, 1180 },
+    { 1181, 1184 },
+    { 1185, 1188 },
+    { 1189, 1192 },
+    { 1194, 1197 },
+    { 1199, 1200 },
+    { 1201, 1204 },
+    { 1208, 1213 },
+    { 1217, 1220 },
+    { 1221, 1224 },
+    { 1225, 1228 },
+    { 1229, 1232 },
+    { 1233, 1236 },
+    { 1237, 1238 },
+};
+
+const unsigned nodeMacroCount = 102;
+
+constexpr macroRule setterMacroTable[] = {
+    { 1239, 1242 },
+    { 1247, 1250 },
+    { 1255, 1258 },
+    { 1263, 1266 },
+    { 1271, 1274 },
+    { 1279, 1282 },
+};
+
+const unsigned setterMacroCount = 6;
+
+constexpr const char *synonymTable[][2] = {
+    { "or", "||" },
+    { "and", "&&" },
+    { "|", "~or" },
+    { "&", "~and" },
+    { "elif", "if" },
+    { "!", "iszero" },
+    { "~", "~not" },
+    { "not", "iszero" },
+    { "+", "add" },
+    { "-", "sub" },
+    { "*", "mul" },
+    { "/", "sdiv" },
+    { "^", "exp" },
+    { "**", "exp" },
+    { "%", "smod" },
+    { "<", "slt" },
+    { ">", "sgt" },
+    { "=", "set" },
+    { "==", "eq" },
+    { ":", "kv" },
+};
+
+const unsigned synonymCount = 20;
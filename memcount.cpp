@@ -0,0 +1,72 @@
+#include <stdlib.h>
+#include <stddef.h>
+#include <new>
+#include "util.h"
+
+// Replaces operator new and delete, in their plain, array and sized
+// forms, to keep heapInUse and heapPeak (see util.h) while heapCounting
+// is on. Only linked into programs that want it, so that programs
+// embedding the library keep their own allocator. Every block starts
+// with a header holding the bytes it was counted as, or 0 if it was
+// allocated while counting was off, so that freeing it takes off only
+// what allocating it added, whether or not counting is still on
+
+// The header is as large as the alignment new must give
+const size_t HEADER = alignof(max_align_t);
+
+bool heapCountedInit() {
+    heapCounted = true;
+    return true;
+}
+
+bool heapCountedSet = heapCountedInit();
+
+void *countedAlloc(size_t n) {
+    char *p = (char *)malloc(HEADER + n);
+    if (!p) throw std::bad_alloc();
+    size_t counted = 0;
+    if (heapCounting.load(std::memory_order_relaxed)) {
+        counted = HEADER + n;
+        heapAllocations.fetch_add(1, std::memory_order_relaxed);
+        long long now = heapInUse.fetch_add(counted,
+                                            std::memory_order_relaxed)
+                      + counted;
+        long long peak = heapPeak.load(std::memory_order_relaxed);
+        while (now > peak && !heapPeak.compare_exchange_weak(peak, now)) {}
+    }
+    *(size_t *)p = counted;
+    return p + HEADER;
+}
+
+void countedFree(void *q) {
+    if (!q) return;
+    char *p = (char *)q - HEADER;
+    size_t counted = *(size_t *)p;
+    if (counted)
+        heapInUse.fetch_sub(counted, std::memory_order_relaxed);
+    free(p);
+}
+
+void *operator new(size_t n) {
+    return countedAlloc(n);
+}
+
+void *operator new[](size_t n) {
+    return countedAlloc(n);
+}
+
+void operator delete(void *p) noexcept {
+    countedFree(p);
+}
+
+void operator delete[](void *p) noexcept {
+    countedFree(p);
+}
+
+void operator delete(void *p, size_t) noexcept {
+    countedFree(p);
+}
+
+void operator delete[](void *p, size_t) noexcept {
+    countedFree(p);
+}
@@ -0,0 +1,98 @@
+#include <stdio.h>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "util.h"
+#include "bignum.h"
+#include "lllparser.h"
+#include "macrosource.h"
+
+// Writes out macrotables.cpp: the rules of macros.cpp, parsed, as
+// constant tables that the compiler can turn into rules without parsing
+// anything (see parseMacros in rewriter.cpp)
+
+std::string cString(const std::string &s) {
+    std::string o = "\"";
+    for (unsigned i = 0; i < s.size(); i++) {
+        unsigned char c = s[i];
+        if (c == '"' || c == '\\') o += std::string("\\") + (char)c;
+        else if (c >= 32 && c < 127) o += (char)c;
+        else {
+            char buf[8];
+            sprintf(buf, "\\%03o", c);
+            o += buf;
+        }
+    }
+    return o + "\"";
+}
+
+// Appends a node to the table in preorder
+void writeNode(const Node &n, std::string &o) {
+    o += "    { " + cString(n.val) + ", ";
+    o += n.type == TOKEN ? "-1" : unsignedToDecimal(n.args.size());
+    o += ", " + std::to_string(n.metadata.ln) + ", "
+       + std::to_string(n.metadata.ch) + " },\n";
+    for (unsigned i = 0; i < n.args.size(); i++) writeNode(n.args[i], o);
+}
+
+// Counts the table's nodes, so the rules know where theirs start
+unsigned treeNodes(const Node &n) {
+    unsigned o = 1;
+    for (unsigned i = 0; i < n.args.size(); i++) o += treeNodes(n.args[i]);
+    return o;
+}
+
+std::string oneLine(const std::string &s) {
+    std::string o;
+    for (unsigned i = 0; i < s.size(); i++)
+        o += (s[i] == '\n' || s[i] == '\r') ? ' ' : s[i];
+    return o;
+}
+
+int main() {
+    std::string nodes, nodeRules, setterRules, syns;
+    unsigned pos = 0, nodeCount = 0, setterCount = 0, synCount = 0;
+    for (int i = 0; macros[i][0] != "---END---"; i++) {
+        Node p = parseLLL(macros[i][0]);
+        Node s = parseLLL(macros[i][1]);
+        nodes += "    // " + oneLine(macros[i][0]) + " -> "
+               + oneLine(macros[i][1]) + "\n";
+        writeNode(p, nodes);
+        writeNode(s, nodes);
+        nodeRules += "    { " + unsignedToDecimal(pos) + ", "
+                   + unsignedToDecimal(pos + treeNodes(p)) + " },\n";
+        pos += treeNodes(p) + treeNodes(s);
+        nodeCount++;
+    }
+    // Setters are built rather than parsed (asn and tkn leave the
+    // metadata unset), but go through the same table
+    for (int i = 0; setters[i][0] != "---END---"; i++) {
+        Node p = asn(setters[i][0], tkn("$x"), tkn("$y"));
+        Node s = asn("=", tkn("$x"), asn(setters[i][1], tkn("$x"), tkn("$y")));
+        nodes += "    // " + setters[i][0] + " setter\n";
+        writeNode(p, nodes);
+        writeNode(s, nodes);
+        setterRules += "    { " + unsignedToDecimal(pos) + ", "
+                     + unsignedToDecimal(pos + treeNodes(p)) + " },\n";
+        pos += treeNodes(p) + treeNodes(s);
+        setterCount++;
+    }
+    for (int i = 0; synonyms[i][0] != "---END---"; i++) {
+        syns += "    { " + cString(synonyms[i][0]) + ", "
+              + cString(synonyms[i][1]) + " },\n";
+        synCount++;
+    }
+    std::cout << "// Generated by mkmacros from the tables in macros.cpp; do not edit\n"
+              << "#include \"macros.h\"\n\n"
+              << "constexpr macroNode macroNodes[] = {\n" << nodes << "};\n\n"
+              << "constexpr macroRule nodeMacroTable[] = {\n" << nodeRules
+              << "};\n\n"
+              << "const unsigned nodeMacroCount = " << nodeCount << ";\n\n"
+              << "constexpr macroRule setterMacroTable[] = {\n" << setterRules
+              << "};\n\n"
+              << "const unsigned setterMacroCount = " << setterCount << ";\n\n"
+              << "constexpr const char *synonymTable[][2] = {\n" << syns
+              << "};\n\n"
+              << "const unsigned synonymCount = " << synCount << ";\n";
+    return 0;
+}
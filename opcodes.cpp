@@ -93,26 +93,40 @@ Mapping mapping[] = {
 
 std::map<std::string, std::vector<int> > opcodes;
 std::map<int, std::string> reverseOpcodes;
+std::map<Symbol, std::vector<int> > symbolOpcodes;
+
+bool buildOpcodeTables() {
+    int i = 0;
+    while (mapping[i].op != "---END---") {
+        Mapping mi = mapping[i];
+        opcodes[mi.op] = triple(mi.opcode, mi.in, mi.out);
+        i++;
+    }
+    for (i = 1; i <= 16; i++) {
+        opcodes["DUP"+unsignedToDecimal(i)] = triple(0x7f + i, i, i+1);
+        opcodes["SWAP"+unsignedToDecimal(i)] = triple(0x8f + i, i+1, i+1);
+    }
+    for (std::map<std::string, std::vector<int> >::iterator it=opcodes.begin();
+         it != opcodes.end();
+         it++) {
+        reverseOpcodes[(*it).second[0]] = (*it).first;
+        symbolOpcodes[Symbol((*it).first)] = (*it).second;
+        symbolOpcodes[Symbol(lowerCase((*it).first))] = (*it).second;
+    }
+    return true;
+}
+
+// Fills the tables on first use. Initialization of a function-local
+// static is thread-safe, and the tables are only read afterwards, so
+// concurrent compilations can share them
+void initOpcodeTables() {
+    static const bool done = buildOpcodeTables();
+    (void)done;
+}
 
 // Fetches everything EXCEPT PUSH1..32
 std::pair<std::string, std::vector<int> > _opdata(std::string ops, int opi) {
-    if (!opcodes.size()) {
-        int i = 0;
-        while (mapping[i].op != "---END---") {
-            Mapping mi = mapping[i];
-            opcodes[mi.op] = triple(mi.opcode, mi.in, mi.out);
-            i++;
-        }
-        for (i = 1; i <= 16; i++) {
-            opcodes["DUP"+unsignedToDecimal(i)] = triple(0x7f + i, i, i+1);
-            opcodes["SWAP"+unsignedToDecimal(i)] = triple(0x8f + i, i+1, i+1);
-        }
-        for (std::map<std::string, std::vector<int> >::iterator it=opcodes.begin();
-             it != opcodes.end();
-             it++) {
-            reverseOpcodes[(*it).second[0]] = (*it).first;
-        }
-    }
+    initOpcodeTables();
     ops = upperCase(ops);
     std::string op;
     std::vector<int> opdata;
@@ -121,6 +135,20 @@ std::pair<std::string, std::vector<int> > _opdata(std::string ops, int opi) {
     return std::pair<std::string, std::vector<int> >(op, opdata);
 }
 
+// Symbol lookups only need an integer-keyed search for all-upper or
+// all-lower case names; anything else takes the case-folding path
+const std::vector<int> &_opdata(Symbol op) {
+    static const std::vector<int> none = triple(-1, -1, -1);
+    initOpcodeTables();
+    std::map<Symbol, std::vector<int> >::const_iterator it =
+        symbolOpcodes.find(op);
+    if (it != symbolOpcodes.end()) return it->second;
+    std::string upper = upperCase(op);
+    if (upper == op.str() || lowerCase(upper) == op.str()) return none;
+    it = symbolOpcodes.find(Symbol(upper));
+    return it == symbolOpcodes.end() ? none : it->second;
+}
+
 int opcode(std::string op) {
 	return _opdata(op, -1).second[0];
 }
@@ -133,6 +161,18 @@ int opoutputs(std::string op) {
 	return _opdata(op, -1).second[2];
 }
 
+int opcode(Symbol op) {
+	return _opdata(op)[0];
+}
+
+int opinputs(Symbol op) {
+	return _opdata(op)[1];
+}
+
+int opoutputs(Symbol op) {
+	return _opdata(op)[2];
+}
+
 std::string op(int opcode) {
 	return _opdata("", opcode).first;
 }
@@ -155,15 +195,19 @@ std::string lllSpecials[][3] = {
 
 std::map<std::string, std::pair<int, int> > lllMap;
 
+bool buildLLLMap() {
+    for (int i = 0; ; i++) {
+        if (lllSpecials[i][0] == "---END---") break;
+        lllMap[lllSpecials[i][0]] = std::pair<int, int>(
+            dtu(lllSpecials[i][1]), dtu(lllSpecials[i][2]));
+    }
+    return true;
+}
+
 // Is a function name one of the valid functions above?
 bool isValidLLLFunc(std::string f, int argc) {
-    if (lllMap.size() == 0) {
-        for (int i = 0; ; i++) {
-            if (lllSpecials[i][0] == "---END---") break;
-            lllMap[lllSpecials[i][0]] = std::pair<int, int>(
-                dtu(lllSpecials[i][1]), dtu(lllSpecials[i][2]));
-        }
-    }
+    static const bool done = buildLLLMap();
+    (void)done;
     return lllMap.count(f)
         && argc >= lllMap[f].first
         && argc <= lllMap[f].second;
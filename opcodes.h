@@ -34,6 +34,13 @@ int opinputs(std::string op);
 
 int opoutputs(std::string op);
 
+// Same, for interned names
+int opcode(Symbol op);
+
+int opinputs(Symbol op);
+
+int opoutputs(Symbol op);
+
 std::string op(int opcode);
 
 extern std::string lllSpecials[][3];
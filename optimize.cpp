@@ -5,13 +5,73 @@
 #include "util.h"
 #include "lllparser.h"
 #include "bignum.h"
+#include "uint256.h"
 #include "optimize.h"
 
+// Value of a constant operand of a modular operation: either a number
+// or a difference of two numbers, which is how negative constants are
+// written (see calcModular)
+bool constantOperand(const Node &n, uint256 &out, bool &negative) {
+    if (n.type == TOKEN) return u256FromDecimal(n.val, out);
+    uint256 a, b;
+    if (n.val == SYM_SUB && n.args.size() == 2
+            && n.args[0].type == TOKEN && n.args[1].type == TOKEN
+            && u256FromDecimal(n.args[0].val, a)
+            && u256FromDecimal(n.args[1].val, b)) {
+        out = a - b;
+        negative = true;
+        return true;
+    }
+    return false;
+}
+
+// Folds an operation on constants with exact EVM semantics. Negative
+// results of signed operations come out as (sub 0 k), which is much
+// cheaper than pushing 32 bytes
+Node calcModular(Node inp) {
+    if (inp.args.size() != 2 && inp.args.size() != 3) return inp;
+    uint256 v[3];
+    bool negative = false;
+    for (unsigned i = 0; i < inp.args.size(); i++) {
+        if (!constantOperand(inp.args[i], v[i], negative)) return inp;
+    }
+    uint256 &a = v[0], &b = v[1], &c = v[2];
+    bool folded = true;
+    uint256 o;
+    if (inp.args.size() == 3) {
+        if (inp.val == SYM_ADDMOD && !c.isZero()) o = u256AddMod(a, b, c);
+        else if (inp.val == SYM_MULMOD && !c.isZero()) o = u256MulMod(a, b, c);
+        else folded = false;
+    }
+    else if (inp.val == SYM_ADD) o = a + b;
+    // (sub a b) with a < b is already the canonical form of -(b - a)
+    else if (inp.val == SYM_SUB && (negative || a >= b)) o = a - b;
+    else if (inp.val == SYM_MUL) o = a * b;
+    else if (inp.val == SYM_DIV && !b.isZero()) o = a / b;
+    else if (inp.val == SYM_SDIV && !b.isZero()) o = u256SDiv(a, b);
+    else if (inp.val == SYM_MOD && !b.isZero()) o = a % b;
+    else if (inp.val == SYM_SMOD && !b.isZero()) o = u256SMod(a, b);
+    else if (inp.val == SYM_EXP) o = u256Exp(a, b);
+    else if (inp.val == SYM_SIGNEXTEND) o = u256SignExtend(a, b);
+    else folded = false;
+    if (!folded) return inp;
+    bool isSigned = negative || inp.val == SYM_SUB || inp.val == SYM_SDIV
+                 || inp.val == SYM_SMOD || inp.val == SYM_SIGNEXTEND;
+    if (isSigned && o.isNegative()) {
+        return astnode("sub",
+                       token("0", inp.metadata),
+                       token(u256ToDecimal(-o), inp.metadata),
+                       inp.metadata);
+    }
+    return token(u256ToDecimal(o), inp.metadata);
+}
+
 // Compile-time arithmetic calculations
 Node calcArithmetic(Node inp, bool modulo=true) {
     if (inp.type == TOKEN) {
         Node o = tryNumberize(inp);
-        if (decimalGt(o.val, tt256, true))
+        uint256 v;
+        if (o.val.size() && isDecimal(o.val) && !u256FromDecimal(o.val, v))
             err("Value too large (exceeds 32 bytes or 2^256)", inp.metadata);
         return o;
     }
@@ -19,72 +79,71 @@ Node calcArithmetic(Node inp, bool modulo=true) {
         inp.args[i] = calcArithmetic(inp.args[i]);
     }
     // Arithmetic-specific transform
-    if (inp.val == "+") inp.val = "add";
-    if (inp.val == "*") inp.val = "mul";
-    if (inp.val == "-") inp.val = "sub";
-    if (inp.val == "/") inp.val = "sdiv";
-    if (inp.val == "^") inp.val = "exp";
-    if (inp.val == "**") inp.val = "exp";
-    if (inp.val == "%") inp.val = "smod";
+    if (inp.val == SYM_PLUS) inp.val = SYM_ADD;
+    if (inp.val == SYM_TIMES) inp.val = SYM_MUL;
+    if (inp.val == SYM_MINUS) inp.val = SYM_SUB;
+    if (inp.val == SYM_SLASH) inp.val = SYM_SDIV;
+    if (inp.val == SYM_CARET) inp.val = SYM_EXP;
+    if (inp.val == SYM_POWER) inp.val = SYM_EXP;
+    if (inp.val == SYM_PERCENT) inp.val = SYM_SMOD;
     // Degenerate cases for add and mul
     if (inp.args.size() == 2) {
-        if (inp.val == "add" && inp.args[0].type == TOKEN && 
-                inp.args[0].val == "0") {
+        if (inp.val == SYM_ADD && inp.args[0].type == TOKEN && 
+                inp.args[0].val == SYM_ZERO) {
             Node x = inp.args[1];
             inp = x;
         }
-        if (inp.val == "add" && inp.args[1].type == TOKEN && 
-                inp.args[1].val == "0") {
+        if (inp.val == SYM_ADD && inp.args[1].type == TOKEN && 
+                inp.args[1].val == SYM_ZERO) {
             Node x = inp.args[0];
             inp = x;
         }
-        if (inp.val == "mul" && inp.args[0].type == TOKEN && 
-                inp.args[0].val == "1") {
+        if (inp.val == SYM_MUL && inp.args[0].type == TOKEN && 
+                inp.args[0].val == SYM_ONE) {
             Node x = inp.args[1];
             inp = x;
         }
-        if (inp.val == "mul" && inp.args[1].type == TOKEN && 
-                inp.args[1].val == "1") {
+        if (inp.val == SYM_MUL && inp.args[1].type == TOKEN && 
+                inp.args[1].val == SYM_ONE) {
             Node x = inp.args[0];
             inp = x;
         }
     }
+    // Modular arithmetic is done natively in 256 bits
+    if (modulo) return calcModular(inp);
     // Arithmetic computation
     if (inp.args.size() == 2 
             && inp.args[0].type == TOKEN 
             && inp.args[1].type == TOKEN) {
       std::string o;
-      if (inp.val == "add") {
+      if (inp.val == SYM_ADD) {
           o = decimalAdd(inp.args[0].val, inp.args[1].val);
-          if (modulo) o = decimalMod(o, tt256);
       }
-      else if (inp.val == "sub") {
+      else if (inp.val == SYM_SUB) {
           if (decimalGt(inp.args[0].val, inp.args[1].val, true))
               o = decimalSub(inp.args[0].val, inp.args[1].val);
       }
-      else if (inp.val == "mul") {
+      else if (inp.val == SYM_MUL) {
           o = decimalMul(inp.args[0].val, inp.args[1].val);
-          if (modulo) o = decimalMod(o, tt256);
       }
-      else if (inp.val == "div" && inp.args[1].val != "0") {
+      else if (inp.val == SYM_DIV && inp.args[1].val != SYM_ZERO) {
           o = decimalDiv(inp.args[0].val, inp.args[1].val);
       }
-      else if (inp.val == "sdiv" && inp.args[1].val != "0"
+      else if (inp.val == SYM_SDIV && inp.args[1].val != SYM_ZERO
             && decimalGt(tt255, inp.args[0].val)
             && decimalGt(tt255, inp.args[1].val)) {
           o = decimalDiv(inp.args[0].val, inp.args[1].val);
       }
-      else if (inp.val == "mod" && inp.args[1].val != "0") {
+      else if (inp.val == SYM_MOD && inp.args[1].val != SYM_ZERO) {
           o = decimalMod(inp.args[0].val, inp.args[1].val);
       }
-      else if (inp.val == "smod" && inp.args[1].val != "0"
+      else if (inp.val == SYM_SMOD && inp.args[1].val != SYM_ZERO
             && decimalGt(tt255, inp.args[0].val)
             && decimalGt(tt255, inp.args[1].val)) {
           o = decimalMod(inp.args[0].val, inp.args[1].val);
       }    
-      else if (inp.val == "exp") {
-          if (modulo) o = decimalModExp(inp.args[0].val, inp.args[1].val, tt256);
-          else o = decimalExp(inp.args[0].val, inp.args[1].val);
+      else if (inp.val == SYM_EXP) {
+          o = decimalExp(inp.args[0].val, inp.args[1].val);
       }
       if (o.length()) return token(o, inp.metadata);
     }
@@ -101,11 +160,11 @@ const Node VARIABLE_SET = tkn("__VARIABLE_SET_TOKEN17647152687");
 bool isReplaceable(Node inp, std::string var) {
     if (inp.type == TOKEN) {
     }
-    else if (inp.val == "set") {
+    else if (inp.val == SYM_SET) {
         if (inp.args[0].val == var)
             return false;
     }
-    else if (inp.val != "with" || inp.args[0].val != var) {
+    else if (inp.val != SYM_WITH || inp.args[0].val != var) {
         for (int i = 0; i < inp.args.size(); i++) {
             if (!isReplaceable(inp.args[i], var)) return false;
         }
@@ -122,12 +181,12 @@ bool isReplaceable(Node inp, std::string var) {
 Node filterWithStatements(Node inp, varmap vmap = varmap()) {
     if (inp.type == TOKEN)
         return inp;
-    else if (inp.val == "get") {
+    else if (inp.val == SYM_GET) {
         if (vmap.count(inp.args[0].val))
             return vmap[inp.args[0].val];
         return inp;
     }
-    else if (inp.val != "with") {
+    else if (inp.val != SYM_WITH) {
         std::vector<Node> newArgs;
         for (int i = 0; i < inp.args.size(); i++) {
             varmap sub = vmap;
@@ -2,38 +2,67 @@
 #include <iostream>
 #include <vector>
 #include <map>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <set>
+#include <utility>
+#include <stdlib.h>
+#include <stdint.h>
 #include "util.h"
 #include "parser.h"
 #include "tokenize.h"
+#include "keccak-tiny.h"
 
 // Extended BEDMAS precedence order
-int precedence(Node tok) {
-    std::string v = tok.val;
-    if (v == "." || v == "::") return -1;
-    else if (v == "!" || v == "not") return 1;
-    else if (v=="^" || v == "**") return 2;
-	else if (v=="*" || v=="/" || v=="%") return 3;
-    else if (v=="+" || v=="-") return 4;
-    else if (v=="<" || v==">" || v=="<=" || v==">=") return 5;
-    else if (v=="&" || v=="|" || v=="xor" || v=="==" || v == "!=") return 6;
-    else if (v=="&&" || v=="and") return 7;    
-    else if (v=="||" || v=="or") return 8;
-    else if (v=="=") return 10;
-    else if (v=="+=" || v=="-=" || v=="*=" || v=="/=" || v=="%=") return 10;
-    else if (v==":") return 11;
-    else return 0;
+std::map<Symbol, int> mkPrecedenceTable() {
+    const char *levels[][6] = {
+        { ".", "::" },
+        { "!", "not" },
+        { "^", "**" },
+        { "*", "/", "%" },
+        { "+", "-" },
+        { "<", ">", "<=", ">=" },
+        { "&", "|", "xor", "==", "!=" },
+        { "&&", "and" },
+        { "||", "or" },
+        { },
+        { "=", "+=", "-=", "*=", "/=", "%=" },
+        { ":" },
+    };
+    std::map<Symbol, int> o;
+    for (int i = 0; i < 12; i++) {
+        for (int j = 0; j < 6 && levels[i][j]; j++)
+            o[Symbol(levels[i][j])] = i ? i : -1;
+    }
+    return o;
+}
+
+int precedence(const Node &tok) {
+    static const std::map<Symbol, int> table = mkPrecedenceTable();
+    std::map<Symbol, int>::const_iterator it = table.find(tok.val);
+    return it == table.end() ? 0 : it->second;
 }
 
-// Token classification for shunting-yard purposes
-int toktype(Node tok) {
+// Token classification for the expression parser
+int toktype(const Node &tok) {
     if (tok.type == ASTNODE) return COMPOUND;
-    std::string v = tok.val;
-    if (v == "(" || v == "[" || v == "{") return LPAREN;
-    else if (v == ")" || v == "]" || v == "}") return RPAREN;
-    else if (v == ",") return COMMA;
-    else if (v == "!" || v == "~" || v == "not") return UNARY_OP;
-    else if (precedence(tok) > 0) return BINARY_OP;
-    else if (precedence(tok) < 0) return TOKEN_SPLITTER;
+    static const std::map<Symbol, int> classes = create_map<Symbol, int>
+        (Symbol("("), LPAREN)
+        (Symbol("["), LPAREN)
+        (Symbol("{"), LPAREN)
+        (Symbol(")"), RPAREN)
+        (Symbol("]"), RPAREN)
+        (Symbol("}"), RPAREN)
+        (Symbol(","), COMMA)
+        (Symbol("!"), UNARY_OP)
+        (Symbol("~"), UNARY_OP)
+        (Symbol("not"), UNARY_OP);
+    std::map<Symbol, int>::const_iterator it = classes.find(tok.val);
+    if (it != classes.end()) return it->second;
+    int prec = precedence(tok);
+    if (prec > 0) return BINARY_OP;
+    else if (prec < 0) return TOKEN_SPLITTER;
     if (tok.val[0] != '"' && tok.val[0] != '\'') {
 		for (unsigned i = 0; i < tok.val.length(); i++) {
             if (chartype(tok.val[i]) == SYMB) {
@@ -45,213 +74,210 @@ int toktype(Node tok) {
 }
 
 
-// Converts to reverse polish notation
-std::vector<Node> shuntingYard(std::vector<Node> tokens) {
-    std::vector<Node> iq;
-    for (int i = tokens.size() - 1; i >= 0; i--) {
-        iq.push_back(tokens[i]);
-    }
-    std::vector<Node> oq;
-    std::vector<Node> stack;
-    Node prev, tok;
-    int prevtyp = 0, toktyp = 0;
-    
-    while (iq.size()) {
-        prev = tok;
-        prevtyp = toktyp;
-        tok = iq.back();
-        toktyp = toktype(tok);
-        iq.pop_back();
-        // Alphanumerics go straight to output queue
-        if (toktyp == ALPHANUM) {
-            oq.push_back(tok);
-        }
-        // Left parens go on stack and output queue
-        else if (toktyp == LPAREN) {
-            while (stack.size() && toktype(stack.back()) == TOKEN_SPLITTER) {
-                oq.push_back(stack.back());
-                stack.pop_back();
-            }
-            if (prevtyp != ALPHANUM && prevtyp != RPAREN) {
-                oq.push_back(token("id", tok.metadata));
-            }
-            stack.push_back(tok);
-            oq.push_back(tok);
-        }
-        // If rparen, keep moving from stack to output queue until lparen
-        else if (toktyp == RPAREN) {
-            while (stack.size() && toktype(stack.back()) != LPAREN) {
-                oq.push_back(stack.back());
-                stack.pop_back();
-            }
-            if (stack.size()) {
-                stack.pop_back();
-            }
-            oq.push_back(tok);
-        }
-        else if (toktyp == UNARY_OP) {
-            stack.push_back(tok);
-        }
-        // If token splitter, just push it to the stack 
-        else if (toktyp == TOKEN_SPLITTER) {
-            while (stack.size() && toktype(stack.back()) == TOKEN_SPLITTER) {
-                oq.push_back(stack.back());
-                stack.pop_back();
-            }
-            stack.push_back(tok);
-        }
-        // If binary op, keep popping from stack while higher bedmas precedence
-        else if (toktyp == BINARY_OP) {
-            if (tok.val == "-" && prevtyp != ALPHANUM && prevtyp != RPAREN) {
-                stack.push_back(tok);
-                oq.push_back(token("0", tok.metadata));
-            }
-            else {
-                int prec = precedence(tok);
-                while (stack.size() 
-                      && (toktype(stack.back()) == BINARY_OP 
-                          || toktype(stack.back()) == UNARY_OP
-                          || toktype(stack.back()) == TOKEN_SPLITTER)
-                      && precedence(stack.back()) <= prec) {
-                    oq.push_back(stack.back());
-                    stack.pop_back();
-                }
-                stack.push_back(tok);
-            }
-        }
-        // Comma means finish evaluating the argument
-        else if (toktyp == COMMA) {
-            while (stack.size() && toktype(stack.back()) != LPAREN) {
-                oq.push_back(stack.back());
-                stack.pop_back();
+// A token classified once up front, so the parser compares ints rather
+// than looking strings up again every time it inspects the stack
+struct parseItem {
+    Node tok;
+    int typ;
+    int prec;
+};
+
+// Operator-precedence parser that builds the tree directly.
+//
+// This is shunting-yard with the output queue replaced by a stack of
+// finished subtrees: whenever shunting-yard would append an operator or
+// bracket to the RPN queue, it is reduced into a node straight away.
+// Reductions happen in exactly the order the old treefy pass consumed
+// the queue, so the trees (including those of odd inputs: "a + b c" is
+// (multi a (+ b c)), as operators take the two most recent operands)
+// and the errors are the same as with the two-pass version
+class serpentExprParser {
+    public:
+        serpentExprParser(const std::vector<Node> &tokens) {
+            items.resize(tokens.size());
+            // Classify everything first so that invalid symbols are
+            // reported before anything is reduced, as before
+            for (unsigned i = 0; i < tokens.size(); i++) {
+                items[i].tok = tokens[i];
+                items[i].typ = toktype(tokens[i]);
+                items[i].prec = precedence(tokens[i]);
             }
         }
+        Node parse();
+    private:
+        std::vector<parseItem> items;
+        // Operators and open brackets, as indices into items
+        std::vector<int> stack;
+        // Finished subtrees, plus open bracket tokens as markers
+        std::vector<Node> out;
+        bool isMarker(const Node &n);
+        void emitOperator(const parseItem &op);
+        void emitClose(const Node &tok);
+        void emitNode(const Node &n, const Metadata &m);
+        void popToOutput();
+};
+
+bool serpentExprParser::isMarker(const Node &n) {
+    static const Symbol paren("("), brack("["), brace("{");
+    return n.type == TOKEN
+        && (n.val == paren || n.val == brack || n.val == brace);
+}
+
+// Moves the top of the operator stack to the output
+void serpentExprParser::popToOutput() {
+    const parseItem &it = items[stack.back()];
+    stack.pop_back();
+    if (it.typ == LPAREN) emitNode(it.tok, it.tok.metadata);
+    else emitOperator(it);
+}
+
+// Applies a unary or binary operator to the most recent operands
+void serpentExprParser::emitOperator(const parseItem &op) {
+    unsigned rounds = (op.typ == UNARY_OP) ? 1 : 2;
+    if (out.size() < rounds)
+        err("Line malformed, not enough args for "+op.tok.val,
+            op.tok.metadata);
+    std::vector<Node> args(out.end() - rounds, out.end());
+    out.resize(out.size() - rounds);
+    emitNode(astnode(op.tok.val, args, op.tok.metadata), op.tok.metadata);
+}
+
+// Closing bracket: everything back to the matching open bracket marker
+// becomes the arguments of whatever precedes the marker
+void serpentExprParser::emitClose(const Node &tok) {
+    static const Symbol id("id"), fun("fun"), access("access"),
+                        arrayLit("array_lit"), rbrack("]");
+    int marker = (int)out.size() - 1;
+    while (marker >= 0 && !isMarker(out[marker])) marker--;
+    if (marker <= 0) err("Bracket without matching", tok.metadata);
+    Node head = out[marker - 1];
+    std::vector<Node> args(out.begin() + marker + 1, out.end());
+    out.resize(marker - 1);
+    // We represent a[b] as (access a b)
+    Symbol f;
+    if (tok.val == rbrack) {
+        args.insert(args.begin(), head);
+        f = access;
+    }
+    else if (head.type == ASTNODE) {
+        args.insert(args.begin(), head);
+        f = fun;
     }
-    while (stack.size()) {
-        oq.push_back(stack.back());
-        stack.pop_back();
+    else f = head.val;
+    // We represent [1,2,3] as (array_lit 1 2 3)
+    if (f == access && args.size() && args[0].val == id) {
+        f = arrayLit;
+        args.erase(args.begin());
     }
-    return oq;
+    // When evaluating 2 + (3 * 5), the opening bracket has no function
+    // in front of it, so "id" is inserted as a dummy one. This removes it
+    if (f == id && args.size() == 1) emitNode(args[0], tok.metadata);
+    else emitNode(astnode(f, args, tok.metadata), tok.metadata);
 }
 
-// Converts reverse polish notation into tree
-Node treefy(std::vector<Node> stream) {
-    std::vector<Node> iq;
-    for (int i = stream.size() -1; i >= 0; i--) {
-        iq.push_back(stream[i]);
+// Pushes a finished node. This is messy, but has to be done. Import/inset
+// other files here
+void serpentExprParser::emitNode(const Node &n, const Metadata &m) {
+    static const Symbol inset("inset"), import("import"), create("create");
+    out.push_back(n);
+    if ((n.val == inset || n.val == import || n.val == create)
+            && n.args.size() == 1
+            && n.args[0].type == TOKEN) {
+        int lastSlashPos = m.file.rfind("/");
+        std::string root;
+        if (lastSlashPos >= 0)
+            root = m.file.substr(0, lastSlashPos) + "/";
+        else
+            root = "";
+        std::string filename = n.args[0].val;
+        filename = filename.substr(1, filename.length() - 2);
+        if (!exists(root + filename))
+            err("File does not exist: "+root + filename, m);
+        if (n.val == inset) {
+            out.pop_back();
+            out.push_back(parseSerpentFile(root + filename));
+        }
+        else {
+            out.back().args.pop_back();
+            out.back().args.push_back(
+                asn("outer", parseSerpentFile(root + filename), m));
+        }
     }
-    std::vector<Node> oq;
-    while (iq.size()) {
-        Node tok = iq.back();
-        iq.pop_back();
-        int typ = toktype(tok);
-        // If unary, take node off end of oq and wrap it with the operator
-        // If binary, do the same with two nodes
-        if (typ == UNARY_OP || typ == BINARY_OP || typ == TOKEN_SPLITTER) {
-            std::vector<Node> args;
-            int rounds = (typ == UNARY_OP) ? 1 : 2;
-            for (int i = 0; i < rounds; i++) {
-                if (oq.size() == 0) {
-                    err("Line malformed, not enough args for "+tok.val,
-                        tok.metadata);
-                }
-                args.push_back(oq.back());
-                oq.pop_back();
-            }
-            std::vector<Node> args2;
-            while (args.size()) {
-                args2.push_back(args.back());
-                args.pop_back();
-            }
-            oq.push_back(astnode(tok.val, args2, tok.metadata));
+}
+
+Node serpentExprParser::parse() {
+    static const Symbol minus("-");
+    int prevtyp = 0;
+    for (unsigned i = 0; i < items.size(); i++) {
+        const parseItem &it = items[i];
+        bool afterOperand = prevtyp == ALPHANUM || prevtyp == RPAREN;
+        prevtyp = it.typ;
+        // Alphanumerics are finished nodes already
+        if (it.typ == ALPHANUM) {
+            emitNode(it.tok, it.tok.metadata);
         }
-        // If rparen, keep grabbing until we get to an lparen
-        else if (typ == RPAREN) {
-            std::vector<Node> args;
-            while (1) {
-                if (toktype(oq.back()) == LPAREN) break;
-                args.push_back(oq.back());
-                oq.pop_back();
-                if (!oq.size()) err("Bracket without matching", tok.metadata);
-            }
-            oq.pop_back();
-            args.push_back(oq.back());
-            oq.pop_back();
-            // We represent a[b] as (access a b)
-            if (tok.val == "]")
-                 args.push_back(token("access", tok.metadata));
-            if (args.back().type == ASTNODE)
-                 args.push_back(token("fun", tok.metadata));
-            std::string fun = args.back().val;
-            args.pop_back();
-            // We represent [1,2,3] as (array_lit 1 2 3)
-            if (fun == "access" && args.size() && args.back().val == "id") {
-                fun = "array_lit";
-                args.pop_back();
-            }
-            std::vector<Node> args2;
-            while (args.size()) {
-                args2.push_back(args.back());
-                args.pop_back();
-            }
-            // When evaluating 2 + (3 * 5), the shunting yard algo turns that
-            // into 2 ( id 3 5 * ) +, effectively putting "id" as a dummy
-            // function where the algo was expecting a function to call the
-            // thing inside the brackets. This reverses that step
-			if (fun == "id" && args2.size() == 1) {
-                oq.push_back(args2[0]);
-            }
-            else {
-                oq.push_back(astnode(fun, args2, tok.metadata));
-            }
+        // Left parens go on the stack and mark the start of the arguments
+        else if (it.typ == LPAREN) {
+            while (stack.size() && items[stack.back()].typ == TOKEN_SPLITTER)
+                popToOutput();
+            if (!afterOperand)
+                emitNode(token("id", it.tok.metadata), it.tok.metadata);
+            stack.push_back(i);
+            emitNode(it.tok, it.tok.metadata);
         }
-        else oq.push_back(tok);
-        // This is messy, but has to be done. Import/inset other files here
-        std::string v = oq.back().val;
-        if ((v == "inset" || v == "import" || v == "create") 
-                && oq.back().args.size() == 1
-                && oq.back().args[0].type == TOKEN) {
-            int lastSlashPos = tok.metadata.file.rfind("/");
-            std::string root;
-            if (lastSlashPos >= 0)
-                root = tok.metadata.file.substr(0, lastSlashPos) + "/";
-            else
-                root = "";
-            std::string filename = oq.back().args[0].val;
-            filename = filename.substr(1, filename.length() - 2);
-            if (!exists(root + filename))
-                err("File does not exist: "+root + filename, tok.metadata);
-            if (v == "inset") {
-                oq.pop_back();
-                oq.push_back(parseSerpent(root + filename));
+        // If rparen, finish everything back to the lparen
+        else if (it.typ == RPAREN) {
+            while (stack.size() && items[stack.back()].typ != LPAREN)
+                popToOutput();
+            if (stack.size()) stack.pop_back();
+            emitClose(it.tok);
+        }
+        else if (it.typ == UNARY_OP) {
+            stack.push_back(i);
+        }
+        // Token splitters bind tighter than anything else
+        else if (it.typ == TOKEN_SPLITTER) {
+            while (stack.size() && items[stack.back()].typ == TOKEN_SPLITTER)
+                popToOutput();
+            stack.push_back(i);
+        }
+        // If binary op, finish operators with higher or equal bedmas
+        // precedence first. A leading minus is parsed as 0 - x
+        else if (it.typ == BINARY_OP) {
+            if (!afterOperand && it.tok.val == minus) {
+                stack.push_back(i);
+                emitNode(token("0", it.tok.metadata), it.tok.metadata);
             }
             else {
-                oq.back().args.pop_back();
-                oq.back().args.push_back(
-                    asn("outer", parseSerpent(root + filename), tok.metadata));
+                while (stack.size()) {
+                    const parseItem &top = items[stack.back()];
+                    if ((top.typ != BINARY_OP && top.typ != UNARY_OP
+                            && top.typ != TOKEN_SPLITTER)
+                            || top.prec > it.prec)
+                        break;
+                    popToOutput();
+                }
+                stack.push_back(i);
             }
         }
-        //Useful for debugging
-        //for (int i = 0; i < oq.size(); i++) {
-        //    std::cerr << printSimple(oq[i]) << " ";
-        //}
-        //std::cerr << " <-\n";
+        // Comma means finish evaluating the argument
+        else if (it.typ == COMMA) {
+            while (stack.size() && items[stack.back()].typ != LPAREN)
+                popToOutput();
+        }
     }
+    while (stack.size()) popToOutput();
     // Output must have one argument
-    if (oq.size() == 0) {
+    if (out.size() == 0)
         err("Output blank", Metadata());
-    }
-    else if (oq.size() > 1) {
-        return asn("multi", oq, oq[0].metadata);
-    }
-
-	return oq[0];
+    else if (out.size() > 1)
+        return asn("multi", out, out[0].metadata);
+    return out[0];
 }
 
-
 // Parses one line of serpent
-Node parseSerpentTokenStream(std::vector<Node> s) {
-    return treefy(shuntingYard(s));
+Node parseSerpentTokenStream(const std::vector<Node> &s) {
+    return serpentExprParser(s).parse();
 }
 
 
@@ -423,15 +449,354 @@ Node parseLines(std::vector<std::string> lines, Metadata metadata, int sp) {
 		return astnode("seq", o, Metadata());
 }
 
+// A parsed file, and what it was parsed from. The name is the path as
+// it was referenced, which ends up in the metadata and is what nested
+// inset/import paths are resolved against
+struct parsedFile {
+    std::string name;
+    std::string hash;
+    // Canonical paths and content hashes of every file pulled in while
+    // parsing it, directly or not
+    std::vector<std::pair<std::string, std::string> > deps;
+    Node ast;
+};
+
+// Parsed files by canonical path. Shared by all the threads working on
+// a compilation (or by everything, with PARSE_CACHE_PROCESS)
+class parseCache {
+    public:
+        bool get(const std::string &canonical, parsedFile &o) {
+            std::lock_guard<std::mutex> l(lock);
+            std::map<std::string, parsedFile>::iterator it =
+                files.find(canonical);
+            if (it == files.end()) return false;
+            o = it->second;
+            return true;
+        }
+        void put(const std::string &canonical, const parsedFile &f) {
+            std::lock_guard<std::mutex> l(lock);
+            files[canonical] = f;
+        }
+        void clear() {
+            std::lock_guard<std::mutex> l(lock);
+            files.clear();
+        }
+    private:
+        std::mutex lock;
+        std::map<std::string, parsedFile> files;
+};
+
+parseCache processParseCache;
+
+std::atomic<int> parseCacheScope(PARSE_CACHE_COMPILATION);
+
+void setParseCacheScope(int scope) {
+    parseCacheScope = scope;
+    if (scope != PARSE_CACHE_PROCESS) processParseCache.clear();
+}
+
+// State of the compilation this thread is parsing for
+struct parseContext {
+    int depth;
+    parseCache *cache;
+    parseCache compilationCache;
+    // Content hashes by canonical path, so each file is read only once
+    // per compilation
+    std::map<std::string, std::string> hashes;
+    // Contents already read by prefetchIncludes, by canonical path
+    const std::map<std::string, std::string> *sources;
+    // Dependencies collected for each file being parsed, innermost last
+    std::vector<std::vector<std::pair<std::string, std::string> > > open;
+    // Where the outermost parse lists the files it read, if anywhere
+    fileHashes *files;
+    parseContext() {
+        depth = 0;
+        cache = 0;
+        sources = 0;
+        files = 0;
+    }
+};
+
+thread_local parseContext parseState;
+
+// Marks the outermost parseSerpent call as a compilation
+class parseScope {
+    public:
+        parseScope() {
+            if (!parseState.depth++) {
+                int scope = parseCacheScope;
+                parseState.cache = scope == PARSE_CACHE_PROCESS
+                    ? &processParseCache
+                    : scope == PARSE_CACHE_COMPILATION
+                    ? &parseState.compilationCache
+                    : 0;
+            }
+        }
+        ~parseScope() {
+            if (!--parseState.depth) {
+                parseState.compilationCache.clear();
+                parseState.hashes.clear();
+                parseState.open.clear();
+                parseState.cache = 0;
+                parseState.files = 0;
+            }
+        }
+};
+
+// Runs a worker thread's parsing as part of another thread's compilation
+class parseWorkerScope {
+    public:
+        parseWorkerScope(parseCache *cache,
+                         const std::map<std::string, std::string> &hashes,
+                         const std::map<std::string, std::string> *sources) {
+            parseState.depth = 1;
+            parseState.cache = cache;
+            parseState.hashes = hashes;
+            parseState.sources = sources;
+            muteDiagnostics = true;
+        }
+        ~parseWorkerScope() {
+            parseState.depth = 0;
+            parseState.hashes.clear();
+            parseState.open.clear();
+            parseState.cache = 0;
+            parseState.sources = 0;
+            muteDiagnostics = false;
+        }
+};
+
+std::atomic<int> parseThreads(1);
+
+void setParseThreads(int n) {
+    parseThreads = n < 1 ? 1 : n;
+}
+
+// Set by parseThreadsScope; 0 means use parseThreads
+thread_local int threadParseThreads = 0;
+
+parseThreadsScope::parseThreadsScope(int n) {
+    outer = threadParseThreads;
+    threadParseThreads = n < 0 ? 0 : n;
+}
+
+parseThreadsScope::~parseThreadsScope() {
+    threadParseThreads = outer;
+}
+
+std::string canonicalPath(const std::string &path) {
+    char *p = realpath(path.c_str(), 0);
+    if (!p) return path;
+    std::string o = p;
+    free(p);
+    return o;
+}
+
+std::string contentHash(const std::string &contents) {
+    uint8_t h[32];
+    sha3_256(h, 32, (const uint8_t *)contents.data(), contents.size());
+    return std::string((const char *)h, 32);
+}
+
+// Hash of the file as it is now, read at most once per compilation
+const std::string &currentHash(const std::string &canonical) {
+    std::map<std::string, std::string>::iterator it =
+        parseState.hashes.find(canonical);
+    if (it == parseState.hashes.end()) {
+        std::string h = contentHash(get_file_contents(canonical));
+        it = parseState.hashes.insert(std::make_pair(canonical, h)).first;
+    }
+    return it->second;
+}
+
+// Contents of the file, unless prefetchIncludes has read them already
+std::string readSource(const std::string &filename,
+                       const std::string &canonical) {
+    if (parseState.sources) {
+        std::map<std::string, std::string>::const_iterator it =
+            parseState.sources->find(canonical);
+        if (it != parseState.sources->end()) return it->second;
+    }
+    return get_file_contents(filename);
+}
+
+// A cached parse can be reused if it was made under the same name from
+// the same contents, and none of the files it pulled in have changed
+bool parsedFileValid(const parsedFile &f, const std::string &name,
+                     const std::string &canonical) {
+    if (f.name != name || f.hash != currentHash(canonical)) return false;
+    for (unsigned i = 0; i < f.deps.size(); i++) {
+        if (f.deps[i].second != currentHash(f.deps[i].first)) return false;
+    }
+    return true;
+}
+
+// Files named by inset/import/create calls in the source, as the parser
+// will resolve them (relative to the directory of the including file).
+// Only a guess from the tokens, which is all prefetching needs
+std::vector<std::string> scanIncludes(const std::string &input,
+                                      const std::string &name) {
+    static const Symbol inset("inset"), import("import"), create("create"),
+                        lparen("("), rparen(")");
+    std::vector<std::string> o;
+    std::string root;
+    int lastSlashPos = name.rfind("/");
+    if (lastSlashPos >= 0) root = name.substr(0, lastSlashPos) + "/";
+    std::vector<tokenSpan> spans = tokenizeSpans(input, Metadata(), false);
+    std::vector<Symbol> toks;
+    for (unsigned i = 0; i < spans.size(); i++)
+        toks.push_back(Symbol(input.data() + spans[i].offset,
+                              spans[i].length));
+    for (unsigned i = 0; i + 3 < toks.size(); i++) {
+        if ((toks[i] == inset || toks[i] == import || toks[i] == create)
+                && toks[i + 1] == lparen && toks[i + 3] == rparen
+                && toks[i + 2].size() >= 2
+                && (toks[i + 2][0] == '"' || toks[i + 2][0] == '\'')) {
+            std::string f = root + toks[i + 2].substr(1,
+                                                      toks[i + 2].size() - 2);
+            if (exists(f)) o.push_back(f);
+        }
+    }
+    return o;
+}
+
+// Parses the files a compilation is going to pull in on a pool of threads
+// and leaves them in its cache, so that the serial parse finds them ready
+// and splices them in the same order it always would. Files are only
+// started once everything they include is done, so each is parsed once,
+// and each is read once: the workers parse what the scan read, and the
+// serial parse checks the cache against the hashes taken then.
+// Anything that fails is left for the serial parse to report
+void prefetchIncludes(const std::string &input, const std::string &name) {
+    int threads = threadParseThreads ? threadParseThreads : parseThreads.load();
+    parseCache *cache = parseState.cache;
+    if (threads < 2 || !cache) return;
+    // Include graph, by the name each file is referenced under
+    std::map<std::string, std::vector<std::string> > graph;
+    std::map<std::string, std::string> sources;
+    std::vector<std::string> queue = scanIncludes(input, name);
+    while (queue.size()) {
+        std::string f = queue.back();
+        queue.pop_back();
+        if (graph.count(f)) continue;
+        std::string canonical = canonicalPath(f);
+        if (!sources.count(canonical)) {
+            sources[canonical] = get_file_contents(f);
+            parseState.hashes[canonical] = contentHash(sources[canonical]);
+        }
+        std::vector<std::string> deps = scanIncludes(sources[canonical], f);
+        graph[f] = deps;
+        queue.insert(queue.end(), deps.begin(), deps.end());
+    }
+    if (graph.size() < 2) return;
+    // Files wait for their distinct includes; those caught in a cycle
+    // never become ready and are left to the serial parse
+    std::map<std::string, int> waiting;
+    std::map<std::string, std::vector<std::string> > dependents;
+    std::vector<std::string> ready;
+    std::map<std::string, std::vector<std::string> >::iterator it;
+    for (it = graph.begin(); it != graph.end(); it++) {
+        std::set<std::string> deps(it->second.begin(), it->second.end());
+        waiting[it->first] = deps.size();
+        std::set<std::string>::iterator d;
+        for (d = deps.begin(); d != deps.end(); d++)
+            dependents[*d].push_back(it->first);
+        if (!deps.size()) ready.push_back(it->first);
+    }
+    const std::map<std::string, std::string> &hashes = parseState.hashes;
+    std::mutex lock;
+    std::condition_variable changed;
+    int running = 0;
+    std::vector<std::thread> pool;
+    if (threads > (int)graph.size()) threads = graph.size();
+    for (int t = 0; t < threads; t++) {
+        pool.push_back(std::thread([&]() {
+            parseWorkerScope scope(cache, hashes, &sources);
+            std::unique_lock<std::mutex> l(lock);
+            while (1) {
+                while (!ready.size() && running) changed.wait(l);
+                if (!ready.size()) break;
+                std::string f = ready.back();
+                ready.pop_back();
+                running += 1;
+                l.unlock();
+                try {
+                    parseSerpentFile(f);
+                }
+                catch (...) {
+                }
+                l.lock();
+                running -= 1;
+                std::vector<std::string> &next = dependents[f];
+                for (unsigned i = 0; i < next.size(); i++) {
+                    if (!--waiting[next[i]]) ready.push_back(next[i]);
+                }
+                changed.notify_all();
+            }
+        }));
+    }
+    for (unsigned t = 0; t < pool.size(); t++) pool[t].join();
+}
+
+Node parseSerpentFile(std::string filename) {
+    parseScope scope;
+    std::string canonical = canonicalPath(filename);
+    parsedFile f;
+    bool hit = parseState.cache
+        && parseState.cache->get(canonical, f)
+        && parsedFileValid(f, filename, canonical);
+    if (!hit) {
+        std::string input = readSource(filename, canonical);
+        if (parseState.depth == 1) prefetchIncludes(input, filename);
+        f.name = filename;
+        f.hash = contentHash(input);
+        parseState.hashes[canonical] = f.hash;
+        parseState.open.push_back(
+            std::vector<std::pair<std::string, std::string> >());
+        try {
+            f.ast = parseLines(splitLines(input), Metadata(filename, 0, 0), 0);
+        }
+        catch (...) {
+            parseState.open.pop_back();
+            throw;
+        }
+        f.deps = parseState.open.back();
+        parseState.open.pop_back();
+        if (parseState.cache) parseState.cache->put(canonical, f);
+    }
+    // Whoever pulled this file in now depends on it and on everything it
+    // depends on
+    if (parseState.open.size()) {
+        std::vector<std::pair<std::string, std::string> > &deps =
+            parseState.open.back();
+        deps.push_back(std::make_pair(canonical, f.hash));
+        deps.insert(deps.end(), f.deps.begin(), f.deps.end());
+    }
+    else if (parseState.files) {
+        parseState.files->push_back(std::make_pair(canonical, f.hash));
+        parseState.files->insert(parseState.files->end(),
+                                 f.deps.begin(), f.deps.end());
+    }
+    return f.ast;
+}
+
 // Parses serpent code
 Node parseSerpent(std::string s) {
-    std::string input = s;
-    std::string file = "main";
-    if (exists(s)) {
-        file = s;
-        input = get_file_contents(s);
+    phaseScope phase("parse");
+    Node o;
+    if (exists(s)) o = parseSerpentFile(s);
+    else {
+        parseScope scope;
+        prefetchIncludes(s, "main");
+        o = parseLines(splitLines(s), Metadata("main", 0, 0), 0);
     }
-    return parseLines(splitLines(input), Metadata(file, 0, 0), 0);
+    phase.out(o);
+    return o;
+}
+
+Node parseSerpent(std::string s, fileHashes &files) {
+    // Cleared again when the outermost parse scope closes
+    if (!parseState.depth) parseState.files = &files;
+    return parseSerpent(s);
 }
 
 
@@ -10,4 +10,49 @@
 // Serpent text -> parse tree
 Node parseSerpent(std::string s);
 
+// Canonical paths and content hashes of files
+typedef std::vector<std::pair<std::string, std::string> > fileHashes;
+
+// parseSerpent, also listing every file the parse read: the file itself
+// if s names one, and everything it insets, imports or creates, directly
+// or not
+Node parseSerpent(std::string s, fileHashes &files);
+
+// Content hash of a file, as recorded in fileHashes
+std::string contentHash(const std::string &contents);
+
+// Serpent file -> parse tree. Files are cached by canonical path, and a
+// cached tree is reused as long as the file and everything it insets or
+// imports hash the same as when it was parsed
+Node parseSerpentFile(std::string filename);
+
+// How long parsed files are kept: for the duration of one top-level
+// parseSerpent call (the default), for the life of the process, or not
+// at all
+const int PARSE_CACHE_NONE = 0,
+          PARSE_CACHE_COMPILATION = 1,
+          PARSE_CACHE_PROCESS = 2;
+
+void setParseCacheScope(int scope);
+
+// Number of threads used to parse the files a compilation insets or
+// imports ahead of time (default 1: they are parsed serially, as they
+// are reached). The result is the same either way
+void setParseThreads(int n);
+
+// Overrides setParseThreads for the current thread while it lives, for
+// callers that already compile on several threads of their own. 0
+// keeps the process-wide setting
+class parseThreadsScope {
+    public:
+        parseThreadsScope(int n);
+        ~parseThreadsScope();
+    private:
+        int outer;
+};
+
+// One line of serpent tokens (without comments or a trailing colon)
+// -> expression tree
+Node parseSerpentTokenStream(const std::vector<Node> &s);
+
 #endif
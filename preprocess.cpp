@@ -80,10 +80,10 @@ Node convFunction(int prefix4, std::vector<Node> args, Node body) {
                    astnode("seq", unpack, body, m));
 }
 
-// Populate an svObj with the arguments needed to determine
-// the storage position of a node
-svObj getStorageVars(svObj pre, Node node, std::string prefix,
-                     int index) {
+// Adds to an svObj the arguments needed to determine the storage
+// position of a node. It fills in the object it is given, as copying it
+// for each declaration made a contract's storage layout quadratic
+void addStorageVars(svObj &pre, Node node, std::string prefix, int index) {
     Metadata m = node.metadata;
     if (!pre.globalOffset.size()) pre.globalOffset = "0";
     std::vector<Node> h;
@@ -119,16 +119,18 @@ svObj getStorageVars(svObj pre, Node node, std::string prefix,
             startc = 0;
             h = listfyStorageAccess(token(node.val, m));
         }
-        svObj sub = pre;
-        sub.globalOffset = "0";
+        // Tuple elements are laid out from 0 within the tuple
+        std::string globalOffset = pre.globalOffset;
+        pre.globalOffset = "0";
         // Evaluate tuple elements recursively
         for (unsigned i = startc; i < node.args.size(); i++) {
-            sub = getStorageVars(sub,
-                                 node.args[i],
-                                 prefix+h[0].val.substr(2)+".",
-                                 i-startc);
+            addStorageVars(pre,
+                           node.args[i],
+                           prefix+h[0].val.substr(2)+".",
+                           i-startc);
         }
-        coefficients.push_back(sub.globalOffset);
+        coefficients.push_back(pre.globalOffset);
+        pre.globalOffset = globalOffset;
         for (unsigned i = h.size() - 1; i >= 1; i--) {
             // Array sizes must be constant or at least arithmetically
             // evaluable at compile time
@@ -139,10 +141,6 @@ svObj getStorageVars(svObj pre, Node node, std::string prefix,
             // array index
             coefficients.push_back(decimalMul(coefficients.back(), h[i].val));
         }
-        pre.offsets = sub.offsets;
-        pre.coefficients = sub.coefficients;
-        pre.indices = sub.indices;
-        pre.nonfinal = sub.nonfinal;
         pre.nonfinal[prefix+h[0].val.substr(2)] = true;
     }
     pre.coefficients[prefix+h[0].val.substr(2)] = coefficients;
@@ -150,6 +148,10 @@ svObj getStorageVars(svObj pre, Node node, std::string prefix,
     pre.indices[prefix+h[0].val.substr(2)] = index;
     if (decimalGt(tt176, coefficients.back()))
         pre.globalOffset = decimalAdd(pre.globalOffset, coefficients.back());
+}
+
+svObj getStorageVars(svObj pre, Node node, std::string prefix, int index) {
+    addStorageVars(pre, node, prefix, index);
     return pre;
 }
 
@@ -259,7 +261,7 @@ typeMetadata getTypes(Node typeNode) {
         outType = (o.val == "a") ? "int256[]"
                 : (o.val == "s") ? "bytes"
                 : (o.val == "i") ? "int256"
-                :              o.val;
+                :              o.val.str();
     }
     else err ("Invalid out type: "+printSimple(o), m);
     return typeMetadata(fun, inTypes, outType);
@@ -513,10 +515,8 @@ preprocessResult preprocessInit(Node inp) {
         }
         // Storage variables/structures
         else if (obj.val == "data") {
-            out.storageVars = getStorageVars(out.storageVars,
-                                             obj.args[0],
-                                             "",
-                                             storageDataCount);
+            addStorageVars(out.storageVars, obj.args[0], "",
+                           storageDataCount);
             storageDataCount += 1;
         }
         else any.push_back(obj);
@@ -561,33 +561,34 @@ preprocessResult preprocessInit(Node inp) {
     return preprocessResult(result, out);
 }
 
-preprocessResult processTypes (preprocessResult pr) {
-    preprocessAux aux = pr.second;
-    Node node = pr.first;
+// The aux is passed down by reference: it holds every function's
+// metadata, and copying it at each node made this quadratic
+Node processTypes(Node node, const preprocessAux &aux) {
     if (node.type == TOKEN && aux.types.size()) {
-        if (aux.types.count(node.val)) {
-            node = asn(aux.types[node.val], node, node.metadata);
-            return preprocessResult(node, aux);
-        }
+        std::map<std::string, std::string>::const_iterator t =
+            aux.types.find(node.val);
+        if (t != aux.types.end())
+            return asn(t->second, node, node.metadata);
         for (int i = node.val.size() - 1; i >= 1; i--) {
-            std::string prefix = "_prefix:"+node.val.substr(0, i);
-            if (aux.types.count(prefix)) {
-                node = asn(aux.types[prefix], node, node.metadata);
-                return preprocessResult(node, aux);
-            }
+            t = aux.types.find("_prefix:"+node.val.substr(0, i));
+            if (t != aux.types.end())
+                return asn(t->second, node, node.metadata);
         }
     }
     if (node.val == "untyped")
-        return preprocessResult(node.args[0], aux);
+        return node.args[0];
     else if (node.val == "outer")
-        return preprocessResult(node, aux);
+        return node;
     else {
         for (unsigned i = 0; i < node.args.size(); i++) {
-            node.args[i] =
-                processTypes(preprocessResult(node.args[i], aux)).first;
+            node.args[i] = processTypes(node.args[i], aux);
         }
     }
-    return preprocessResult(node, aux);
+    return node;
+}
+
+preprocessResult processTypes (preprocessResult pr) {
+    return preprocessResult(processTypes(pr.first, pr.second), pr.second);
 }
 
 preprocessResult preprocess(Node n) {
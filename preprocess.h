@@ -84,6 +84,10 @@ class preprocessAux {
 svObj getStorageVars(svObj pre, Node node, std::string prefix="",
                      int index=0);
 
+// The same, filling in the svObj given
+void addStorageVars(svObj &pre, Node node, std::string prefix="",
+                    int index=0);
+
 // Is the type a type of an array?
 bool isArrayType(std::string type);
 
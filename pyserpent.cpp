@@ -4,6 +4,7 @@
 #include <stdio.h>
 #include <iostream>
 #include "funcs.h"
+#include "incremental.h"
 
 #if PY_MAJOR_VERSION >= 3
 #define PY_STRING_FORMAT "y#"
@@ -170,6 +171,53 @@ PYMETHOD(ps_mk_full_signature, FROMSTR, mkFullSignature, pyifyString)
 PYMETHOD(ps_mk_contract_info_decl, FROMSTR, mkContractInfoDecl, pyifyString)
 PYMETHOD(ps_get_prefix, FROMSTR, getPrefix, pyifyInteger)
 
+// A persistent incrementalCompiler, which lives as long as the capsule
+// holding it
+static void ps_free_incremental(PyObject *handle) {
+    delete (incrementalCompiler *)
+        PyCapsule_GetPointer(handle, "incrementalCompiler");
+}
+
+static PyObject * ps_incremental_compiler(PyObject *, PyObject *args) {
+    int threads = 1;
+    if (!PyArg_ParseTuple(args, "|i", &threads))
+        return NULL;
+    incrementalCompiler *c = new incrementalCompiler();
+    c->threads = threads < 1 ? 1 : threads;
+    return PyCapsule_New(c, "incrementalCompiler", ps_free_incremental);
+}
+
+static PyObject * ps_incremental_compile(PyObject *, PyObject *args) {
+    PyObject *handle;
+    const char *command;
+    int len;
+    if (!PyArg_ParseTuple(args, "O" PY_STRING_FORMAT, &handle, &command,
+                          &len))
+        return NULL;
+    incrementalCompiler *c = (incrementalCompiler *)
+        PyCapsule_GetPointer(handle, "incrementalCompiler");
+    if (!c)
+        return NULL;
+    try {
+        return pyifyString(c->compile(std::string(command, len)));
+    }
+    catch (std::string e) {
+        PyErr_SetString(PyExc_Exception, e.c_str());
+        return NULL;
+    }
+}
+
+// Functions reused and redone by the last incremental_compile
+static PyObject * ps_incremental_stats(PyObject *, PyObject *args) {
+    PyObject *handle;
+    if (!PyArg_ParseTuple(args, "O", &handle))
+        return NULL;
+    incrementalCompiler *c = (incrementalCompiler *)
+        PyCapsule_GetPointer(handle, "incrementalCompiler");
+    if (!c)
+        return NULL;
+    return Py_BuildValue("(ii)", c->reused, c->rewritten);
+}
 
 static PyMethodDef PyextMethods[] = {
     {"compile",  ps_compile, METH_VARARGS,
@@ -200,6 +248,12 @@ static PyMethodDef PyextMethods[] = {
         "Make an extern contract info declaration"},
     {"get_prefix",  ps_get_prefix, METH_VARARGS,
         "Get the prefix for a signature declaration (eg. \"foo:[int256]:int256\")"},
+    {"incremental_compiler",  ps_incremental_compiler, METH_VARARGS,
+        "Make a compiler that keeps its work between compilations"},
+    {"incremental_compile",  ps_incremental_compile, METH_VARARGS,
+        "Compile code with an incremental compiler"},
+    {"incremental_stats",  ps_incremental_stats, METH_VARARGS,
+        "Functions reused and recompiled by an incremental compiler's last compile"},
     {NULL, NULL, 0, NULL}        /* Sentinel */
 };
 
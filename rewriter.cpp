@@ -2,420 +2,31 @@
 #include <iostream>
 #include <vector>
 #include <map>
+#include <algorithm>
+#include <chrono>
 #include "util.h"
 #include "lllparser.h"
 #include "bignum.h"
+#include "uint256.h"
 #include "optimize.h"
 #include "rewriteutils.h"
 #include "preprocess.h"
 #include "functions.h"
 #include "opcodes.h"
+#include "rewriter.h"
+#include "macros.h"
 
-// Rewrite rules
-std::string macros[][2] = {
-    {
-        "(seq $x)",
-        "$x"
-    },
-    {
-        "(seq (seq) $x)",
-        "$x"
-    },
-    {
-        "(+= $a $b)",
-        "(set $a (+ $a $b))"
-    },
-    {
-        "(*= $a $b)",
-        "(set $a (* $a $b))"
-    },
-    {
-        "(-= $a $b)",
-        "(set $a (- $a $b))"
-    },
-    {
-        "(/= $a $b)",
-        "(set $a (/ $a $b))"
-    },
-    {
-        "(%= $a $b)",
-        "(set $a (% $a $b))"
-    },
-    {
-        "(^= $a $b)",
-        "(set $a (^ $a $b))"
-    },
-    {
-        "(!= $a $b)",
-        "(iszero (eq $a $b))"
-    },
-    {
-        "(assert $x)",
-        "(jumpi (pc) (iszero $x))"
-    },
-    {
-        "(min $a $b)",
-        "(with $1 $a (with $2 $b (if (slt $1 $2) $1 $2)))"
-    },
-    {
-        "(max $a $b)",
-        "(with $1 $a (with $2 $b (if (slt $1 $2) $2 $1)))"
-    },
-    {
-        "(unsigned_min $a $b)",
-        "(with $1 $a (with $2 $b (if (lt $1 $2) $1 $2)))"
-    },
-    {
-        "(unsigned_max $a $b)",
-        "(with $1 $a (with $2 $b (if (lt $1 $2) $2 $1)))"
-    },
-    {
-        "(if $cond $do (else $else))",
-        "(if $cond $do $else)"
-    },
-    {
-        "(code $code)",
-        "$code"
-    },
-    {
-        "(array $len)",
-        "(with $l $len (with $x (alloc (add 32 (mul 32 $l))) (seq (mstore $x $l) (add $x 32))))"
-    },
-    {
-        "(string $len)",
-        "(with $l $len (with $x (alloc (add 32 $l)) (seq (mstore $x $l) (add $x 32))))"
-    },
-    {
-        "(shrink $arr $sz)",
-        "(mstore (sub $arr 32) $sz)"
-    },
-    {
-        "(slice $arr (= items $start) (= items $end))",  
-        "(with _s $start (with _l (sub $end _s) (with _a (array _l) (seq (mcopy _a (add $arr (mul 32 _s)) (mul 32 _l)) _a))))"
-    },
-    {
-        "(slice $arr (= chars $start) (= chars $end))",  
-        "(with _s $start (with _l (sub $end _s) (with _a (string _l) (seq (mcopy _a (add $arr _s) _l) _a))))"
-    },
-    {
-        "(len $x)",
-        "(mload (sub $x 32))"
-    },
-    {
-        "(ceil32 $x)",
-        "(mul 32 (div (add $x 31) 32))"
-    },
-    {
-        "(while $cond $do)",
-        "(until (iszero $cond) $do)",
-    },
-    {
-        "(while (iszero $cond) $do)",
-        "(until $cond $do)",
-    },
-    {
-        "(if $cond $do)",
-        "(unless (iszero $cond) $do)",
-    },
-    {
-        "(if (iszero $cond) $do)",
-        "(unless $cond $do)",
-    },
-    {
-        "(access (. self storage) $ind)",
-        "(sload $ind)"
-    },
-    {
-        "(access $var $ind)",
-        "(mload (add $var (mul 32 $ind)))"
-    },
-    {
-        "(set (access (. self storage) $ind) $val)",
-        "(sstore $ind $val)"
-    },
-    {
-        "(set (sload $ind) $val)",
-        "(sstore $ind $val)"
-    },
-    {
-        "(set (access $var $ind) $val)",
-        "(mstore (add $var (mul 32 $ind)) $val)"
-    },
-    {
-        "(getch $var $ind)",
-        "(mod (mload (sub (add $var $ind) 31)) 256)"
-    },
-    {
-        "(setch $var $ind $val)",
-        "(mstore8 (add $var $ind) (or (byte 0 $val) (byte 31 $val)))",
-    },
-    {
-        "(send $to $value)",
-        "(~call 0 $to $value 0 0 0 0)"
-    },
-    {
-        "(send $gas $to $value)",
-        "(~call $gas $to $value 0 0 0 0)"
-    },
-    {
-        "(id $0)",
-        "$0"
-    },
-    {
-        "(return (: $x (access $y)))",
-        "(return (: $x arr))"
-    },
-    {
-        "(return (: $x bytes))",
-        "(return (: $x str))"
-    },
-    {
-        "(return (: $x arr))",
-        "(with $0 $x (seq (mstore (sub $0 64) 32) (~return (sub $0 64) (add 64 (= items (mload (sub $0 32)))))))"
-    },
-    {
-        "(return (: $x str))",
-        "(with $0 $x (seq (mstore (sub $0 64) 32) (~return (sub $0 64) (ceil32 (add 64 (= chars (mload (sub $0 32))))))))"
-    },
-    {
-        "(return (: $x $y))",
-        "(return $x)"
-    },
-    {
-        "(return $arr (= $type $sz))",
-        "(with _a $arr (with _size $sz (seq (mstore (sub _a 64) 32) (mstore (sub _a 32) _size) (~return (sub _a 64) (ceil32 (add (= $type _size) 64))))))"
-    },
-    {
-        "(return $arr $sz)",
-        "(error \"when returning you must do return(x) for values, return(x:arr) for arrays or return(x:str) for strings; return(arr, len) by itself is no longer valid. Uses of return(arr, len) should be substituted with return(arr, items=len) or ideally actual arrays.\")"
-    },
-    {
-        "(return $x)",
-        "(seq (set $1 $x) (~return (ref $1) 32))"
-    },
-    {
-        "(&& $x $y)",
-        "(if $x $y 0)"
-    },
-    {
-        "(|| $x $y)",
-        "(with $1 $x (if $1 $1 $y))"
-    },
-    {
-        "(>= $x $y)",
-        "(iszero (slt $x $y))"
-    },
-    {
-        "(<= $x $y)",
-        "(iszero (sgt $x $y))"
-    },
-    {
-        "(create $code)",
-        "(create 0 $code)"
-    },
-    {
-        "(create $endowment $code)",
-        "(with $1 (msize) (create $endowment (get $1) (lll $code (msize))))"
-    },
-    {
-        "(sha3 (: $x arr))",
-        "(with $0 $x (~sha3 $0 (= items (mload (sub $0 32)))))"
-    },
-    {
-        "(sha3 (: $x str))",
-        "(with $0 $x (~sha3 $0 (= chars (mload (sub $0 32)))))"
-    },
-    {
-        "(sha3 $arr (= $type $sz))",
-        "(~sha3 $arr (= $type $sz))"
-    },
-    {
-        "(sha3 $arr $sz)",
-        "(error \"when hashing you must do sha3(x) for values, sha3(arr, items=len) for arrays or sha3(arr, chars=len) for strings; sha3(arr, len) by itself is no longer valid\")"
-    },
-    {
-        "(sha3 $x)",
-        "(seq (set $1 $x) (~sha3 (ref $1) 32))"
-    },
-    {
-        "(sha256 (: $x arr))",
-        "(with $0 $x (_sha256 $0 (= items (mload (sub $0 32)))))"
-    },
-    {
-        "(sha256 (: $x str))",
-        "(with $0 $x (_sha256 $0 (= chars (mload (sub $0 32)))))"
-    },
-    {
-        "(sha256 $arr (= $type $sz))",
-        "(_sha256 $arr (= $type $sz))"
-    },
-    {
-        "(sha256 (: $x str))",
-        "(with $0 $x (_sha256 $0 (= chars (mload (sub $0 32)))))"
-    },
-    {
-        "(sha256 $x)",
-        "(seq (set $1 $x) (_sha256 (ref $1) (= items 1)))",
-    },
-    {
-        "(_sha256 $arr $sz)",
-        "(with $0 $sz (with $1 (alloc 32) (with $gas (add 72 $0) (seq (pop (~call $gas 2 0 $arr $0 (get $1) 32)) (mload (get $1))))))"
-    },
-    {
-        "(sha256 $arr $sz)",
-        "(error \"when hashing you must do sha256(x) for values, sha256(arr, items=len) for arrays or sha256(arr, chars=len) for strings; sha256(arr, len) by itself is no longer valid\")"
-    },
-    {
-        "(ripemd160 (: $x arr))",
-        "(with $0 $x (_ripemd160 $0 (= items (mload (sub $0 32)))))"
-    },
-    {
-        "(ripemd160 (: $x str))",
-        "(with $0 $x (_ripemd160 $0 (= chars (mload (sub $0 32)))))"
-    },
-    {
-        "(ripemd160 $arr (= $type $sz))",
-        "(_ripemd160 $arr (= $type $sz))"
-    },
-    {
-        "(ripemd160 $x)",
-        "(seq (set $1 $x) (_ripemd160 (ref $1) (= items 1)))",
-    },
-    {
-        "(_ripemd160 $arr $sz)",
-        "(with $0 $sz (with $1 (alloc 32) (with $gas (add 720 (mul 4 $0)) (seq (pop (~call $gas 3 0 $arr $0 (get $1) 32)) (mload (get $1))))))"
-    },
-    {
-        "(ripemd160 $arr $sz)",
-        "(error \"when hashing you must do ripemd(x) for values, ripemd160(arr, items=len) for arrays or ripemd160(arr, chars=len) for strings; ripemd160(arr, len) by itself is no longer valid\")"
-    },
-    {
-        "(set chars $x)",
-        "$x",
-    },
-    {
-        "(set items $x)",
-        "(mul $x 32)",
-    },
-    {
-        "(ecrecover $h $v $r $s)",
-        "(with $1 (alloc 160) (seq (mstore (get $1) $h) (mstore (add (get $1) 32) $v) (mstore (add (get $1) 64) $r) (mstore (add (get $1) 96) $s) (pop (~call 3000 1 0 (get $1) 128 (add (get $1) 128) 32)) (mload (add (get $1) 128))))"
-    },
-    {
-        "(inset $x)",
-        "$x"
-    },
-    {
-        "(create $x)",
-        "(with $1 (msize) (create $val (get $1) (lll $code (get $1))))"
-    },
-    {
-        "(with (= $var $val) $cond)",
-        "(with $var $val $cond)"
-    },
-    {
-        "(save $loc (: $array arr))",
-        "(with $0 $array (save $loc $0 (= items (len $0))))"
-    },
-    {
-        "(save $loc (: $string str))",
-        "(with $0 $string (save $loc $0 (= chars (len $0))))"
-    },
-    {
-        "(save $loc $array (= items $count))",
-        "(with $location (ref $loc) (with $end $count (with $i 0 (while (slt $i $end) (seq (sstore (add $i $location) (access $array $i)) (set $i (add $i 1)))))))"
-    },
-    {
-        "(save $loc $array $count)",
-        "(with $location (ref $loc) (with $c $count (with $end (div $c 32) (with $i 0 (seq (while (slt $i $end) (seq (sstore (add $i $location) (access $array $i)) (set $i (add $i 1)))) (sstore (add $i $location) (~and (access $array $i) (sub 0 (exp 256 (sub 32 (mod $c 32)))))))))))"
-    },
-    {
-        "(load $loc (= items $count))",
-        "(with $location (ref $loc) (with $c $count (with $a (array $c) (with $i 0 (seq (while (slt $i $c) (seq (set (access $a $i) (sload (add $location $i))) (set $i (add $i 1)))) $a)))))"
-    },
-    {
-        "(load $loc $count)",
-        "(with $location (ref $loc) (with $c $count (with $a (string $c) (with $i 0 (seq (while (slt $i (div $c 32)) (seq (set (access $a $i) (sload (add $location $i))) (set $i (add $i 1)))) (set (access $a $i) (~and (sload (add $location $i)) (sub 0 (exp 256 (sub 32 (mod $c 32)))))) $a)))))"
-    },
-    {
-        "(safe_call $gas $to $value $datain $datainsz $dataout $dataoutsz)",
-        "(unless (~call $gas $to $value $datain $datainsz $dataout $dataoutsz) (invalid))"
-    },
-    {
-        "(mcopy $to $from $sz)",
-        "(with _sz $sz (with $gas (+ 18 (/ _sz 10)) (safe_call $gas 4 0 $from _sz $to _sz)))"
-    },
-    {
-        "(waste $n)",
-        "(call $n (create (lll (invalid))) 0 0 0 0 0)"
-    },
-    {
-        "(selfdestruct $a)",
-        "(suicide $a)"
-    },
-    {
-        "(~delegatecall $a $b $value $c $d $e $f)",
-        "(~delegatecall $a $b $c $d $e $f)",
-    },
-    { "(. msg sender)", "(caller)" },
-    { "(. msg value)", "(callvalue)" },
-    { "(. msg gas)", "(gas)" },
-    { "(. tx gasprice)", "(gasprice)" },
-    { "(. tx origin)", "(origin)" },
-    { "(. tx gas)", "(error \"Replace tx.gas with msg.gas\")" },
-    { "(. $x balance)", "(balance $x)" },
-    { "self", "(address)" },
-    { "(. block prevhash)", "(blockhash (sub (number) 1))" },
-    { "(fun (. block prevhash) $n)", "(blockhash (sub (number) $n))" },
-    { "(. block coinbase)", "(coinbase)" },
-    { "(. block timestamp)", "(timestamp)" },
-    { "(. block number)", "(number)" },
-    { "(. block difficulty)", "(difficulty)" },
-    { "(. block gaslimit)", "(gaslimit)" },
-    { "stop", "(stop)" },
-    { "---END---", "" } //Keep this line at the end of the list
-};
-
-// Token synonyms
-std::string synonyms[][2] = {
-    { "or", "||" },
-    { "and", "&&" },
-    { "|", "~or" },
-    { "&", "~and" },
-    { "elif", "if" },
-    { "!", "iszero" },
-    { "~", "~not" },
-    { "not", "iszero" },
-    { "+", "add" },
-    { "-", "sub" },
-    { "*", "mul" },
-    { "/", "sdiv" },
-    { "^", "exp" },
-    { "**", "exp" },
-    { "%", "smod" },
-    { "<", "slt" },
-    { ">", "sgt" },
-    { "=", "set" },
-    { "==", "eq" },
-    { ":", "kv" },
-    { "---END---", "" } //Keep this line at the end of the list
-};
-
-std::map<std::string, std::string> synonymMap;
+std::map<std::string, std::string> setterMap;
 
-// Custom setters (need to be registered separately
-// for use with managed storage)
-std::string setters[][2] = {
-    { "+=", "+" },
-    { "-=", "-" },
-    { "*=", "*" },
-    { "/=", "/" },
-    { "%=", "%" },
-    { "^=", "^" },
-    { "---END---", "" } //Keep this line at the end of the list
+// Built-in rules, compiled from the tables in macrotables.cpp once per
+// process and never modified afterwards, so any number of threads can share them
+struct builtinRules {
+    rewriteRuleSet nodeMacros;
+    rewriteRuleSet setterMacros;
+    std::map<Symbol, Symbol> synonymMap;
 };
 
-std::map<std::string, std::string> setterMap;
+const builtinRules &getBuiltinRules();
 
 
 // processes mutable array literals
@@ -441,7 +52,7 @@ Node logTransform(Node node, preprocessAux aux) {
     bool isDataString = false;
     std::string type = "";
     for (unsigned i = 0; i < node.args.size(); i++) {
-        if (node.args[i].val == "=") {
+        if (node.args[i].val == SYM_ASSIGN) {
             std::string v = node.args[i].args[0].val;
             if (v == "data" || v == "datastr" || v == "dataarr") {
                 data = node.args[i].args[1];
@@ -529,12 +140,9 @@ Node string_transform(Node node) {
     o += " (seq (mstore (get $str) "+utd(bin.size())+")";
     for (unsigned i = 0; i < sz; i += 32) {
         unsigned curpos = i;
-        std::string t = "0";
-        for (unsigned j = i; j < i + 32; j++) {
-            uint8_t x = j < sz ? bin[j] : 0;
-            t = decimalMul(t, "256");
-            t = decimalAdd(t, unsignedToDecimal(x));
-        }
+        std::vector<uint8_t> chunk(32, 0);
+        for (unsigned j = i; j < i + 32 && j < sz; j++) chunk[j - i] = bin[j];
+        std::string t = u256ToDecimal(u256FromBytes(chunk));
         o += " (mstore (add (get $str) "+utd(curpos + 32)+") "+t+")";
     }
     o += " (add (get $str) 32)))";
@@ -563,7 +171,7 @@ Node prefixTransform(Node node, preprocessAux aux) {
         functionName = funNode.val;
     }
     // Determine the functionPrefix and sig if calling self
-    if (callee.val == "self") {
+    if (callee.val == SYM_SELF) {
         if (!aux.interns.count(functionName))
             err("Invalid call: "+functionName, m);
         return asn("mul",
@@ -618,7 +226,7 @@ Node dotTransform(Node node, preprocessAux aux) {
     for (unsigned i = 1; i < node.args.size(); i++) {
         fnargs.push_back(node.args[i]);
         Node arg = fnargs.back();
-        if (arg.val == "=" || arg.val == "set") {
+        if (arg.val == SYM_ASSIGN || arg.val == SYM_SET) {
             if (arg.args[0].val == "as")
                 err("As keyword deprecated. To disambiguate overloaded "
                     "definitions, use the foo::sig syntax instead", m);
@@ -642,7 +250,7 @@ Node dotTransform(Node node, preprocessAux aux) {
     strvec argTypes;
     std::string outType;
     // Determine the functionPrefix and sig if calling self
-    if (callee.val == "self") {
+    if (callee.val == SYM_SELF) {
         if (!aux.interns.count(functionName))
             err("Invalid call: "+functionName, m);
         functionPrefix = aux.interns[functionName].id;
@@ -835,220 +443,530 @@ Node storageTransform(Node node, preprocessAux aux,
     else return astnode("sload", o, node.metadata);
 }
 
+// Rewrite profiling (see rewriteProfile). A run of a level is counted
+// in a levelProfile, rules by the address of their group since naming
+// them is slow, and the counts go into the stats by name at its end
+thread_local rewriteStats *profileStats = 0;
+
+rewriteProfile::rewriteProfile(rewriteStats *stats) {
+    outer = profileStats;
+    profileStats = stats;
+}
+
+rewriteProfile::~rewriteProfile() {
+    profileStats = outer;
+}
+
+// Matches of each rule in a group (the rules with the same head), and
+// the time they took. A rule is only tried if no rule before it in the
+// group matched, so that is how its attempts are worked out
+class groupCounts {
+    public:
+        groupCounts() {
+            lookups = 0;
+        }
+        unsigned long long lookups;
+        std::vector<unsigned long long> matches;
+        std::vector<double> seconds;
+};
+
+class levelProfile {
+    public:
+        // The custom macros of a priority
+        levelProfile(int priority);
+        // The setters or the built-in rules
+        levelProfile(const char *name);
+        ~levelProfile();
+        bool active;
+        std::string name;
+        unsigned long long visits;
+        unsigned long long iterations;
+        std::chrono::steady_clock::time_point start;
+        std::map<const std::vector<rewriteRule> *, groupCounts> groups;
+        // Special transforms are tried on every visit, and synonyms
+        // looked up for every node visited
+        std::map<std::string, rewriteRuleStats> specials;
+        unsigned long long synonymLookups;
+        std::map<Symbol, rewriteRuleStats> synonyms;
+        levelProfile *outer;
+    private:
+        void begin(const std::string &levelName);
+};
+
+// The level that this thread's rewriter is in, if it is being profiled
+thread_local levelProfile *profiledLevel = 0;
+
+levelProfile::levelProfile(int priority) {
+    active = profileStats != 0;
+    if (active) begin("macros priority " + unsignedToDecimal(priority));
+}
+
+levelProfile::levelProfile(const char *name) {
+    active = profileStats != 0;
+    if (active) begin(name);
+}
+
+void levelProfile::begin(const std::string &levelName) {
+    name = levelName;
+    visits = 0;
+    iterations = 0;
+    synonymLookups = 0;
+    outer = profiledLevel;
+    profiledLevel = this;
+    // Levels are listed in the order they started
+    profileStats->level(name);
+    start = std::chrono::steady_clock::now();
+}
+
+levelProfile::~levelProfile() {
+    if (!active) return;
+    profiledLevel = outer;
+    rewriteLevelStats &l = profileStats->level(name);
+    l.visits += visits;
+    l.iterations += iterations;
+    l.seconds += secondsSince(start);
+    std::map<const std::vector<rewriteRule> *, groupCounts>::iterator g;
+    for (g = groups.begin(); g != groups.end(); g++) {
+        const std::vector<rewriteRule> &rules = *g->first;
+        unsigned long long tried = g->second.lookups;
+        for (unsigned i = 0; i < rules.size(); i++) {
+            rewriteRuleStats &r = l.rules[printSimple(rules[i].pattern)
+                + " -> " + printSimple(rules[i].substitution)];
+            r.attempts += tried;
+            r.matches += g->second.matches[i];
+            r.seconds += g->second.seconds[i];
+            tried -= g->second.matches[i];
+        }
+    }
+    std::map<std::string, rewriteRuleStats>::iterator s;
+    for (s = specials.begin(); s != specials.end(); s++) {
+        rewriteRuleStats &r = l.rules[s->first];
+        r.attempts += visits;
+        r.matches += s->second.matches;
+        r.seconds += s->second.seconds;
+    }
+    std::map<Symbol, rewriteRuleStats>::iterator y;
+    for (y = synonyms.begin(); y != synonyms.end(); y++) {
+        rewriteRuleStats &r = l.rules["synonym " + y->first.str() + " -> "
+            + getBuiltinRules().synonymMap.find(y->first)->second.str()];
+        r.attempts += synonymLookups;
+        r.matches += y->second.matches;
+        r.seconds += y->second.seconds;
+    }
+}
+
+// Counts and times a special transform of mainTransform, if the level
+// is being profiled
+class transformTimer {
+    public:
+        transformTimer(const char *name) {
+            level = profiledLevel;
+            if (level) {
+                transform = name;
+                start = std::chrono::steady_clock::now();
+            }
+        }
+        ~transformTimer() {
+            if (!level) return;
+            rewriteRuleStats &r = level->specials[transform];
+            r.matches++;
+            r.seconds += secondsSince(start);
+        }
+    private:
+        levelProfile *level;
+        const char *transform;
+        std::chrono::steady_clock::time_point start;
+};
+
+rewriteLevelStats &rewriteStats::level(const std::string &name) {
+    for (unsigned i = 0; i < levels.size(); i++) {
+        if (levels[i].name == name) return levels[i];
+    }
+    levels.push_back(rewriteLevelStats());
+    levels.back().name = name;
+    return levels.back();
+}
+
+bool slowerRule(const std::pair<std::string, rewriteRuleStats> &a,
+                const std::pair<std::string, rewriteRuleStats> &b) {
+    if (a.second.seconds != b.second.seconds)
+        return a.second.seconds > b.second.seconds;
+    return a.second.matches > b.second.matches;
+}
+
+std::string rewriteStats::report() const {
+    std::string o;
+    char buf[256];
+    for (unsigned i = 0; i < levels.size(); i++) {
+        const rewriteLevelStats &l = levels[i];
+        std::vector<std::pair<std::string, rewriteRuleStats> > rules;
+        unsigned long long attempts = 0, matches = 0;
+        std::map<std::string, rewriteRuleStats>::const_iterator it;
+        for (it = l.rules.begin(); it != l.rules.end(); it++) {
+            attempts += it->second.attempts;
+            matches += it->second.matches;
+            if (it->second.attempts) rules.push_back(*it);
+        }
+        std::sort(rules.begin(), rules.end(), slowerRule);
+        sprintf(buf, "%s: %llu visits, %llu iterations, %llu attempts, "
+                "%llu matches, %.3f ms\n", l.name.c_str(), l.visits,
+                l.iterations, attempts, matches, l.seconds * 1000);
+        o += buf;
+        o += "    attempts    matches         ms  rule\n";
+        for (unsigned j = 0; j < rules.size(); j++) {
+            const rewriteRuleStats &r = rules[j].second;
+            sprintf(buf, "  %10llu %10llu %10.3f  ", r.attempts, r.matches,
+                    r.seconds * 1000);
+            o += buf + rules[j].first + "\n";
+        }
+    }
+    return o;
+}
+
 // Basic rewrite rule execution
-std::pair<Node, bool> rulesTransform(Node node, rewriteRuleSet macros) {
-    std::string prefix = "_temp_"+mkUniqueToken();
-    bool changed = false;
-    if (!macros.ruleLists.count(node.val))
+std::pair<Node, bool> rulesTransform(Node node, const rewriteRuleSet &macros) {
+    std::map<Symbol, discriminationTree>::const_iterator index =
+        macros.index.find(node.val);
+    if (index == macros.index.end())
         return std::pair<Node, bool>(node, false);
-    std::vector<rewriteRule> rules = macros.ruleLists[node.val];
-    for (unsigned pos = 0; pos < rules.size(); pos++) {
-        rewriteRule macro = rules[pos];
-        matchResult mr = match(macro.pattern, node);
-        if (mr.success) {
-            node = subst(macro.substitution, mr.map, prefix, node.metadata);
-            if (node.val == "error")
-                err(node.args[0].val, node.metadata);
-            std::pair<Node, bool> o = rulesTransform(node, macros);
-            o.second = true;
-            return o;
+    const std::vector<rewriteRule> &group =
+        macros.ruleLists.find(node.val)->second;
+    groupCounts *counts = 0;
+    std::chrono::steady_clock::time_point start;
+    if (profiledLevel) {
+        counts = &profiledLevel->groups[&group];
+        if (!counts->lookups++) {
+            counts->matches.resize(group.size());
+            counts->seconds.resize(group.size());
         }
+        start = std::chrono::steady_clock::now();
     }
-    return std::pair<Node, bool>(node, changed);
+    // The index finds the rule, matchRule() then binds its variables
+    int pos = index->second.firstMatch(node);
+    if (pos < 0)
+        return std::pair<Node, bool>(node, false);
+    const rewriteRule &macro = group[pos];
+    const Node *fixed[16];
+    std::vector<const Node *> more(macro.slots > 16 ? macro.slots : 0);
+    const Node **slots = macro.slots > 16 ? &more[0] : fixed;
+    matchRule(macro, node, slots);
+    std::string prefix = "_temp_"+mkUniqueToken();
+    // The slots point into the old node
+    Node out = substRule(macro, slots, prefix, node.metadata);
+    node = out;
+    if (counts) {
+        counts->matches[pos]++;
+        counts->seconds[pos] += secondsSince(start);
+    }
+    if (node.val == SYM_ERROR)
+        err(node.args[0].val, node.metadata);
+    std::pair<Node, bool> o = rulesTransform(node, macros);
+    o.second = true;
+    return o;
 }
 
 std::pair<Node, bool> synonymTransform(Node node) {
     bool changed = false;
-    if (node.type == ASTNODE && synonymMap.count(node.val)) {
-        node.val = synonymMap[node.val];
-        changed = true;
+    if (node.type == ASTNODE) {
+        const std::map<Symbol, Symbol> &synonymMap =
+            getBuiltinRules().synonymMap;
+        std::chrono::steady_clock::time_point start;
+        if (profiledLevel) {
+            profiledLevel->synonymLookups++;
+            start = std::chrono::steady_clock::now();
+        }
+        std::map<Symbol, Symbol>::const_iterator it = synonymMap.find(node.val);
+        if (it != synonymMap.end()) {
+            if (profiledLevel) {
+                rewriteRuleStats &r = profiledLevel->synonyms[node.val];
+                r.matches++;
+                r.seconds += secondsSince(start);
+            }
+            node.val = it->second;
+            changed = true;
+        }
     }
     return std::pair<Node, bool>(node, changed);
 }
 
-rewriteRuleSet nodeMacros;
-rewriteRuleSet setterMacros;
-
 bool dontDescend(std::string s) {
     return s == "macro" || s == "comment" || s == "outer";
 }
 
-// Recursively applies any set of rewrite rules
-std::pair<Node, bool> apply_rules_iter(preprocessResult pr, rewriteRuleSet rules) {
+// Each rewrite in apply_rules gets its own tag. A child list stamped
+// with the tag holds only nodes in normal form for the rewrite; since
+// rewriting a subtree depends on nothing but the subtree and the (fixed)
+// preprocessAux, such lists are never looked inside again
+std::atomic<uint32_t> lastNormalTag(0);
+
+uint32_t mkNormalTag() {
+    return lastNormalTag.fetch_add(1) + 1;
+}
+
+// Visits made and saved on this thread that apply_rules has not yet
+// added to the totals
+thread_local rewriteVisits pendingVisits;
+std::atomic<unsigned long long> visitsMade(0);
+std::atomic<unsigned long long> visitsSaved(0);
+
+rewriteVisits rewriteVisitCounts() {
+    rewriteVisits o;
+    o.made = visitsMade.load();
+    o.saved = visitsSaved.load();
+    return o;
+}
+
+// Stamps the children of a node, which are all in normal form now
+void markNormal(const Node &node, uint32_t tag) {
+    uint32_t nodes = 0;
+    for (unsigned i = 0; i < node.args.size(); i++) {
+        const NodeList &a = node.args[i].args;
+        nodes += 1 + (a.normalTag() == tag ? a.normalNodes() : 0);
+    }
+    node.args.setNormalTag(tag, nodes);
+}
+
+// Are the children of a node known to be in normal form? Skipping them
+// saves a visit to every node under it
+bool isNormal(const Node &node, uint32_t tag) {
+    if (node.args.normalTag() != tag) return false;
+    pendingVisits.saved += node.args.normalNodes();
+    return true;
+}
+
+// Recursively applies any set of rewrite rules, leaving the node in
+// normal form. The children are brought into normal form first, and the
+// node is only looked at again if one of them changed, so a rewrite costs
+// a revisit of the nodes above it rather than a pass over the program
+std::pair<Node, bool> apply_rules_iter(Node node,
+                                       const rewriteRuleSet &rules,
+                                       uint32_t tag) {
     bool changed = false;
-    Node node = pr.first;
-    if (dontDescend(node.val))
-        return std::pair<Node, bool>(node, false);
-    std::pair<Node, bool> o = rulesTransform(node, rules);
-    node = o.first;
-    changed = changed || o.second;
-    if (node.type == ASTNODE) {
-        for (unsigned i = 0; i < node.args.size(); i++) {
-            std::pair<Node, bool> r =
-                apply_rules_iter(preprocessResult(node.args[i], pr.second), rules);
-            node.args[i] = r.first;
-            changed = changed || r.second;
+    while (!dontDescend(node.val)) {
+        pendingVisits.made++;
+        if (profiledLevel) profiledLevel->visits++;
+        std::pair<Node, bool> o = rulesTransform(node, rules);
+        node = o.first;
+        changed = changed || o.second;
+        bool argsChanged = false;
+        if (node.type == ASTNODE && !isNormal(node, tag)) {
+            for (unsigned i = 0; i < node.args.size(); i++) {
+                const Node &arg = static_cast<const NodeList &>(node.args)[i];
+                std::pair<Node, bool> r = apply_rules_iter(arg, rules, tag);
+                if (r.second) {
+                    node.args[i] = r.first;
+                    argsChanged = true;
+                }
+            }
+            markNormal(node, tag);
         }
+        if (!argsChanged) break;
+        changed = true;
+        if (profiledLevel) profiledLevel->iterations++;
     }
     return std::pair<Node, bool>(node, changed);
 }
 
-// Recursively applies rewrite rules and other primary transformations
-std::pair<Node, bool> mainTransform(preprocessResult pr) {
+// Recursively applies rewrite rules and other primary transformations,
+// leaving the node in normal form the same way apply_rules_iter does
+std::pair<Node, bool> mainTransform(Node node, const preprocessAux &aux,
+                                    uint32_t tag) {
     bool changed = false;
-    Node node = pr.first;
-
-    // Anything inside "outer" should be treated as a separate program
-    // and thus recursively compiled in its entirety
-    if (node.val == "outer") {
-        node = apply_rules(preprocess(node.args[0]));
-        changed = true;
-    }
+    while (1) {
+        pendingVisits.made++;
+        if (profiledLevel) profiledLevel->visits++;
+        bool step = false;
+        // Anything inside "outer" should be treated as a separate program
+        // and thus recursively compiled in its entirety
+        if (node.val == SYM_OUTER) {
+            transformTimer timer("outer");
+            node = apply_rules(preprocess(node.args[0]));
+            step = true;
+        }
 
-    // Don't descend into comments, macros and inner scopes
-    if (dontDescend(node.val))
-        return std::pair<Node, bool>(node, changed);
+        // Don't descend into comments, macros and inner scopes
+        if (dontDescend(node.val)) {
+            changed = changed || step;
+            break;
+        }
 
-    // Special storage transformation
-    if (isNodeStorageVariable(node)) {
-        node = storageTransform(node, pr.second);
-        changed = true;
-    }
-    if (node.val == "ref" && isNodeStorageVariable(node.args[0])) {
-        node = storageTransform(node.args[0], pr.second, false, true);
-        changed = true;
-    }
-    if (node.val == "=" && isNodeStorageVariable(node.args[0])) {
-        Node t = storageTransform(node.args[0], pr.second);
-        if (t.val == "sload") {
-            std::vector<Node> o;
-            o.push_back(t.args[0]);
-            o.push_back(node.args[1]);
-            node = astnode("sstore", o, node.metadata);
+        // Special storage transformation
+        if (isNodeStorageVariable(node)) {
+            transformTimer timer("storageTransform");
+            node = storageTransform(node, aux);
+            step = true;
         }
-        changed = true;
-    }
-    // Main code
-    std::pair<Node, bool> pnb = synonymTransform(node);
-    node = pnb.first;
-    changed = changed || pnb.second;
-    // std::cerr << priority << " " << macros.size() << "\n";
-    std::pair<Node, bool> pnc = rulesTransform(node, nodeMacros);
-    node = pnc.first;
-    changed = changed || pnc.second;
+        if (node.val == SYM_REF && isNodeStorageVariable(node.args[0])) {
+            transformTimer timer("storageTransform (ref)");
+            node = storageTransform(node.args[0], aux, false, true);
+            step = true;
+        }
+        if (node.val == SYM_ASSIGN && isNodeStorageVariable(node.args[0])) {
+            transformTimer timer("storageTransform (=)");
+            Node t = storageTransform(node.args[0], aux);
+            if (t.val == SYM_SLOAD) {
+                std::vector<Node> o;
+                o.push_back(t.args[0]);
+                o.push_back(node.args[1]);
+                node = astnode("sstore", o, node.metadata);
+            }
+            step = true;
+        }
+        // Main code
+        std::pair<Node, bool> pnb = synonymTransform(node);
+        node = pnb.first;
+        step = step || pnb.second;
+        // std::cerr << priority << " " << macros.size() << "\n";
+        std::pair<Node, bool> pnc =
+            rulesTransform(node, getBuiltinRules().nodeMacros);
+        node = pnc.first;
+        step = step || pnc.second;
 
 
-    // Special transformations
-    if (node.val == "log") {
-        node = logTransform(node, pr.second);
-        changed = true;
-    }
-    if (node.val == "array_lit") {
-        node = array_lit_transform(node);
-        changed = true;
-    }
-    if (node.val == "fun" && node.args[0].val == ".") {
-        node = dotTransform(node, pr.second);
-        changed = true;
-    }
-    if (node.val == "prefix" && node.type == ASTNODE) {
-        node = prefixTransform(node, pr.second);
-        changed = true;
-    }
-    if (node.val == "text") {
-        node = string_transform(node);
-        changed = true;
-    }
-    if (node.type == ASTNODE) {
-		unsigned i = 0;
-        // Arg 0 of all of these is a variable, so should not be changed
-        if (node.val == "set" || node.val == "ref" 
-                || node.val == "get" || node.val == "with") {
-            if (node.args[0].type == TOKEN && 
-                    node.args[0].val.size() > 0 && node.args[0].val[0] != '\'') {
-                node.args[0].val = "'" + node.args[0].val;
-                changed = true;
+        // Special transformations
+        if (node.val == SYM_LOG) {
+            transformTimer timer("logTransform");
+            node = logTransform(node, aux);
+            step = true;
+        }
+        if (node.val == SYM_ARRAY_LIT) {
+            transformTimer timer("array_lit_transform");
+            node = array_lit_transform(node);
+            step = true;
+        }
+        if (node.val == SYM_FUN && node.args[0].val == SYM_DOT) {
+            transformTimer timer("dotTransform");
+            node = dotTransform(node, aux);
+            step = true;
+        }
+        if (node.val == SYM_PREFIX && node.type == ASTNODE) {
+            transformTimer timer("prefixTransform");
+            node = prefixTransform(node, aux);
+            step = true;
+        }
+        if (node.val == SYM_TEXT) {
+            transformTimer timer("string_transform");
+            node = string_transform(node);
+            step = true;
+        }
+        if (node.type == ASTNODE) {
+            unsigned i = 0;
+            // Arg 0 of all of these is a variable, so should not be changed
+            if (node.val == SYM_SET || node.val == SYM_REF 
+                    || node.val == SYM_GET || node.val == SYM_WITH) {
+                if (node.args[0].type == TOKEN && 
+                        node.args[0].val.size() > 0 && node.args[0].val[0] != '\'') {
+                    transformTimer timer("quote variable");
+                    node.args[0].val = "'" + node.args[0].val;
+                    step = true;
+                }
+                i = 1;
+            }
+            // Recursively process children, unless they are known to be in
+            // normal form already. A list with a variable in front only
+            // counts as normal once the variable is quoted
+            if (!isNormal(node, tag)) {
+                bool quoted = i == 0 || (node.args[0].type == TOKEN
+                                         && node.args[0].val.size() > 0
+                                         && node.args[0].val[0] == '\'');
+                for (; i < node.args.size(); i++) {
+                    const Node &arg = static_cast<const NodeList &>(node.args)[i];
+                    std::pair<Node, bool> r = mainTransform(arg, aux, tag);
+                    if (r.second) {
+                        node.args[i] = r.first;
+                        step = true;
+                    }
+                }
+                if (quoted) markNormal(node, tag);
             }
-            i = 1;
         }
-        // Recursively process children
-        for (; i < node.args.size(); i++) {
-            std::pair<Node, bool> r =
-                mainTransform(preprocessResult(node.args[i], pr.second));
-            node.args[i] = r.first;
-            changed = changed || r.second;
+        // Add leading ' to variable names, and wrap them inside get
+        else if (node.type == TOKEN && !isNumberLike(node)) {
+            if (node.val.size() && node.val[0] != '\'' && node.val[0] != '$') {
+                transformTimer timer("get variable");
+                Node n = astnode("get", tkn("'"+node.val), node.metadata);
+                node = n;
+                step = true;
+            }
         }
-    }
-    // Add leading ' to variable names, and wrap them inside get
-    else if (node.type == TOKEN && !isNumberLike(node)) {
-        if (node.val.size() && node.val[0] != '\'' && node.val[0] != '$') {
-            Node n = astnode("get", tkn("'"+node.val), node.metadata);
-            node = n;
-            changed = true;
+        // Convert all numbers to normalized form
+        else if (node.type == TOKEN && isNumberLike(node) && !isDecimal(node.val)) {
+            transformTimer timer("normalize number");
+            node.val = strToNumeric(node.val, 32);
+            step = true;
         }
-    }
-    // Convert all numbers to normalized form
-    else if (node.type == TOKEN && isNumberLike(node) && !isDecimal(node.val)) {
-        node.val = strToNumeric(node.val, 32);
+        if (!step) break;
         changed = true;
+        if (profiledLevel) profiledLevel->iterations++;
     }
     return std::pair<Node, bool>(node, changed);
 }
 
-// Do some preprocessing to convert all of our macro lists into compiled
-// forms that can then be reused
-void parseMacros() {
-    for (int i = 0; i < 9999; i++) {
-        std::vector<Node> o;
-        if (macros[i][0] == "---END---") break;
-        nodeMacros.addRule(rewriteRule(
-            parseLLL(macros[i][0]),
-            parseLLL(macros[i][1])
-        ));
-    }
-    for (int i = 0; i < 9999; i++) {
-        std::vector<Node> o;
-        if (setters[i][0] == "---END---") break;
-        setterMacros.addRule(rewriteRule(
-            asn(setters[i][0], tkn("$x"), tkn("$y")),
-            asn("=", tkn("$x"), asn(setters[i][1], tkn("$x"), tkn("$y")))
-        ));
-    }
-    for (int i = 0; i < 9999; i++) {
-        if (synonyms[i][0] == "---END---") break;
-        synonymMap[synonyms[i][0]] = synonyms[i][1];
+// Rebuilds a node of a rule that mkmacros parsed, from the preorder
+// table it wrote
+Node readMacroNode(unsigned &pos) {
+    const macroNode &m = macroNodes[pos++];
+    Metadata met(mainFile(), m.ln, m.ch);
+    if (m.args < 0) return token(Symbol(m.val), met);
+    std::vector<Node> args;
+    for (int i = 0; i < m.args; i++) args.push_back(readMacroNode(pos));
+    return astnode(Symbol(m.val), args, met);
+}
+
+void readMacroRules(const macroRule *table, unsigned count,
+                    rewriteRuleSet &o) {
+    for (unsigned i = 0; i < count; i++) {
+        unsigned p = table[i].pattern, s = table[i].substitution;
+        Node pattern = readMacroNode(p);
+        o.addRule(rewriteRule(pattern, readMacroNode(s)));
     }
 }
 
+// Convert all of our macro lists into compiled forms that can then be
+// reused. The rules were parsed when the compiler was built, so this
+// only has to put the nodes together
+builtinRules parseMacros() {
+    builtinRules o;
+    readMacroRules(nodeMacroTable, nodeMacroCount, o.nodeMacros);
+    readMacroRules(setterMacroTable, setterMacroCount, o.setterMacros);
+    for (unsigned i = 0; i < synonymCount; i++)
+        o.synonymMap[Symbol(synonymTable[i][0])] = Symbol(synonymTable[i][1]);
+    return o;
+}
+
+// Initialization of a function-local static is thread-safe, so the
+// first compilation to get here builds the rules and any others wait
+const builtinRules &getBuiltinRules() {
+    static const builtinRules rules = parseMacros();
+    return rules;
+}
+
 Node apply_rules(preprocessResult pr) {
-    // If the rewrite rules have not yet been parsed, parse them
-    if (!nodeMacros.ruleLists.size()) parseMacros();
     // Iterate over macros by priority list
     std::map<int, rewriteRuleSet >::iterator it;
-    std::pair<Node, bool> r;
     for(it=pr.second.customMacros.begin();
         it != pr.second.customMacros.end(); it++) {
-        while (1) {
-            // std::cerr << "STARTING ARI CYCLE: " << (*it).first <<"\n";
-            // std::cerr << printAST(pr.first) << "\n";
-            r = apply_rules_iter(pr, (*it).second);
-            pr.first = r.first;
-            if (!r.second) break;
-        }
+        levelProfile level((*it).first);
+        pr.first = apply_rules_iter(pr.first, (*it).second,
+                                    mkNormalTag()).first;
     }
-    // Apply setter macros
-    while (1) {
-        r = apply_rules_iter(pr, setterMacros);
-        pr.first = r.first;
-        if (!r.second) break;
+    // Apply setter macros (building the rules first if this is the
+    // first compilation, so that a profile does not count it)
+    const builtinRules &builtin = getBuiltinRules();
+    {
+        levelProfile level("setters");
+        pr.first = apply_rules_iter(pr.first, builtin.setterMacros,
+                                    mkNormalTag()).first;
     }
     // Apply all other mactos
-    while (1) {
-        r = mainTransform(pr);
-        pr.first = r.first;
-        if (!r.second) break;
+    {
+        levelProfile level("builtin");
+        pr.first = mainTransform(pr.first, pr.second, mkNormalTag()).first;
     }
-    return r.first;
+    visitsMade += pendingVisits.made;
+    visitsSaved += pendingVisits.saved;
+    pendingVisits = rewriteVisits();
+    return pr.first;
 }
 
 // Pre-validation
@@ -1085,7 +1003,7 @@ Node postValidate(Node inp) {
         inp.val = inp.val.substr(1);
     }
     if (inp.type == ASTNODE) {
-        if (inp.val == ".")
+        if (inp.val == SYM_DOT)
             err("Invalid object member (ie. a foo.bar not mapped to anything)",
                 inp.metadata);
         else if (opcode(inp.val) >= 0) {
@@ -1114,13 +1032,53 @@ Node postValidate(Node inp) {
 
 
 Node rewriteChunk(Node inp) {
-    return postValidate(optimize(apply_rules(
-                        preprocessResult(
-                        validate(inp), preprocessAux()))));
+    compilationScope scope;
+    phaseScope phase("rewrite", inp);
+    {
+        phaseScope p("validate", inp);
+        inp = validate(inp);
+    }
+    Node o = rewritePreprocessed(preprocessResult(inp, preprocessAux()));
+    phase.out(o);
+    return o;
+}
+
+Node rewritePreprocessed(preprocessResult pr) {
+    Node o;
+    {
+        phaseScope phase("apply_rules", pr.first);
+        o = apply_rules(pr);
+        phase.out(o);
+    }
+    {
+        phaseScope phase("optimize", o);
+        o = optimize(o);
+        phase.out(o);
+    }
+    phaseScope phase("postValidate", o);
+    o = postValidate(o);
+    phase.out(o);
+    return o;
 }
 
 Node rewrite(Node inp) {
-    return postValidate(optimize(apply_rules(preprocess(flattenSeq(inp)))));
+    compilationScope scope;
+    phaseScope phase("rewrite", inp);
+    Node o;
+    {
+        phaseScope p("flattenSeq", inp);
+        o = flattenSeq(inp);
+        p.out(o);
+    }
+    preprocessResult pr;
+    {
+        phaseScope p("preprocess", o);
+        pr = preprocess(o);
+        p.out(pr.first);
+    }
+    o = rewritePreprocessed(pr);
+    phase.out(o);
+    return o;
 }
 
 using namespace std;
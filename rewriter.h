@@ -6,11 +6,83 @@
 #include <vector>
 #include <map>
 #include "util.h"
+#include "preprocess.h"
 
 // Applies rewrite rules
 Node rewrite(Node inp);
 
+// The rewrite steps that follow preprocessing
+Node rewritePreprocessed(preprocessResult pr);
+
 // Applies rewrite rules adding without wrapper
 Node rewriteChunk(Node inp);
 
+// Node visits the rewriter has made, and visits it saved by skipping
+// subtrees it already knew to be in normal form
+class rewriteVisits {
+    public:
+        rewriteVisits() {
+            made = 0;
+            saved = 0;
+        }
+        unsigned long long made;
+        unsigned long long saved;
+};
+
+// Totals over every rewrite this process has done so far
+rewriteVisits rewriteVisitCounts();
+
+// What the rewriter did with one rule or special transform: how often
+// it was tried, how often it applied, and the time spent applying it
+class rewriteRuleStats {
+    public:
+        rewriteRuleStats() {
+            attempts = 0;
+            matches = 0;
+            seconds = 0;
+        }
+        unsigned long long attempts;
+        unsigned long long matches;
+        double seconds;
+};
+
+// One level of apply_rules: the custom macros of one priority, the
+// setters, or the built-in rules along with the special transforms
+class rewriteLevelStats {
+    public:
+        rewriteLevelStats() {
+            visits = 0;
+            iterations = 0;
+            seconds = 0;
+        }
+        std::string name;
+        // Nodes transformed, and how many times a node had to be
+        // transformed again because it or one of its children changed
+        unsigned long long visits;
+        unsigned long long iterations;
+        double seconds;
+        // By rule ("pattern -> substitution") or transform name
+        std::map<std::string, rewriteRuleStats> rules;
+};
+
+class rewriteStats {
+    public:
+        // Levels in the order they first ran
+        std::vector<rewriteLevelStats> levels;
+        rewriteLevelStats &level(const std::string &name);
+        // The levels, with their rules by time spent
+        std::string report() const;
+};
+
+// Adds up what the rewriter does on this thread into the stats for as
+// long as it lives (nothing if they are null). Rewriting runs at full
+// speed when no profile is open
+class rewriteProfile {
+    public:
+        rewriteProfile(rewriteStats *stats);
+        ~rewriteProfile();
+    private:
+        rewriteStats *outer;
+};
+
 #endif
@@ -53,14 +53,19 @@ std::map<std::string, bool> reservedWords = create_map<std::string,bool>
     ("words", true)
     ("string", true);
 
+bool buildVfMap() {
+    for (int i = 0; ; i++) {
+        if (validFunctions[i][0] == "---END---") break;
+        vfMap[validFunctions[i][0]] = true;
+    }
+    return true;
+}
+
 // Is a function name one of the valid functions above?
 bool isValidFunctionName(std::string f) {
-    if (vfMap.size() == 0) {
-        for (int i = 0; ; i++) {
-            if (validFunctions[i][0] == "---END---") break;
-            vfMap[validFunctions[i][0]] = true;
-        }
-    }
+    // Filled on first use; the static makes that thread-safe
+    static const bool done = buildVfMap();
+    (void)done;
     return vfMap.count(f);
 }
 
@@ -89,7 +94,7 @@ std::vector<Node> listfyStorageAccess(Node node) {
             }
             return outrev;
         }
-        if (nodez.back().val == ".")
+        if (nodez.back().val == SYM_DOT)
             nodez.back().args[1].val = "--" + nodez.back().args[1].val;
         if (nodez.back().args.size() == 0)
             err("Error parsing storage variable statement", node.metadata);
@@ -105,16 +110,15 @@ std::vector<Node> listfyStorageAccess(Node node) {
 // self.cow
 // self.horse[0]
 // self.a[6][7][self.storage[3]].chicken[9]
-bool isNodeStorageVariable(Node node) {
-    std::vector<Node> nodez;
-    nodez.push_back(node);
+bool isNodeStorageVariable(const Node &node) {
+    const Node *cur = &node;
     while (1) {
-        if (nodez.back().type == TOKEN) return false;
-        if (nodez.back().args.size() == 0) return false;
-        if (nodez.back().val != "." && nodez.back().val != "access")
+        if (cur->type == TOKEN) return false;
+        if (cur->args.size() == 0) return false;
+        if (cur->val != SYM_DOT && cur->val != SYM_ACCESS)
             return false;
-        if (nodez.back().args[0].val == "self") return true;
-        nodez.push_back(nodez.back().args[0]);
+        if (cur->args[0].val == SYM_SELF) return true;
+        cur = &cur->args[0];
     }
 }
 
@@ -124,7 +128,7 @@ bool isNodeStorageVariable(Node node) {
 // Returns two values. First, a boolean to determine whether the node matches
 // the pattern, second, if the node does match then a map mapping variables
 // in the pattern to nodes
-matchResult match(Node p, Node n) {
+matchResult match(const Node &p, const Node &n) {
     matchResult o;
     o.success = false;
     if (p.type == TOKEN) {
@@ -156,20 +160,105 @@ matchResult match(Node p, Node n) {
 }
 
 
+// Patterns are split into symbols the way match() compares them: a token
+// against a token with the same text, a node against a node with the
+// same name and number of arguments, and a variable against anything
+bool isPatternVariable(const Node &p) {
+    return p.type == TOKEN && (p.val[0] == '$' || p.val[0] == '@');
+}
+
+std::pair<int, Symbol> symbolKey(const Node &n) {
+    return std::make_pair(n.type == TOKEN ? -1 : (int)n.args.size(), n.val);
+}
+
+int discriminationTree::state::find(const std::pair<int, Symbol> &key)
+        const {
+    for (unsigned i = 0; i < next.size(); i++) {
+        if (next[i].first == key) return next[i].second;
+    }
+    return -1;
+}
+
+void discriminationTree::insert(const Node &pattern, unsigned rule) {
+    std::vector<const Node *> pending(1, &pattern);
+    unsigned s = 0;
+    while (1) {
+        if (states[s].minRule > rule) states[s].minRule = rule;
+        if (!pending.size()) break;
+        const Node *p = pending.back();
+        pending.pop_back();
+        int to;
+        if (isPatternVariable(*p)) {
+            to = states[s].wildcard;
+        }
+        else {
+            to = states[s].find(symbolKey(*p));
+            for (int i = p->args.size() - 1; i >= 0; i--)
+                pending.push_back(&p->args[i]);
+        }
+        if (to < 0) {
+            to = states.size();
+            states.push_back(state());
+            if (isPatternVariable(*p)) states[s].wildcard = to;
+            else states[s].next.push_back(std::make_pair(symbolKey(*p), to));
+        }
+        s = to;
+    }
+    if (states[s].rule < 0 || (unsigned)states[s].rule > rule)
+        states[s].rule = rule;
+}
+
+// Follows every branch the rest of the node fits, giving up on those
+// that only lead to rules later than the best one found so far
+void discriminationTree::walk(unsigned s, std::vector<const Node *> &pending,
+                              unsigned &best) const {
+    const state &st = states[s];
+    if (st.minRule >= best) return;
+    if (!pending.size()) {
+        if (st.rule >= 0 && (unsigned)st.rule < best) best = st.rule;
+        return;
+    }
+    const Node *n = pending.back();
+    pending.pop_back();
+    int to = st.find(symbolKey(*n));
+    if (to >= 0) {
+        size_t depth = pending.size();
+        for (int i = n->args.size() - 1; i >= 0; i--)
+            pending.push_back(&n->args[i]);
+        walk(to, pending, best);
+        pending.resize(depth);
+    }
+    if (st.wildcard >= 0) walk(st.wildcard, pending, best);
+    pending.push_back(n);
+}
+
+int discriminationTree::firstMatch(const Node &node) const {
+    // Reused between calls, as most nodes match nothing and allocating
+    // would cost more than the walk
+    static thread_local std::vector<const Node *> pending;
+    pending.clear();
+    pending.push_back(&node);
+    unsigned best = -1;
+    walk(0, pending, best);
+    return best == (unsigned)-1 ? -1 : (int)best;
+}
+
 // Fills in the pattern with a dictionary mapping variable names to
 // nodes (these dicts are generated by match). Match and subst together
 // create a full pattern-matching engine. 
 Node subst(Node pattern,
-           std::map<std::string, Node> dict,
-           std::string varflag,
-           Metadata m) {
+           const std::map<std::string, Node> &dict,
+           const std::string &varflag,
+           const Metadata &m) {
     // Swap out patterns at the token level
     if (pattern.metadata.ln == -1)
         pattern.metadata = m;
     if (pattern.type == TOKEN && 
             pattern.val[0] == '$') {
-        if (dict.count(pattern.val.substr(1))) {
-            return dict[pattern.val.substr(1)];
+        std::map<std::string, Node>::const_iterator it =
+            dict.find(pattern.val.substr(1));
+        if (it != dict.end()) {
+            return it->second;
         }
         else {
             return token(varflag + pattern.val.substr(1), m);
@@ -189,6 +278,102 @@ Node subst(Node pattern,
     }
 }
 
+// Slots are handed out by variable name: $x and @x are the same
+// variable, as they are to match()
+void compilePattern(const Node &p, std::vector<patternOp> &o,
+                    std::map<std::string, int> &slots, bool binds) {
+    patternOp op;
+    op.val = p.val;
+    op.n = p.args.size();
+    if (p.type == ASTNODE) {
+        op.kind = PATTERN_NODE;
+        o.push_back(op);
+        for (unsigned i = 0; i < p.args.size(); i++)
+            compilePattern(p.args[i], o, slots, binds);
+        return;
+    }
+    // Only $ variables are filled in by subst()
+    bool isVar = p.val[0] == '$' || (binds && p.val[0] == '@');
+    if (!isVar) {
+        op.kind = PATTERN_TOKEN;
+        op.token = p;
+        o.push_back(op);
+        return;
+    }
+    op.kind = PATTERN_VAR;
+    std::string name = p.val.substr(1);
+    if (binds && !slots.count(name)) {
+        int slot = slots.size();
+        slots[name] = slot;
+    }
+    op.n = slots.count(name) ? slots[name] : -1;
+    o.push_back(op);
+}
+
+rewriteRule::rewriteRule(Node p, Node s) {
+    pattern = p;
+    substitution = s;
+    std::map<std::string, int> names;
+    compilePattern(p, matcher, names, true);
+    compilePattern(s, builder, names, false);
+    slots = names.size();
+}
+
+// Returns the position after the subpattern at ops[pos], or -1 if the
+// node does not fit it
+int matchOps(const std::vector<patternOp> &ops, unsigned pos, const Node &n,
+             const Node **slots) {
+    const patternOp &op = ops[pos];
+    if (op.kind == PATTERN_TOKEN)
+        return n.type == TOKEN && n.val == op.val ? pos + 1 : -1;
+    if (op.kind == PATTERN_VAR) {
+        // A token spelled like the variable matches as itself, unbound
+        if (n.type != TOKEN || n.val != op.val) slots[op.n] = &n;
+        return pos + 1;
+    }
+    if (n.type == TOKEN || n.val != op.val || (int)n.args.size() != op.n)
+        return -1;
+    pos++;
+    for (unsigned i = 0; i < n.args.size(); i++) {
+        int next = matchOps(ops, pos, n.args[i], slots);
+        if (next < 0) return -1;
+        pos = next;
+    }
+    return pos;
+}
+
+bool matchRule(const rewriteRule &r, const Node &n, const Node **slots) {
+    for (unsigned i = 0; i < r.slots; i++) slots[i] = 0;
+    return matchOps(r.matcher, 0, n, slots) >= 0;
+}
+
+Node substOps(const std::vector<patternOp> &ops, unsigned &pos,
+              const Node *const *slots, const std::string &varflag,
+              const Metadata &m) {
+    const patternOp &op = ops[pos++];
+    if (op.kind == PATTERN_VAR) {
+        if (op.n >= 0 && slots[op.n]) return *slots[op.n];
+        return token(varflag + op.val.substr(1), m);
+    }
+    if (op.kind == PATTERN_TOKEN) {
+        if (op.token.metadata.ln != -1) return op.token;
+        return token(op.val, m);
+    }
+    Node o;
+    o.type = ASTNODE;
+    o.val = op.val;
+    o.metadata = m;
+    for (int i = 0; i < op.n; i++)
+        o.args.push_back(substOps(ops, pos, slots, varflag, m));
+    return o;
+}
+
+Node substRule(const rewriteRule &r, const Node *const *slots,
+               const std::string &varflag, const Metadata &m) {
+    unsigned pos = 0;
+    return substOps(r.builder, pos, slots, varflag, m);
+}
+
 // Transforms a sequence containing two-argument with statements
 // into a statement containing those statements in nested form
 Node withTransform (Node source) {
@@ -197,11 +382,11 @@ Node withTransform (Node source) {
     std::vector<Node> args;
     for (int i = source.args.size() - 1; i >= 0; i--) {
         Node a = source.args[i];
-        if (a.val == "with" && a.args.size() == 2) {
+        if (a.val == SYM_WITH && a.args.size() == 2) {
             std::vector<Node> flipargs;
             for (int j = args.size() - 1; j >= 0; j--)
                 flipargs.push_back(args[i]);
-            if (o.val != "--")
+            if (o.val != SYM_DASHES)
                 flipargs.push_back(o);
             o = asn("with", a.args[0], a.args[1], asn("seq", flipargs, m), m);
             args = std::vector<Node>();
@@ -213,7 +398,7 @@ Node withTransform (Node source) {
     std::vector<Node> flipargs;
     for (int j = args.size() - 1; j >= 0; j--)
         flipargs.push_back(args[j]);
-    if (o.val != "--")
+    if (o.val != SYM_DASHES)
         flipargs.push_back(o);
     return asn("seq", flipargs, m);
 }
@@ -221,9 +406,9 @@ Node withTransform (Node source) {
 // Flatten nested sequence into flat sequence
 Node flattenSeq(Node inp) {
     std::vector<Node> o;
-    if (inp.val == "seq" && inp.type == ASTNODE) {
+    if (inp.val == SYM_SEQ && inp.type == ASTNODE) {
         for (unsigned i = 0; i < inp.args.size(); i++) {
-            if (inp.args[i].val == "seq" && inp.args[i].type == ASTNODE)
+            if (inp.args[i].val == SYM_SEQ && inp.args[i].type == ASTNODE)
                 o = extend(o, flattenSeq(inp.args[i]).args);
             else
                 o.push_back(flattenSeq(inp.args[i]));
@@ -30,7 +30,7 @@ void cerrStringList(std::vector<std::string> s, std::string suffix="");
 // self.cow
 // self.horse[0]
 // self.a[6][7][self.storage[3]].chicken[9]
-bool isNodeStorageVariable(Node node);
+bool isNodeStorageVariable(const Node &node);
 
 // Applies rewrite rules adding without wrapper
 Node rewriteChunk(Node inp);
@@ -42,37 +42,108 @@ struct matchResult {
 };
 
 // Match node to pattern
-matchResult match(Node p, Node n);
+matchResult match(const Node &p, const Node &n);
 
 // Substitute node using pattern
 Node subst(Node pattern,
-           std::map<std::string, Node> dict,
-           std::string varflag,
-           Metadata m);
+           const std::map<std::string, Node> &dict,
+           const std::string &varflag,
+           const Metadata &m);
 
 Node withTransform(Node source);
 
+// One symbol of a pattern or a substitution, read in preorder
+const int PATTERN_TOKEN = 0,
+          PATTERN_NODE = 1,
+          PATTERN_VAR = 2;
+
+class patternOp {
+    public:
+        int kind;
+        Symbol val;
+        // Argument count of a node, or slot of a variable (-1 for a
+        // variable of a substitution that the pattern does not bind)
+        int n;
+        // A token of a substitution, as it is copied into the output
+        Node token;
+};
+
 class rewriteRule {
     public:
-        rewriteRule(Node p, Node s) {
-            pattern = p;
-            substitution = s;
-        }
+        rewriteRule(Node p, Node s);
         Node pattern;
         Node substitution;
+        // The same, compiled: each variable name gets a slot, so that
+        // matching can bind variables in an array instead of a map
+        std::vector<patternOp> matcher;
+        std::vector<patternOp> builder;
+        unsigned slots;
+};
+
+// Matches a node to a rule's pattern, pointing each of the rule's slots
+// at the subtree its variable matched (or at nothing). Same results as
+// match()
+bool matchRule(const rewriteRule &r, const Node &n, const Node **slots);
+
+// Fills in a rule's substitution from the slots matchRule filled. Same
+// results as subst()
+Node substRule(const rewriteRule &r, const Node *const *slots,
+               const std::string &varflag, const Metadata &m);
+
+// Index of the patterns of a list of rules. A pattern is read in
+// preorder as a string of symbols (a token, or a node's name with its
+// argument count), where a variable stands for a whole subtree, and the
+// strings are merged into a trie. A node is matched with one walk down
+// the trie, following both the branch for its own symbol and the one
+// for a variable wherever there are two
+class discriminationTree {
+    public:
+        discriminationTree() {
+            states.push_back(state());
+        }
+        void insert(const Node &pattern, unsigned rule);
+        // The first rule (lowest number) whose pattern matches the node,
+        // or -1 if there is none
+        int firstMatch(const Node &node) const;
+    private:
+        class state {
+            public:
+                state() {
+                    wildcard = -1;
+                    rule = -1;
+                    minRule = -1;
+                }
+                // Argument count (-1 for a token) and name -> state.
+                // States rarely have more than a few, so a list is
+                // faster to search than a map
+                std::vector<std::pair<std::pair<int, Symbol>, unsigned> >
+                    next;
+                int find(const std::pair<int, Symbol> &key) const;
+                int wildcard;
+                // First rule whose pattern ends here
+                int rule;
+                // First rule whose pattern goes through here
+                unsigned minRule;
+        };
+        std::vector<state> states;
+        void walk(unsigned s, std::vector<const Node *> &pending,
+                  unsigned &best) const;
 };
 
 class rewriteRuleSet {
     public:
         rewriteRuleSet() {
-            ruleLists = std::map<std::string, std::vector<rewriteRule> >();
+            ruleLists = std::map<Symbol, std::vector<rewriteRule> >();
         }
         void addRule(rewriteRule r) {
-            if (!ruleLists.count(r.pattern.val))
-                ruleLists[r.pattern.val] = std::vector<rewriteRule>();
-            ruleLists[r.pattern.val].push_back(r);
+            std::vector<rewriteRule> &rules = ruleLists[r.pattern.val];
+            index[r.pattern.val].insert(r.pattern, rules.size());
+            rules.push_back(r);
         }
-        std::map<std::string, std::vector<rewriteRule> > ruleLists;
+        // Rules grouped by the head of their pattern
+        std::map<Symbol, std::vector<rewriteRule> > ruleLists;
+        // The patterns of each group, indexed
+        std::map<Symbol, discriminationTree> index;
 };
 
 // Flatten nested sequence into flat sequence
@@ -119,6 +119,21 @@ mk_full_signature = lambda code, **kwargs: json.loads(bytestostr(pyext.mk_full_s
 mk_contract_info_decl = lambda code, **kwargs: json.loads(bytestostr(pyext.mk_contract_info_decl(strtobytes(pre_transform(code, kwargs)))))
 get_prefix = lambda x: pyext.get_prefix(strtobytes(x)) % 2**32
 
+
+class IncrementalCompiler(object):
+    # Compiles a contract over and over as it is edited, redoing only the
+    # functions that changed since the last compile. The code is the same
+    # as compile()'s
+    def __init__(self, threads=1):
+        self.handle = pyext.incremental_compiler(threads)
+
+    def compile(self, code, **kwargs):
+        return pyext.incremental_compile(self.handle, strtobytes(pre_transform(code, kwargs)))
+
+    # (functions reused, functions recompiled) by the last compile
+    def stats(self):
+        return pyext.incremental_stats(self.handle)
+
 if sys.version_info.major == 2:
     is_string = lambda x: isinstance(x, (str, str, bytes))
     is_numeric = lambda x: isinstance(x, (int, int))
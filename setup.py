@@ -1,6 +1,8 @@
 from setuptools import setup, Extension
 
 import os
+import glob
+import hashlib
 from distutils.sysconfig import get_config_vars
 
 (opt,) = get_config_vars('OPT')
@@ -9,6 +11,21 @@ if opt is not None:
         flag for flag in opt.split() if flag != '-Wstrict-prototypes'
     )
 
+# Identifies the compiler's output in disk cache keys: a hash of the
+# sources of the library, the same as the Makefile's
+library = ['keccak-tiny.cpp', 'bignum.cpp', 'uint256.cpp',
+           'symbol.cpp', 'util.cpp', 'lexscan.cpp', 'tokenize.cpp',
+           'lllparser.cpp', 'parser.cpp', 'opcodes.cpp', 'optimize.cpp',
+           'functions.cpp', 'rewriteutils.cpp', 'preprocess.cpp',
+           'macrotables.cpp', 'rewriter.cpp', 'compiler.cpp',
+           'incremental.cpp', 'diskcache.cpp', 'funcs.cpp']
+build = hashlib.sha256()
+for f in library + sorted(glob.glob('*.h')):
+    with open(f, 'rb') as src:
+        build.update(src.read())
+with open('buildid.cpp', 'w') as out:
+    out.write('const char *compilerBuild = "%s";\n' % build.hexdigest())
+
 setup(
     # Name of this package
     name="ethereum-serpent",
@@ -26,12 +43,9 @@ setup(
     ext_modules=[
         Extension(
             'serpent_pyext',         # Python name of the module
-            sources=['keccak-tiny.cpp', 'bignum.cpp', 'util.cpp',
-                     'tokenize.cpp', 'lllparser.cpp', 'parser.cpp',
-                     'functions.cpp', 'optimize.cpp', 'opcodes.cpp',
-                     'rewriteutils.cpp', 'preprocess.cpp', 'rewriter.cpp',
-                     'compiler.cpp', 'funcs.cpp', 'pyserpent.cpp'],
-            extra_compile_args=['-Wno-sign-compare']
+            sources=library + ['buildid.cpp', 'pyserpent.cpp'],
+            extra_compile_args=['-Wno-sign-compare', '-pthread'],
+            extra_link_args=['-pthread']
         )],
     py_modules=[
         'serpent',
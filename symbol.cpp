@@ -0,0 +1,166 @@
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <stdexcept>
+#include "symbol.h"
+
+// Interned ids stay below OWNED_SYMBOL
+std::string *symbolChunks[1 << (31 - SYMBOL_CHUNK_BITS)];
+ownedSymbol *ownedSymbolChunks[1 << (31 - SYMBOL_CHUNK_BITS)];
+
+// The lock is a function-local static so that symbols can be interned
+// during static initialization of other files
+static std::mutex &poolLock() {
+    static std::mutex m;
+    return m;
+}
+
+static uint32_t poolSize = 0;
+
+const char *const builtinSymbolNames[BUILTIN_SYMBOL_COUNT] = {
+    "", "seq", "set", "get", "ref", "with", "comment", "ops", "lll", "if",
+    "unless", "until", "alloc", "____CODE", "=", ".", "access", "outer",
+    "sload", "log", "array_lit", "fun", "prefix", "text", "error", "self",
+    "add", "sub", "mul", "div", "sdiv", "mod", "smod", "exp", "addmod",
+    "mulmod", "signextend", "+", "*", "-", "/", "^", "**", "%", "--", "0",
+    "1"
+};
+
+// Open-addressing hash table from text to id; slots hold id + 1, with 0
+// marking an empty slot. Lookups compare against the pooled text, so
+// interning a substring of some buffer does not build a std::string
+static uint32_t *slots = 0;
+static uint32_t slotMask = 0;
+
+static uint32_t hashText(const char *s, size_t n) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < n; i++) {
+        h ^= (unsigned char)s[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static void growSlots() {
+    uint32_t newMask = slotMask ? slotMask * 2 + 1 : 1023;
+    uint32_t *newSlots = new uint32_t[newMask + 1]();
+    for (uint32_t id = 0; id < poolSize; id++) {
+        const std::string &t = symbolText(id);
+        uint32_t i = hashText(t.data(), t.size()) & newMask;
+        while (newSlots[i]) i = (i + 1) & newMask;
+        newSlots[i] = id + 1;
+    }
+    delete[] slots;
+    slots = newSlots;
+    slotMask = newMask;
+}
+
+// Appends a string to the pool; the caller holds the lock
+static uint32_t addSymbol(const char *s, size_t n, uint32_t slot) {
+    uint32_t id = poolSize;
+    if (!(id & (SYMBOL_CHUNK_SIZE - 1))) {
+        if (id >> SYMBOL_CHUNK_BITS == (1 << (31 - SYMBOL_CHUNK_BITS)) - 1)
+            throw std::runtime_error("Symbol pool exhausted");
+        symbolChunks[id >> SYMBOL_CHUNK_BITS] =
+            new std::string[SYMBOL_CHUNK_SIZE];
+    }
+    symbolChunks[id >> SYMBOL_CHUNK_BITS][id & (SYMBOL_CHUNK_SIZE - 1)]
+        .assign(s, n);
+    slots[slot] = id + 1;
+    poolSize += 1;
+    if (poolSize * 2 > slotMask) growSlots();
+    return id;
+}
+
+bool initSymbolPool() {
+    std::lock_guard<std::mutex> lock(poolLock());
+    growSlots();
+    for (unsigned b = 0; b < BUILTIN_SYMBOL_COUNT; b++) {
+        const char *t = builtinSymbolNames[b];
+        size_t len = strlen(t);
+        uint32_t j = hashText(t, len) & slotMask;
+        while (slots[j]) j = (j + 1) & slotMask;
+        addSymbol(t, len, j);
+    }
+    return true;
+}
+
+uint32_t intern(const char *s, size_t n) {
+    requireSymbolPool();
+    std::lock_guard<std::mutex> lock(poolLock());
+    uint32_t i = hashText(s, n) & slotMask;
+    while (slots[i]) {
+        const std::string &t = symbolText(slots[i] - 1);
+        if (t.size() == n && !memcmp(t.data(), s, n)) return slots[i] - 1;
+        i = (i + 1) & slotMask;
+    }
+    return addSymbol(s, n, i);
+}
+
+uint32_t intern(const std::string &s) {
+    return intern(s.data(), s.size());
+}
+
+uint32_t symbolCount() {
+    requireSymbolPool();
+    std::lock_guard<std::mutex> lock(poolLock());
+    return poolSize;
+}
+
+static std::mutex &ownedLock() {
+    static std::mutex m;
+    return m;
+}
+
+static uint32_t ownedSize = 0;
+
+// Owned ids given back, to be handed out again
+static std::vector<uint32_t> &ownedFree() {
+    static std::vector<uint32_t> v;
+    return v;
+}
+
+// Numbers up to three digits are as common as names (and include the
+// builtins 0 and 1), so they are interned
+static bool ownedText(const char *s, size_t n) {
+    if (!n) return false;
+    if (s[0] == '"' || s[0] == '\'') return true;
+    return s[0] >= '0' && s[0] <= '9' && n > 3;
+}
+
+uint32_t symbolId(const char *s, size_t n) {
+    if (!ownedText(s, n)) return intern(s, n);
+    uint32_t i;
+    {
+        std::lock_guard<std::mutex> lock(ownedLock());
+        std::vector<uint32_t> &free = ownedFree();
+        if (free.size()) {
+            i = free.back();
+            free.pop_back();
+        }
+        else {
+            i = ownedSize;
+            if (!(i & (SYMBOL_CHUNK_SIZE - 1))) {
+                if (i >> SYMBOL_CHUNK_BITS
+                        == (1 << (31 - SYMBOL_CHUNK_BITS)) - 1)
+                    throw std::runtime_error("Symbol pool exhausted");
+                ownedSymbolChunks[i >> SYMBOL_CHUNK_BITS] =
+                    new ownedSymbol[SYMBOL_CHUNK_SIZE];
+            }
+            ownedSize += 1;
+        }
+    }
+    ownedSymbol &o = ownedSymbolEntry(i | OWNED_SYMBOL);
+    o.text.assign(s, n);
+    o.refs = 1;
+    return i | OWNED_SYMBOL;
+}
+
+void freeOwnedSymbol(uint32_t id) {
+    // Let go of the text's memory too, not just its length
+    std::string().swap(ownedSymbolEntry(id).text);
+    std::lock_guard<std::mutex> lock(ownedLock());
+    ownedFree().push_back(id & ~OWNED_SYMBOL);
+}
@@ -0,0 +1,308 @@
+#ifndef ETHSERP_SYMBOL
+#define ETHSERP_SYMBOL
+
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <iostream>
+#include <atomic>
+
+// Interned strings live in fixed-size chunks that are never moved or
+// freed, so reading the text of a symbol needs no locking
+const unsigned SYMBOL_CHUNK_BITS = 16;
+const uint32_t SYMBOL_CHUNK_SIZE = 1 << SYMBOL_CHUNK_BITS;
+
+extern std::string *symbolChunks[];
+
+// Returns the id of a string, adding it to the pool if needed. The
+// empty string always has id 0
+uint32_t intern(const std::string &s);
+uint32_t intern(const char *s, size_t n);
+
+// Numbers (other than short ones) and string literals are not interned,
+// as compilations make them without bound and rarely see one twice.
+// Each is given an id with this bit set, counted by the Symbols holding
+// it and reused once none do. Whether a string is owned this way only
+// depends on its text, so owned and interned ids never share a text
+const uint32_t OWNED_SYMBOL = 0x80000000;
+
+struct ownedSymbol {
+    std::atomic<int> refs;
+    std::string text;
+};
+
+extern ownedSymbol *ownedSymbolChunks[];
+
+inline ownedSymbol &ownedSymbolEntry(uint32_t id) {
+    id &= ~OWNED_SYMBOL;
+    return ownedSymbolChunks[id >> SYMBOL_CHUNK_BITS]
+                            [id & (SYMBOL_CHUNK_SIZE - 1)];
+}
+
+inline const std::string &symbolText(uint32_t id) {
+    if (id & OWNED_SYMBOL) return ownedSymbolEntry(id).text;
+    return symbolChunks[id >> SYMBOL_CHUNK_BITS][id & (SYMBOL_CHUNK_SIZE - 1)];
+}
+
+// The id of a string: interned, or owned with one reference
+uint32_t symbolId(const char *s, size_t n);
+
+// Gives back the id of an owned symbol nothing refers to any more
+void freeOwnedSymbol(uint32_t id);
+
+inline void retainSymbol(uint32_t id) {
+    if (id & OWNED_SYMBOL) ownedSymbolEntry(id).refs++;
+}
+
+inline void releaseSymbol(uint32_t id) {
+    if ((id & OWNED_SYMBOL) && !--ownedSymbolEntry(id).refs)
+        freeOwnedSymbol(id);
+}
+
+// Number of distinct symbols interned so far
+uint32_t symbolCount();
+
+// Interns the builtin symbols below, once. Symbols whose id is set
+// without interning anything make sure of it through requireSymbolPool,
+// so they work even during static initialization
+bool initSymbolPool();
+
+inline void requireSymbolPool() {
+    static const bool ready = initSymbolPool();
+    (void)ready;
+}
+
+// Names that the passes test nodes against on every visit. They are the
+// first symbols interned, in this order, so their ids are constants and
+// comparing a Symbol against one is a single integer compare. Comparing
+// against a const char * goes through the text, so keep that to code
+// that is off the hot paths
+enum builtinSymbol {
+    SYM_EMPTY,
+    SYM_SEQ,
+    SYM_SET,
+    SYM_GET,
+    SYM_REF,
+    SYM_WITH,
+    SYM_COMMENT,
+    SYM_OPS,
+    SYM_LLL,
+    SYM_IF,
+    SYM_UNLESS,
+    SYM_UNTIL,
+    SYM_ALLOC,
+    SYM_CODE,
+    SYM_ASSIGN,
+    SYM_DOT,
+    SYM_ACCESS,
+    SYM_OUTER,
+    SYM_SLOAD,
+    SYM_LOG,
+    SYM_ARRAY_LIT,
+    SYM_FUN,
+    SYM_PREFIX,
+    SYM_TEXT,
+    SYM_ERROR,
+    SYM_SELF,
+    SYM_ADD,
+    SYM_SUB,
+    SYM_MUL,
+    SYM_DIV,
+    SYM_SDIV,
+    SYM_MOD,
+    SYM_SMOD,
+    SYM_EXP,
+    SYM_ADDMOD,
+    SYM_MULMOD,
+    SYM_SIGNEXTEND,
+    SYM_PLUS,
+    SYM_TIMES,
+    SYM_MINUS,
+    SYM_SLASH,
+    SYM_CARET,
+    SYM_POWER,
+    SYM_PERCENT,
+    SYM_DASHES,
+    SYM_ZERO,
+    SYM_ONE,
+    BUILTIN_SYMBOL_COUNT
+};
+
+extern const char *const builtinSymbolNames[BUILTIN_SYMBOL_COUNT];
+
+// A string from the process-wide symbol pool, or an owned one (see
+// OWNED_SYMBOL). Symbols are copied as 32-bit ids, and compared as ids
+// unless both are owned; the text is available through str() or an
+// implicit conversion to const std::string&, and the common read-only
+// string operations are forwarded for convenience
+class Symbol {
+    public:
+        Symbol() {
+            requireSymbolPool();
+            id = 0;
+        }
+        explicit Symbol(const std::string &s) {
+            id = symbolId(s.data(), s.size());
+        }
+        explicit Symbol(const char *s) {
+            id = symbolId(s, strlen(s));
+        }
+        Symbol(const char *s, size_t n) {
+            id = symbolId(s, n);
+        }
+        Symbol(builtinSymbol s) {
+            requireSymbolPool();
+            id = s;
+        }
+        Symbol(const Symbol &o) {
+            id = o.id;
+            retainSymbol(id);
+        }
+        Symbol(Symbol &&o) {
+            id = o.id;
+            o.id = 0;
+        }
+        ~Symbol() {
+            releaseSymbol(id);
+        }
+        Symbol &operator=(const Symbol &o) {
+            retainSymbol(o.id);
+            releaseSymbol(id);
+            id = o.id;
+            return *this;
+        }
+        Symbol &operator=(Symbol &&o) {
+            std::swap(id, o.id);
+            return *this;
+        }
+        Symbol &operator=(const std::string &s) {
+            uint32_t old = id;
+            id = symbolId(s.data(), s.size());
+            releaseSymbol(old);
+            return *this;
+        }
+        Symbol &operator=(const char *s) {
+            uint32_t old = id;
+            id = symbolId(s, strlen(s));
+            releaseSymbol(old);
+            return *this;
+        }
+        uint32_t id;
+        const std::string &str() const {
+            return symbolText(id);
+        }
+        operator const std::string &() const {
+            return symbolText(id);
+        }
+        const char *c_str() const {
+            return str().c_str();
+        }
+        size_t size() const {
+            return str().size();
+        }
+        size_t length() const {
+            return str().length();
+        }
+        bool empty() const {
+            return id == 0;
+        }
+        char operator[](size_t i) const {
+            return str()[i];
+        }
+        std::string substr(size_t pos, size_t n=std::string::npos) const {
+            return str().substr(pos, n);
+        }
+        size_t find(const std::string &s, size_t pos=0) const {
+            return str().find(s, pos);
+        }
+        size_t find(char c, size_t pos=0) const {
+            return str().find(c, pos);
+        }
+        size_t rfind(const std::string &s,
+                     size_t pos=std::string::npos) const {
+            return str().rfind(s, pos);
+        }
+        size_t rfind(char c, size_t pos=std::string::npos) const {
+            return str().rfind(c, pos);
+        }
+};
+
+inline bool operator==(const Symbol &a, const Symbol &b) {
+    return a.id == b.id || ((a.id & b.id & OWNED_SYMBOL)
+                            && a.str() == b.str());
+}
+inline bool operator!=(const Symbol &a, const Symbol &b) {
+    return !(a == b);
+}
+// Orders by id (owned symbols last, by text), not alphabetically; only
+// use it for lookup tables
+inline bool operator<(const Symbol &a, const Symbol &b) {
+    if (a.id & b.id & OWNED_SYMBOL) return a.str() < b.str();
+    return a.id < b.id;
+}
+
+inline bool operator==(const Symbol &a, builtinSymbol b) {
+    return a.id == (uint32_t)b;
+}
+inline bool operator==(builtinSymbol a, const Symbol &b) {
+    return (uint32_t)a == b.id;
+}
+inline bool operator!=(const Symbol &a, builtinSymbol b) {
+    return a.id != (uint32_t)b;
+}
+inline bool operator!=(builtinSymbol a, const Symbol &b) {
+    return (uint32_t)a != b.id;
+}
+
+inline bool operator==(const Symbol &a, const std::string &b) {
+    return a.str() == b;
+}
+inline bool operator==(const std::string &a, const Symbol &b) {
+    return a == b.str();
+}
+inline bool operator==(const Symbol &a, const char *b) {
+    return a.str() == b;
+}
+inline bool operator==(const char *a, const Symbol &b) {
+    return b.str() == a;
+}
+inline bool operator!=(const Symbol &a, const std::string &b) {
+    return a.str() != b;
+}
+inline bool operator!=(const std::string &a, const Symbol &b) {
+    return a != b.str();
+}
+inline bool operator!=(const Symbol &a, const char *b) {
+    return a.str() != b;
+}
+inline bool operator!=(const char *a, const Symbol &b) {
+    return b.str() != a;
+}
+
+inline std::string operator+(const Symbol &a, const Symbol &b) {
+    return a.str() + b.str();
+}
+inline std::string operator+(const Symbol &a, const std::string &b) {
+    return a.str() + b;
+}
+inline std::string operator+(const std::string &a, const Symbol &b) {
+    return a + b.str();
+}
+inline std::string operator+(const Symbol &a, const char *b) {
+    return a.str() + b;
+}
+inline std::string operator+(const char *a, const Symbol &b) {
+    return a + b.str();
+}
+inline std::string operator+(const Symbol &a, char b) {
+    return a.str() + b;
+}
+inline std::string operator+(char a, const Symbol &b) {
+    return a + b.str();
+}
+
+inline std::ostream &operator<<(std::ostream &o, const Symbol &s) {
+    return o << s.str();
+}
+
+#endif
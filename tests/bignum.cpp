@@ -0,0 +1,60 @@
+// Checks of the decimal* functions in bignum.cpp. Prints each failure,
+// and exits with status 1 if there were any
+//
+// Run by `make check`
+#include <stdio.h>
+#include <iostream>
+#include <string>
+#include "../bignum.h"
+
+int failures = 0;
+
+void expect(const std::string &what, const std::string &got,
+            const std::string &want) {
+    if (got == want) return;
+    printf("FAIL: %s = %s, expected %s\n", what.c_str(), got.c_str(),
+           want.c_str());
+    failures++;
+}
+
+// A number of the given number of digits, not a power of ten
+std::string digits(unsigned n, char first) {
+    std::string o;
+    for (unsigned i = 0; i < n; i++) o += nums[(first - '0' + i * 7) % 10];
+    if (o[0] == '0') o[0] = '1';
+    return o;
+}
+
+int main() {
+    // Division and modulo by zero give zero, as the EVM does
+    expect("decimalDiv(7, 0)", decimalDiv("7", "0"), "0");
+    expect("decimalMod(7, 0)", decimalMod("7", "0"), "0");
+    expect("decimalDiv(2^256, 0)", decimalDiv(tt256, "0"), "0");
+    expect("decimalMod(2^256, 0)", decimalMod(tt256, "0"), "0");
+    expect("decimalDiv(0, 0)", decimalDiv("0", "0"), "0");
+    // Small cases
+    expect("decimalDiv(7, 2)", decimalDiv("7", "2"), "3");
+    expect("decimalMod(7, 2)", decimalMod("7", "2"), "1");
+    expect("decimalDiv(2, 7)", decimalDiv("2", "7"), "0");
+    expect("decimalSub(2, 7)", decimalSub("2", "7"), "0");
+    expect("decimalExp(2, 256)", decimalExp("2", "256"), tt256);
+    expect("decimalSub(2^256, 1)", decimalSub(tt256, "1"), tt256m1);
+    expect("decimalModExp(3, 2^256 - 1, 1)",
+           decimalModExp("3", tt256m1, "1"), "0");
+    // Division undoes multiplication, at sizes that go through every
+    // kernel
+    unsigned sizes[] = { 1, 9, 19, 20, 40, 77, 200, 600, 2000 };
+    for (unsigned i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        for (unsigned j = 0; j <= i; j++) {
+            std::string a = digits(sizes[i], '3'), b = digits(sizes[j], '8');
+            std::string r = decimalSub(b, "1");
+            std::string n = decimalAdd(decimalMul(a, b), r);
+            std::string what = "(" + unsignedToDecimal(sizes[i]) + " digits * "
+                + unsignedToDecimal(sizes[j]) + " digits + r)";
+            expect(what + " / b", decimalDiv(n, b), a);
+            expect(what + " % b", decimalMod(n, b), r);
+            expect(what + " - r", decimalSub(n, r), decimalMul(b, a));
+        }
+    }
+    return failures ? 1 : 0;
+}
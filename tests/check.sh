@@ -0,0 +1,150 @@
+#!/bin/sh
+# Checks the compiler against the outputs committed under tests/golden.
+# Run from the top of the tree with `make check`; `tests/check.sh -u`
+# rewrites the golden files from the current build instead, after a
+# change that is meant to alter them
+cd "$(dirname "$0")/.."
+
+update=0
+if [ "$1" = "-u" ]; then update=1; fi
+
+failed=0
+tmp=$(mktemp -d)
+trap 'rm -rf "$tmp"' EXIT
+
+fail() {
+    echo "FAIL: $*"
+    failed=$((failed + 1))
+}
+
+# Output and diagnostics of a serpent command, without the abort message
+# that an uncaught compile error ends with (or the shell's report of it)
+run() {
+    ./serpent "$@" > "$tmp/run" 2>&1
+    grep -v -e '^terminate called' -e '^Aborted' "$tmp/run"
+}
+
+# Compares a command's output with its golden file, or writes the file
+golden() {
+    name=$1
+    shift
+    "$@" > "$tmp/out"
+    if [ $update = 1 ]; then
+        mkdir -p "$(dirname "tests/golden/$name")"
+        cp "$tmp/out" "tests/golden/$name"
+    elif ! cmp -s "$tmp/out" "tests/golden/$name"; then
+        fail "$* differs from tests/golden/$name"
+        diff -u "tests/golden/$name" "$tmp/out" | head -20
+    fi
+}
+
+# Each LLL expression, and what rewriting it folds it to
+fold() {
+    for e in "$@"; do
+        echo "$e"
+        run rewrite "$e"
+    done
+}
+
+# The report of rewrite --stats on some parsed code, without the times,
+# and with the rules of each level sorted, as they are reported slowest
+# first
+stats() {
+    ./serpent rewrite --stats "$(./serpent parse "$1")" 2>&1 > /dev/null |
+        sed -e 's/, [0-9.]* ms$//' -e 's/^\( *[0-9a-z]* *[0-9a-z]*\) *[0-9.ms]*  /\1  /' |
+        awk '/^[^ ]/ { n++; r = 0 } /^ *attempts/ { r = 1 }
+             /^ *[0-9]/ { r = 2 } { print n, r, $0 }' |
+        LC_ALL=C sort -k1,1n -k2,2n -k3 | cut -d ' ' -f 3-
+}
+
+examples=$(find examples -name '*.se' | sort)
+
+# Code, warnings and errors for each example
+for f in $examples; do
+    golden "$f.compile" run compile "$f"
+done
+
+# Constant folding wraps around at 2^256, treats the operands of signed
+# operations as two's complement, and writes negative results as
+# (sub 0 k)
+golden fold/signed.lll fold \
+    "(sub 3 5)" "(sub 0 1)" \
+    "(add (exp 2 255) (exp 2 255))" "(mul (exp 2 128) (exp 2 128))" \
+    "(sdiv (sub 0 7) 2)" "(sdiv 7 (sub 0 2))" "(smod (sub 0 7) 3)" \
+    "(sdiv (sub 0 (exp 2 255)) (sub 0 1))" \
+    "(signextend 0 255)" "(signextend 1 128)" \
+    "(div 10 0)" "(sdiv 5 0)" "(mod 7 0)" "(smod 5 0)"
+
+# addmod and mulmod are folded without wrapping the intermediate result,
+# and exp by modular exponentiation
+golden fold/modular.lll fold \
+    "(addmod 5 6 7)" "(mulmod 5 6 7)" \
+    "(addmod (sub 0 1) 2 10)" "(mulmod (sub 0 1) (sub 0 1) 12)" \
+    "(addmod 1 2 0)" "(mulmod 3 4 0)" \
+    "(exp 3 300)" "(exp 2 256)" "(exp 0 0)" "(exp (sub 0 1) 3)"
+
+# What each level of rewriting visits, tries and matches
+golden rewrite/stats.txt stats "$(printf 'data balances[]\n%s\n%s\n%s\n%s\n' \
+    'def deposit(amount):' '    self.balances[msg.sender] += amount' \
+    'def balance(who):' '    return(self.balances[who] * 2 + 1)')"
+
+if [ $update = 1 ]; then
+    echo "golden files written"
+    exit 0
+fi
+
+# Compiling the functions on threads gives the same code
+for f in $examples; do
+    golden "$f.compile" run -j 4 compile "$f"
+done
+
+# A batch writes the same code as compiling each file, and the same
+# signatures as mk_full_signature
+run batch -j 2 --signature -o "$tmp/batch" $examples > /dev/null
+for f in $examples; do
+    base="$tmp/batch/${f%.se}"
+    code=$(tail -n 1 "tests/golden/$f.compile" | grep -x '[0-9a-f]*')
+    if [ -z "$code" ]; then
+        if [ -f "$base.hex" ]; then fail "batch wrote code for $f"; fi
+    elif [ "$(cat "$base.hex" 2>/dev/null)" != "$code" ]; then
+        fail "batch code for $f differs from tests/golden/$f.compile"
+    elif [ "$(cat "$base.sig")" != "$(run mk_full_signature "$f" | grep -v '^Warning')" ]; then
+        fail "batch signature for $f differs from mk_full_signature"
+    fi
+done
+
+# The disk cache gives the same code as compiling, compiles nothing when
+# it has the contract, and is missed once a file the contract insets
+# changes
+mkdir -p "$tmp/cached"
+printf 'def double(x):\n    return(x * 2)\n' > "$tmp/cached/lib.se"
+printf 'inset("lib.se")\ndef f(x):\n    return(self.double(x) + 1)\n' \
+    > "$tmp/cached/main.se"
+# Compiles the contract with the cache on, and checks the code and
+# whether it was compiled
+cached() {
+    want=$(run compile "$tmp/cached/main.se")
+    SERPENT_CACHE_DIR="$tmp/cache" ./serpent --time-passes compile \
+        "$tmp/cached/main.se" > "$tmp/run" 2>&1
+    if [ "$(head -n 1 "$tmp/run")" != "$want" ]; then
+        fail "disk cache: code differs from compile ($1)"
+    fi
+    compiled=$(grep -c ' rewrite$' "$tmp/run")
+    if [ "$compiled" != "$2" ]; then
+        fail "disk cache: compiled $compiled times, expected $2 ($1)"
+    fi
+}
+cached "first compile" 1
+cached "unchanged" 0
+printf 'def double(x):\n    return(x * 3)\n' > "$tmp/cached/lib.se"
+cached "inset file changed" 1
+cached "unchanged again" 0
+
+./tests/bignum || fail "tests/bignum"
+./tests/incremental || fail "tests/incremental"
+
+if [ $failed != 0 ]; then
+    echo "$failed check(s) failed"
+    exit 1
+fi
+echo "all checks passed"
@@ -0,0 +1,76 @@
+// Checks of incrementalCompiler: after each edit the code is the same as
+// compile()'s, and only the functions that changed are redone. Prints
+// each failure, and exits with status 1 if there were any
+//
+// Run by `make check`
+#include <stdio.h>
+#include <iostream>
+#include <string>
+#include "../util.h"
+#include "../funcs.h"
+#include "../incremental.h"
+
+int failures = 0;
+
+void expect(const std::string &what, bool ok) {
+    if (ok) return;
+    printf("FAIL: %s\n", what.c_str());
+    failures++;
+}
+
+// A contract with a few functions, one of which can be edited
+std::string contract(const std::string &top, const std::string &edited) {
+    return "data balances[]\n"
+           "event Moved(who, amount)\n" + top +
+           "def balance(who):\n"
+           "    return(self.balances[who])\n"
+           "def deposit(amount):\n"
+           "    self.balances[msg.sender] += amount\n"
+           "    log(type=Moved, msg.sender, amount)\n"
+           "def scaled(x):\n"
+           "    y = x * 3\n"
+           "    z = y + " + edited + "\n"
+           "    return(z)\n"
+           "def sum(a, b):\n"
+           "    t = a + b\n"
+           "    return(t)\n";
+}
+
+// Compiles the next version, checking the code against compile() and
+// the number of functions redone and of fragments recompiled
+void step(incrementalCompiler &c, const std::string &what,
+          const std::string &code, unsigned rewritten,
+          unsigned recompiled) {
+    unsigned misses = c.fragments.misses;
+    std::string got = c.compile(code);
+    expect(what + ": code is the same as compile()'s", got == compile(code));
+    expect(what + ": " + unsignedToDecimal(c.rewritten) + " functions"
+           " rewritten, expected " + unsignedToDecimal(rewritten),
+           c.rewritten == rewritten);
+    expect(what + ": " + unsignedToDecimal(c.reused) + " functions"
+           " reused, expected " + unsignedToDecimal(4 - rewritten),
+           c.reused == 4 - rewritten);
+    unsigned compiled = c.fragments.misses - misses;
+    expect(what + ": " + unsignedToDecimal(compiled) + " fragments"
+           " compiled, expected " + unsignedToDecimal(recompiled),
+           compiled == recompiled);
+}
+
+void run(int threads) {
+    incrementalCompiler c;
+    c.threads = threads;
+    std::string t = " (" + unsignedToDecimal(threads) + " threads)";
+    step(c, "first compile" + t, contract("", "1"), 4, 4);
+    step(c, "unchanged" + t, contract("", "1"), 0, 0);
+    step(c, "one def edited" + t, contract("", "2"), 1, 1);
+    // A variable at the top level takes memory before the functions',
+    // so their code is moved rather than compiled again
+    step(c, "functions relocated" + t, contract("x = 5\n", "2"), 0, 0);
+    step(c, "edited back" + t, contract("x = 5\n", "1"), 1, 1);
+}
+
+int main() {
+    run(1);
+    run(4);
+    return failures ? 1 : 0;
+}
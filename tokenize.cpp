@@ -3,96 +3,129 @@
 #include <vector>
 #include <map>
 #include "util.h"
+#include "tokenize.h"
+#include "lexscan.h"
 
-// These appear as independent tokens even if inside a stream of symbols
-const std::string atoms[] = { "#", "//", "(", ")", "[", "]", "{", "}" };
-const int numAtoms = 8;
+// Character classes for all 256 byte values (bytes >= 0x80 are symbols)
+#define A ALPHANUM
+#define S SPACE
+#define B BRACK
+#define Q SQUOTE
+#define D DQUOTE
+#define Y SYMB
+const unsigned char charClasses[256] = {
+    Y, Y, Y, Y, Y, Y, Y, Y, Y, S, S, Y, Y, S, Y, Y,  // 00
+    Y, Y, Y, Y, Y, Y, Y, Y, Y, Y, Y, Y, Y, Y, Y, Y,  // 10
+    S, Y, D, Y, A, Y, Y, Q, B, B, Y, Y, Y, Y, Y, Y,  // 20
+    A, A, A, A, A, A, A, A, A, A, Y, Y, Y, Y, Y, Y,  // 30
+    A, A, A, A, A, A, A, A, A, A, A, A, A, A, A, A,  // 40
+    A, A, A, A, A, A, A, A, A, A, A, B, Y, B, Y, A,  // 50
+    Y, A, A, A, A, A, A, A, A, A, A, A, A, A, A, A,  // 60
+    A, A, A, A, A, A, A, A, A, A, A, B, Y, B, A, Y,  // 70
+    Y, Y, Y, Y, Y, Y, Y, Y, Y, Y, Y, Y, Y, Y, Y, Y,  // 80
+    Y, Y, Y, Y, Y, Y, Y, Y, Y, Y, Y, Y, Y, Y, Y, Y,  // 90
+    Y, Y, Y, Y, Y, Y, Y, Y, Y, Y, Y, Y, Y, Y, Y, Y,  // a0
+    Y, Y, Y, Y, Y, Y, Y, Y, Y, Y, Y, Y, Y, Y, Y, Y,  // b0
+    Y, Y, Y, Y, Y, Y, Y, Y, Y, Y, Y, Y, Y, Y, Y, Y,  // c0
+    Y, Y, Y, Y, Y, Y, Y, Y, Y, Y, Y, Y, Y, Y, Y, Y,  // d0
+    Y, Y, Y, Y, Y, Y, Y, Y, Y, Y, Y, Y, Y, Y, Y, Y,  // e0
+    Y, Y, Y, Y, Y, Y, Y, Y, Y, Y, Y, Y, Y, Y, Y, Y,  // f0
+};
+#undef A
+#undef S
+#undef B
+#undef Q
+#undef D
+#undef Y
 
 // Is the char alphanumeric, a space, a bracket, a quote, a symbol?
 int chartype(char c) {
-    if (c >= '0' && c <= '9') return ALPHANUM;
-    else if (c >= 'a' && c <= 'z') return ALPHANUM;
-    else if (c >= 'A' && c <= 'Z') return ALPHANUM;
-	else if (std::string("~_$@").find(c) != std::string::npos) return ALPHANUM;
-    else if (c == '\t' || c == ' ' || c == '\n' || c == '\r') return SPACE;
-	else if (std::string("()[]{}").find(c) != std::string::npos) return BRACK;
-    else if (c == '"') return DQUOTE;
-    else if (c == '\'') return SQUOTE;
-    else return SYMB;
+    return charClasses[(unsigned char)c];
 }
 
 // "y = f(45,124)/3" -> [ "y", "f", "(", "45", ",", "124", ")", "/", "3"]
-std::vector<Node> tokenize(std::string inp, Metadata metadata, bool lispMode) {
+//
+// A single pass over the input; the state is the class of the token
+// being built (SPACE between tokens, SQUOTE/DQUOTE inside a string
+// literal) and the token itself is the span [start, pos). The input
+// is treated as if it were followed by one space, which flushes the
+// last token. The brackets, "#" and "//" always form tokens of their
+// own, and a trailing "-" or "!" is split off a run of symbols. Runs of
+// identifier characters, blanks and string contents are skipped in bulk
+// (see lexscan.h)
+std::vector<tokenSpan> tokenizeSpans(const std::string &inp,
+                                     Metadata metadata,
+                                     bool lispMode) {
+    const char *s = inp.data();
+    unsigned n = inp.length();
     int curtype = SPACE;
-	unsigned pos = 0;
+    unsigned pos = 0, start = 0;
     int lastNewline = 0;
     metadata.ch = 0;
-    std::string cur;
-    std::vector<Node> out;
+    std::vector<tokenSpan> out;
 
-    inp += " ";
-    while (pos < inp.length()) {
-        int headtype = chartype(inp[pos]);
-        if (lispMode) {
-            if (inp[pos] == '\'') headtype = ALPHANUM;
-        }
-        // Are we inside a quote?
+    while (pos <= n) {
+        char c = pos < n ? s[pos] : ' ';
+        int headtype = charClasses[(unsigned char)c];
+        if (lispMode && c == '\'') headtype = ALPHANUM;
+        // Inside a string literal: look for the closing quote, skipping
+        // over backslash escapes
         if (curtype == SQUOTE || curtype == DQUOTE) {
-            // Close quote
             if (headtype == curtype) {
-                cur += inp[pos];
-                out.push_back(token(cur, metadata));
-                cur = "";
+                out.push_back(tokenSpan(start, pos + 1 - start, metadata));
                 metadata.ch = pos - lastNewline;
                 curtype = SPACE;
                 pos += 1;
+                start = pos;
             }
-            // Backslash escape
-            else if (inp.length() >= pos + 2 && inp[pos] == '\\') {
-                cur += inp[pos];
-                cur += inp[pos + 1];
-                pos += 2;
-            }
-            else {
-                cur += inp[pos];
-                pos += 1;
-            }
+            else if (c == '\\' && pos + 1 <= n) pos += 2;
+            // Nothing happens until the next quote, escape or newline
+            else pos = scanString(s, pos + 1, n, curtype == DQUOTE ? '"' : '\'');
         }
         else {
-            // Handle atoms ( '//', '#',  brackets )
-            for (int i = 0; i < numAtoms; i++) {
-                int split = cur.length() - atoms[i].length();
-                if (split >= 0 && cur.substr(split) == atoms[i]) {
-                    if (split > 0) {
-                        out.push_back(token(cur.substr(0, split), metadata));
-                    }
-                    metadata.ch += split;
-                    out.push_back(token(cur.substr(split), metadata));
-                    metadata.ch = pos - lastNewline;
-                    cur = "";
-                    curtype = SPACE;
-                }
+            unsigned len = pos - start;
+            // Split off atoms ( '//', '#',  brackets )
+            unsigned atomLen = 0;
+            if (len >= 1) {
+                char last = s[pos - 1];
+                if (last == '#') atomLen = 1;
+                else if (last == '/' && len >= 2 && s[pos - 2] == '/')
+                    atomLen = 2;
+                else if (charClasses[(unsigned char)last] == BRACK)
+                    atomLen = 1;
+            }
+            if (atomLen) {
+                unsigned split = len - atomLen;
+                if (split > 0) out.push_back(tokenSpan(start, split, metadata));
+                metadata.ch += split;
+                out.push_back(tokenSpan(start + split, atomLen, metadata));
+                metadata.ch = pos - lastNewline;
+                start = pos;
+                len = 0;
+                curtype = SPACE;
             }
             // Special case the minus sign
-            if (cur.length() > 1 && (cur.substr(cur.length() - 1) == "-"
-                                  || cur.substr(cur.length() - 1) == "!")) {
-                out.push_back(token(cur.substr(0, cur.length() - 1), metadata));
-                out.push_back(token(cur.substr(cur.length() - 1), metadata));
-                cur = "";
+            if (len > 1 && (s[pos - 1] == '-' || s[pos - 1] == '!')) {
+                out.push_back(tokenSpan(start, len - 1, metadata));
+                out.push_back(tokenSpan(pos - 1, 1, metadata));
+                start = pos;
+                len = 0;
             }
             // Boundary between different char types
             if (headtype != curtype) {
-                if (curtype != SPACE && cur != "") {
-                    out.push_back(token(cur, metadata));
-                }
+                if (curtype != SPACE && len)
+                    out.push_back(tokenSpan(start, len, metadata));
                 metadata.ch = pos - lastNewline;
-                cur = "";
+                start = pos;
             }
-            cur += inp[pos];
             curtype = headtype;
             pos += 1;
+            // Further identifier characters or blanks only extend the
+            // current run (newlines are left to the check below)
+            if (curtype == ALPHANUM) pos = scanIdentifier(s, pos, n);
+            else if (curtype == SPACE) pos = scanBlanks(s, pos, n);
         }
-        if (inp[pos] == '\n') {
+        if (pos < n && s[pos] == '\n') {
             lastNewline = pos;
             metadata.ch = 0;
             metadata.ln += 1;
@@ -101,4 +134,14 @@ std::vector<Node> tokenize(std::string inp, Metadata metadata, bool lispMode) {
     return out;
 }
 
-
+std::vector<Node> tokenize(std::string inp, Metadata metadata, bool lispMode) {
+    std::vector<tokenSpan> spans = tokenizeSpans(inp, metadata, lispMode);
+    std::vector<Node> out;
+    out.reserve(spans.size());
+    for (unsigned i = 0; i < spans.size(); i++) {
+        out.push_back(token(Symbol(inp.data() + spans[i].offset,
+                                   spans[i].length),
+                            spans[i].metadata));
+    }
+    return out;
+}
@@ -7,8 +7,28 @@
 #include <map>
 #include "util.h"
 
+// Character class (SPACE, BRACK, ... ALPHANUM) of each byte value
+extern const unsigned char charClasses[256];
+
 int chartype(char c);
 
+// A token as a view into the tokenizer's input
+class tokenSpan {
+    public:
+        tokenSpan(unsigned Offset, unsigned Length, Metadata Meta) {
+            offset = Offset;
+            length = Length;
+            metadata = Meta;
+        }
+        unsigned offset;
+        unsigned length;
+        Metadata metadata;
+};
+
+std::vector<tokenSpan> tokenizeSpans(const std::string &inp,
+                                     Metadata meta=Metadata(),
+                                     bool lispMode=false);
+
 std::vector<Node> tokenize(std::string inp,
                            Metadata meta=Metadata(),
                            bool lispMode=false);
@@ -0,0 +1,526 @@
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <map>
+#include "uint256.h"
+
+// Full 64x64 -> 128 bit product
+static inline void mul64(uint64_t a, uint64_t b, uint64_t &hi, uint64_t &lo) {
+#ifdef __SIZEOF_INT128__
+    unsigned __int128 p = (unsigned __int128)a * b;
+    lo = (uint64_t)p;
+    hi = (uint64_t)(p >> 64);
+#else
+    uint64_t a0 = a & 0xffffffff, a1 = a >> 32;
+    uint64_t b0 = b & 0xffffffff, b1 = b >> 32;
+    uint64_t p00 = a0 * b0, p01 = a0 * b1, p10 = a1 * b0, p11 = a1 * b1;
+    uint64_t mid = (p00 >> 32) + (p01 & 0xffffffff) + (p10 & 0xffffffff);
+    lo = (mid << 32) | (p00 & 0xffffffff);
+    hi = p11 + (p01 >> 32) + (p10 >> 32) + (mid >> 32);
+#endif
+}
+
+// a + b*c + carry; returns the low word and leaves the high word in carry
+static inline uint64_t macc(uint64_t a, uint64_t b, uint64_t c,
+                            uint64_t &carry) {
+    uint64_t hi, lo;
+    mul64(b, c, hi, lo);
+    lo += a;
+    hi += lo < a;
+    lo += carry;
+    hi += lo < carry;
+    carry = hi;
+    return lo;
+}
+
+// Limbs <-> 32-bit digits (least significant first)
+static void toDigits(const uint256 &v, uint32_t *d) {
+    for (unsigned i = 0; i < 4; i++) {
+        d[2 * i] = (uint32_t)v.limbs[i];
+        d[2 * i + 1] = (uint32_t)(v.limbs[i] >> 32);
+    }
+}
+
+static uint256 fromDigits(const uint32_t *d) {
+    uint256 o;
+    for (unsigned i = 0; i < 4; i++)
+        o.limbs[i] = d[2 * i] | ((uint64_t)d[2 * i + 1] << 32);
+    return o;
+}
+
+// Number of significant digits
+static int digitCount(const uint32_t *d, int n) {
+    while (n > 0 && d[n - 1] == 0) n--;
+    return n;
+}
+
+static int leadingZeroes(uint32_t x) {
+    int n = 0;
+    if (x <= 0x0000ffff) { n += 16; x <<= 16; }
+    if (x <= 0x00ffffff) { n += 8; x <<= 8; }
+    if (x <= 0x0fffffff) { n += 4; x <<= 4; }
+    if (x <= 0x3fffffff) { n += 2; x <<= 2; }
+    if (x <= 0x7fffffff) { n += 1; }
+    return n;
+}
+
+// Knuth's algorithm D (TAOCP 4.3.1) on 32-bit digits. u has m digits,
+// v has n significant digits (v[n-1] != 0), m >= n, m <= 16. Writes
+// m - n + 1 quotient digits to q and n remainder digits to r
+static void knuthDivMod(const uint32_t *u, int m, const uint32_t *v, int n,
+                        uint32_t *q, uint32_t *r) {
+    const uint64_t b = 0x100000000ULL;
+    if (n == 1) {
+        uint64_t k = 0;
+        for (int j = m - 1; j >= 0; j--) {
+            uint64_t cur = k * b + u[j];
+            q[j] = (uint32_t)(cur / v[0]);
+            k = cur - (uint64_t)q[j] * v[0];
+        }
+        r[0] = (uint32_t)k;
+        return;
+    }
+    // Normalize so that the top digit of the divisor has its high bit set
+    int s = leadingZeroes(v[n - 1]);
+    uint32_t vn[16], un[17];
+    for (int i = n - 1; i > 0; i--)
+        vn[i] = (v[i] << s) | (uint32_t)((uint64_t)v[i - 1] >> (32 - s));
+    vn[0] = v[0] << s;
+    un[m] = (uint32_t)((uint64_t)u[m - 1] >> (32 - s));
+    for (int i = m - 1; i > 0; i--)
+        un[i] = (u[i] << s) | (uint32_t)((uint64_t)u[i - 1] >> (32 - s));
+    un[0] = u[0] << s;
+    for (int j = m - n; j >= 0; j--) {
+        // Estimate the quotient digit and correct it by at most two
+        uint64_t num = ((uint64_t)un[j + n] << 32) | un[j + n - 1];
+        uint64_t qhat = num / vn[n - 1];
+        uint64_t rhat = num - qhat * vn[n - 1];
+        while (qhat >= b || qhat * vn[n - 2] > ((rhat << 32) | un[j + n - 2])) {
+            qhat -= 1;
+            rhat += vn[n - 1];
+            if (rhat >= b) break;
+        }
+        // Multiply and subtract
+        int64_t k = 0, t;
+        for (int i = 0; i < n; i++) {
+            uint64_t p = qhat * vn[i];
+            t = (int64_t)un[i + j] - k - (int64_t)(p & 0xffffffff);
+            un[i + j] = (uint32_t)t;
+            k = (int64_t)(p >> 32) - (t >> 32);
+        }
+        t = (int64_t)un[j + n] - k;
+        un[j + n] = (uint32_t)t;
+        q[j] = (uint32_t)qhat;
+        // Estimate was one too high: add back
+        if (t < 0) {
+            q[j] -= 1;
+            uint64_t c = 0;
+            for (int i = 0; i < n; i++) {
+                uint64_t sum = (uint64_t)un[i + j] + vn[i] + c;
+                un[i + j] = (uint32_t)sum;
+                c = sum >> 32;
+            }
+            un[j + n] += (uint32_t)c;
+        }
+    }
+    for (int i = 0; i < n - 1; i++)
+        r[i] = (un[i] >> s) | (uint32_t)((uint64_t)un[i + 1] << (32 - s));
+    r[n - 1] = un[n - 1] >> s;
+}
+
+unsigned uint256::bitLength() const {
+    for (int i = 3; i >= 0; i--) {
+        if (limbs[i]) {
+            unsigned n = 64;
+            uint64_t x = limbs[i];
+            while (!(x >> 63)) { x <<= 1; n--; }
+            return i * 64 + n;
+        }
+    }
+    return 0;
+}
+
+bool operator==(const uint256 &a, const uint256 &b) {
+    return a.limbs[0] == b.limbs[0] && a.limbs[1] == b.limbs[1]
+        && a.limbs[2] == b.limbs[2] && a.limbs[3] == b.limbs[3];
+}
+
+bool operator!=(const uint256 &a, const uint256 &b) {
+    return !(a == b);
+}
+
+bool operator<(const uint256 &a, const uint256 &b) {
+    for (int i = 3; i >= 0; i--) {
+        if (a.limbs[i] != b.limbs[i]) return a.limbs[i] < b.limbs[i];
+    }
+    return false;
+}
+
+bool operator>(const uint256 &a, const uint256 &b) {
+    return b < a;
+}
+
+bool operator<=(const uint256 &a, const uint256 &b) {
+    return !(b < a);
+}
+
+bool operator>=(const uint256 &a, const uint256 &b) {
+    return !(a < b);
+}
+
+uint256 operator+(const uint256 &a, const uint256 &b) {
+    uint256 o;
+    uint64_t carry = 0;
+    for (unsigned i = 0; i < 4; i++) {
+        uint64_t s = a.limbs[i] + carry;
+        carry = s < carry;
+        o.limbs[i] = s + b.limbs[i];
+        carry += o.limbs[i] < s;
+    }
+    return o;
+}
+
+uint256 operator-(const uint256 &a, const uint256 &b) {
+    uint256 o;
+    uint64_t borrow = 0;
+    for (unsigned i = 0; i < 4; i++) {
+        uint64_t d = a.limbs[i] - b.limbs[i];
+        uint64_t nb = a.limbs[i] < b.limbs[i];
+        o.limbs[i] = d - borrow;
+        nb += d < borrow;
+        borrow = nb;
+    }
+    return o;
+}
+
+uint256 operator-(const uint256 &a) {
+    return uint256(0) - a;
+}
+
+uint256 operator*(const uint256 &a, const uint256 &b) {
+    uint256 o;
+    for (unsigned i = 0; i < 4; i++) {
+        uint64_t carry = 0;
+        for (unsigned j = 0; i + j < 4; j++) {
+            uint64_t hi, lo;
+            mul64(a.limbs[i], b.limbs[j], hi, lo);
+            lo += carry;
+            hi += lo < carry;
+            o.limbs[i + j] += lo;
+            hi += o.limbs[i + j] < lo;
+            carry = hi;
+        }
+    }
+    return o;
+}
+
+void u256DivMod(const uint256 &a, const uint256 &b, uint256 &q, uint256 &r) {
+    q = uint256(0);
+    r = uint256(0);
+    if (b.isZero()) return;
+    if (a < b) {
+        r = a;
+        return;
+    }
+    // Both fit in a machine word
+    if (!(a.limbs[1] | a.limbs[2] | a.limbs[3])) {
+        q.limbs[0] = a.limbs[0] / b.limbs[0];
+        r.limbs[0] = a.limbs[0] % b.limbs[0];
+        return;
+    }
+    uint32_t u[8], v[8], qd[8] = { 0 }, rd[8] = { 0 };
+    toDigits(a, u);
+    toDigits(b, v);
+    knuthDivMod(u, digitCount(u, 8), v, digitCount(v, 8), qd, rd);
+    q = fromDigits(qd);
+    r = fromDigits(rd);
+}
+
+uint256 operator/(const uint256 &a, const uint256 &b) {
+    uint256 q, r;
+    u256DivMod(a, b, q, r);
+    return q;
+}
+
+uint256 operator%(const uint256 &a, const uint256 &b) {
+    uint256 q, r;
+    u256DivMod(a, b, q, r);
+    return r;
+}
+
+uint256 operator&(const uint256 &a, const uint256 &b) {
+    uint256 o;
+    for (unsigned i = 0; i < 4; i++) o.limbs[i] = a.limbs[i] & b.limbs[i];
+    return o;
+}
+
+uint256 operator|(const uint256 &a, const uint256 &b) {
+    uint256 o;
+    for (unsigned i = 0; i < 4; i++) o.limbs[i] = a.limbs[i] | b.limbs[i];
+    return o;
+}
+
+uint256 operator^(const uint256 &a, const uint256 &b) {
+    uint256 o;
+    for (unsigned i = 0; i < 4; i++) o.limbs[i] = a.limbs[i] ^ b.limbs[i];
+    return o;
+}
+
+uint256 operator~(const uint256 &a) {
+    uint256 o;
+    for (unsigned i = 0; i < 4; i++) o.limbs[i] = ~a.limbs[i];
+    return o;
+}
+
+uint256 operator<<(const uint256 &a, unsigned shift) {
+    uint256 o;
+    if (shift >= 256) return o;
+    unsigned w = shift / 64, s = shift % 64;
+    for (int i = 3; i >= (int)w; i--) {
+        o.limbs[i] = a.limbs[i - w] << s;
+        if (s && i - (int)w - 1 >= 0)
+            o.limbs[i] |= a.limbs[i - w - 1] >> (64 - s);
+    }
+    return o;
+}
+
+uint256 operator>>(const uint256 &a, unsigned shift) {
+    uint256 o;
+    if (shift >= 256) return o;
+    unsigned w = shift / 64, s = shift % 64;
+    for (unsigned i = 0; i + w < 4; i++) {
+        o.limbs[i] = a.limbs[i + w] >> s;
+        if (s && i + w + 1 < 4)
+            o.limbs[i] |= a.limbs[i + w + 1] << (64 - s);
+    }
+    return o;
+}
+
+// Square-and-multiply, wrapping at 2^256
+uint256 u256Exp(uint256 b, uint256 e) {
+    uint256 o(1);
+    unsigned bits = e.bitLength();
+    for (unsigned i = 0; i < bits; i++) {
+        if ((e.limbs[i / 64] >> (i % 64)) & 1) o = o * b;
+        if (i + 1 < bits) b = b * b;
+    }
+    return o;
+}
+
+// Signed division, rounding towards zero
+uint256 u256SDiv(const uint256 &a, const uint256 &b) {
+    if (b.isZero()) return uint256(0);
+    uint256 q = (a.isNegative() ? -a : a) / (b.isNegative() ? -b : b);
+    return (a.isNegative() != b.isNegative()) ? -q : q;
+}
+
+// Signed modulo, result takes the sign of the dividend
+uint256 u256SMod(const uint256 &a, const uint256 &b) {
+    if (b.isZero()) return uint256(0);
+    uint256 r = (a.isNegative() ? -a : a) % (b.isNegative() ? -b : b);
+    return a.isNegative() ? -r : r;
+}
+
+// Reduces a 512-bit value, given as eight 64-bit limbs, modulo m != 0
+static uint256 reduce512(const uint64_t *p, const uint256 &m) {
+    uint32_t u[16], v[8], q[16], r[8] = { 0 };
+    for (unsigned i = 0; i < 8; i++) {
+        u[2 * i] = (uint32_t)p[i];
+        u[2 * i + 1] = (uint32_t)(p[i] >> 32);
+    }
+    toDigits(m, v);
+    int un = digitCount(u, 16), vn = digitCount(v, 8);
+    if (un < vn) {
+        for (int i = 0; i < un; i++) r[i] = u[i];
+    }
+    else knuthDivMod(u, un, v, vn, q, r);
+    return fromDigits(r);
+}
+
+// Full 512-bit product as eight 64-bit limbs
+static void mul512(const uint256 &a, const uint256 &b, uint64_t *p) {
+    for (unsigned i = 0; i < 8; i++) p[i] = 0;
+    for (unsigned i = 0; i < 4; i++) {
+        uint64_t carry = 0;
+        for (unsigned j = 0; j < 4; j++)
+            p[i + j] = macc(p[i + j], a.limbs[i], b.limbs[j], carry);
+        p[i + 4] = carry;
+    }
+}
+
+uint256 u256AddMod(const uint256 &a, const uint256 &b, const uint256 &m) {
+    if (m.isZero()) return uint256(0);
+    uint64_t p[8] = { 0 };
+    uint256 s = a + b;
+    for (unsigned i = 0; i < 4; i++) p[i] = s.limbs[i];
+    p[4] = s < a;
+    return reduce512(p, m);
+}
+
+// Montgomery contexts are cached per modulus, since math-heavy code tends
+// to reuse the same few (prime) moduli over and over. One cache per
+// thread, so that concurrent compilations need no locking
+thread_local std::map<std::vector<uint64_t>, montgomeryCtx> montgomeryCache;
+
+uint256 u256MulMod(const uint256 &a, const uint256 &b, const uint256 &m) {
+    if (m.isZero()) return uint256(0);
+    if (m.limbs[0] & 1) {
+        std::vector<uint64_t> key(m.limbs, m.limbs + 4);
+        std::map<std::vector<uint64_t>, montgomeryCtx>::iterator it =
+            montgomeryCache.find(key);
+        if (it == montgomeryCache.end())
+            it = montgomeryCache.insert(
+                std::make_pair(key, montgomeryCtx(m))).first;
+        return it->second.mulMod(a, b);
+    }
+    uint64_t p[8];
+    mul512(a, b, p);
+    return reduce512(p, m);
+}
+
+uint256 u256SignExtend(const uint256 &b, const uint256 &x) {
+    if (b >= uint256(31)) return x;
+    unsigned bit = 8 * b.limbs[0] + 7;
+    uint256 mask = (uint256(1) << (bit + 1)) - uint256(1);
+    if (((x >> bit).limbs[0] & 1)) return x | ~mask;
+    return x & mask;
+}
+
+uint256 u256ModExp(const uint256 &b, const uint256 &e, const uint256 &m) {
+    if (m.isZero() || m == uint256(1)) return uint256(0);
+    if (m.limbs[0] & 1) return montgomeryCtx(m).modExp(b, e);
+    uint256 o(1), base = b % m;
+    unsigned bits = e.bitLength();
+    for (unsigned i = 0; i < bits; i++) {
+        if ((e.limbs[i / 64] >> (i % 64)) & 1) o = u256MulMod(o, base, m);
+        if (i + 1 < bits) base = u256MulMod(base, base, m);
+    }
+    return o;
+}
+
+montgomeryCtx::montgomeryCtx(const uint256 &m) {
+    modulus = m;
+    // Newton iteration for m^-1 mod 2^64; each step doubles the number
+    // of correct bits, starting from 3 (any odd x is its own inverse
+    // mod 8)
+    uint64_t x = m.limbs[0];
+    for (unsigned i = 0; i < 5; i++) x *= 2 - m.limbs[0] * x;
+    inv = (uint64_t)0 - x;
+    r1 = (uint256(0) - m) % m;
+    uint64_t p[8];
+    mul512(r1, r1, p);
+    r2 = reduce512(p, m);
+}
+
+// Coarsely integrated operand scanning (Koc, Acar and Kaliski 1996)
+uint256 montgomeryCtx::mul(const uint256 &a, const uint256 &b) const {
+    uint64_t t[6] = { 0 };
+    for (unsigned i = 0; i < 4; i++) {
+        uint64_t c = 0;
+        for (unsigned j = 0; j < 4; j++)
+            t[j] = macc(t[j], a.limbs[j], b.limbs[i], c);
+        t[4] += c;
+        t[5] = t[4] < c;
+        uint64_t q = t[0] * inv;
+        c = 0;
+        macc(t[0], q, modulus.limbs[0], c);
+        for (unsigned j = 1; j < 4; j++)
+            t[j - 1] = macc(t[j], q, modulus.limbs[j], c);
+        t[3] = t[4] + c;
+        t[4] = t[5] + (t[3] < c);
+    }
+    uint256 o;
+    for (unsigned i = 0; i < 4; i++) o.limbs[i] = t[i];
+    if (t[4] || o >= modulus) o = o - modulus;
+    return o;
+}
+
+uint256 montgomeryCtx::toMont(const uint256 &a) const {
+    return mul(a < modulus ? a : a % modulus, r2);
+}
+
+uint256 montgomeryCtx::fromMont(const uint256 &a) const {
+    return mul(a, uint256(1));
+}
+
+// mul(a, b) = a*b/R, and multiplying by R^2 in a second step restores
+// a*b; only b has to be reduced first
+uint256 montgomeryCtx::mulMod(const uint256 &a, const uint256 &b) const {
+    return mul(mul(a, b < modulus ? b : b % modulus), r2);
+}
+
+uint256 montgomeryCtx::modExp(const uint256 &b, const uint256 &e) const {
+    uint256 o = r1, base = toMont(b);
+    unsigned bits = e.bitLength();
+    for (unsigned i = 0; i < bits; i++) {
+        if ((e.limbs[i / 64] >> (i % 64)) & 1) o = mul(o, base);
+        if (i + 1 < bits) base = mul(base, base);
+    }
+    return fromMont(o);
+}
+
+bool u256FromDecimal(const std::string &s, uint256 &out) {
+    if (!s.size()) return false;
+    uint32_t d[8] = { 0 };
+    unsigned pos = 0;
+    while (pos < s.size()) {
+        // Consume up to nine digits at a time
+        uint32_t chunk = 0, mul = 1;
+        for (unsigned k = 0; k < 9 && pos < s.size(); k++, pos++) {
+            if (s[pos] < '0' || s[pos] > '9') return false;
+            chunk = chunk * 10 + (s[pos] - '0');
+            mul *= 10;
+        }
+        uint64_t carry = chunk;
+        for (unsigned i = 0; i < 8; i++) {
+            uint64_t cur = (uint64_t)d[i] * mul + carry;
+            d[i] = (uint32_t)cur;
+            carry = cur >> 32;
+        }
+        if (carry) return false;
+    }
+    out = fromDigits(d);
+    return true;
+}
+
+std::string u256ToDecimal(const uint256 &v) {
+    if (v.isZero()) return "0";
+    uint32_t d[8];
+    toDigits(v, d);
+    int n = digitCount(d, 8);
+    std::string o;
+    // Peel off nine decimal digits at a time, least significant first
+    while (n > 0) {
+        uint64_t rem = 0;
+        for (int i = n - 1; i >= 0; i--) {
+            uint64_t cur = (rem << 32) | d[i];
+            d[i] = (uint32_t)(cur / 1000000000);
+            rem = cur % 1000000000;
+        }
+        n = digitCount(d, n);
+        for (unsigned k = 0; k < 9 && (n > 0 || rem > 0); k++) {
+            o += (char)('0' + rem % 10);
+            rem /= 10;
+        }
+    }
+    return std::string(o.rbegin(), o.rend());
+}
+
+uint256 u256FromBytes(const std::vector<uint8_t> &b) {
+    uint256 o;
+    unsigned start = b.size() > 32 ? b.size() - 32 : 0;
+    for (unsigned i = start; i < b.size(); i++) {
+        unsigned pos = b.size() - 1 - i;
+        o.limbs[pos / 8] |= (uint64_t)b[i] << (8 * (pos % 8));
+    }
+    return o;
+}
+
+std::vector<uint8_t> u256ToBytes(const uint256 &v, unsigned minLen) {
+    unsigned len = (v.bitLength() + 7) / 8;
+    if (len < minLen) len = minLen;
+    std::vector<uint8_t> o(len, 0);
+    for (unsigned pos = 0; pos < len && pos < 32; pos++)
+        o[len - 1 - pos] = (uint8_t)(v.limbs[pos / 8] >> (8 * (pos % 8)));
+    return o;
+}
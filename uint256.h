@@ -0,0 +1,105 @@
+#ifndef ETHSERP_UINT256
+#define ETHSERP_UINT256
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Fixed-width 256-bit unsigned integer, stored as four 64-bit limbs
+// (least significant first). All arithmetic wraps modulo 2^256, and
+// division and modulo by zero yield zero, exactly as in the EVM
+class uint256 {
+    public:
+        uint256(uint64_t v=0) {
+            limbs[0] = v;
+            limbs[1] = 0;
+            limbs[2] = 0;
+            limbs[3] = 0;
+        }
+        uint64_t limbs[4];
+        bool isZero() const {
+            return !(limbs[0] | limbs[1] | limbs[2] | limbs[3]);
+        }
+        // Sign bit when interpreted as a two's complement value
+        bool isNegative() const {
+            return (limbs[3] >> 63) != 0;
+        }
+        // Number of significant bits (0 for zero)
+        unsigned bitLength() const;
+};
+
+bool operator==(const uint256 &a, const uint256 &b);
+bool operator!=(const uint256 &a, const uint256 &b);
+bool operator<(const uint256 &a, const uint256 &b);
+bool operator>(const uint256 &a, const uint256 &b);
+bool operator<=(const uint256 &a, const uint256 &b);
+bool operator>=(const uint256 &a, const uint256 &b);
+
+uint256 operator+(const uint256 &a, const uint256 &b);
+uint256 operator-(const uint256 &a, const uint256 &b);
+uint256 operator-(const uint256 &a);
+uint256 operator*(const uint256 &a, const uint256 &b);
+uint256 operator/(const uint256 &a, const uint256 &b);
+uint256 operator%(const uint256 &a, const uint256 &b);
+uint256 operator&(const uint256 &a, const uint256 &b);
+uint256 operator|(const uint256 &a, const uint256 &b);
+uint256 operator^(const uint256 &a, const uint256 &b);
+uint256 operator~(const uint256 &a);
+uint256 operator<<(const uint256 &a, unsigned shift);
+uint256 operator>>(const uint256 &a, unsigned shift);
+
+// Quotient and remainder in one pass (both zero if b is zero)
+void u256DivMod(const uint256 &a, const uint256 &b, uint256 &q, uint256 &r);
+
+// EVM EXP
+uint256 u256Exp(uint256 b, uint256 e);
+
+// EVM SDIV and SMOD
+uint256 u256SDiv(const uint256 &a, const uint256 &b);
+uint256 u256SMod(const uint256 &a, const uint256 &b);
+
+// EVM ADDMOD and MULMOD, computed without intermediate overflow
+uint256 u256AddMod(const uint256 &a, const uint256 &b, const uint256 &m);
+uint256 u256MulMod(const uint256 &a, const uint256 &b, const uint256 &m);
+
+// EVM SIGNEXTEND: extends the sign bit of byte b (counting from the
+// least significant) of x
+uint256 u256SignExtend(const uint256 &b, const uint256 &x);
+
+// (b ** e) % m, without wrapping at 2^256
+uint256 u256ModExp(const uint256 &b, const uint256 &e, const uint256 &m);
+
+// Montgomery multiplication modulo a fixed odd modulus. Values in
+// Montgomery form are a*R mod m, with R = 2^256
+class montgomeryCtx {
+    public:
+        montgomeryCtx(const uint256 &m);
+        uint256 modulus;
+        // -m^-1 mod 2^64
+        uint64_t inv;
+        // R mod m and R^2 mod m
+        uint256 r1;
+        uint256 r2;
+        // a*b/R mod m; requires a*b < m*R, eg. b < m
+        uint256 mul(const uint256 &a, const uint256 &b) const;
+        uint256 toMont(const uint256 &a) const;
+        uint256 fromMont(const uint256 &a) const;
+        // (a * b) % m for arbitrary 256-bit a, b
+        uint256 mulMod(const uint256 &a, const uint256 &b) const;
+        // (b ** e) % m
+        uint256 modExp(const uint256 &b, const uint256 &e) const;
+};
+
+// Parses a string of decimal digits; fails on anything else or on
+// values of 2^256 and above
+bool u256FromDecimal(const std::string &s, uint256 &out);
+
+std::string u256ToDecimal(const uint256 &v);
+
+// Big-endian value of up to 32 bytes
+uint256 u256FromBytes(const std::vector<uint8_t> &b);
+
+// Big-endian bytes without leading zeroes, padded to at least minLen
+std::vector<uint8_t> u256ToBytes(const uint256 &v, unsigned minLen=1);
+
+#endif
@@ -4,11 +4,31 @@
 #include <map>
 #include "util.h"
 #include "bignum.h"
+#include "uint256.h"
 #include <fstream>
 #include <cerrno>
+#include <thread>
+
+// Deeply nested trees (eg. from parseLLL) would overflow the stack if
+// each list freed its children recursively, so unreferenced child blocks
+// are collected into a worklist instead
+void NodeList::destroy(Block *b) {
+    std::vector<Block *> work(1, b);
+    while (work.size()) {
+        Block *cur = work.back();
+        work.pop_back();
+        for (unsigned i = 0; i < cur->items.size(); i++) {
+            Block *c = cur->items[i].args.block;
+            cur->items[i].args.block = 0;
+            if (c && c->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                work.push_back(c);
+        }
+        delete cur;
+    }
+}
 
 //Token or value node constructor
-Node token(std::string val, Metadata met) {
+Node token(Symbol val, Metadata met) {
     Node o;
     o.type = 0;
     o.val = val;
@@ -17,7 +37,7 @@ Node token(std::string val, Metadata met) {
 }
 
 //AST node constructor
-Node astnode(std::string val, std::vector<Node> args, Metadata met) {
+Node astnode(Symbol val, std::vector<Node> args, Metadata met) {
     Node o;
     o.type = 1;
     o.val = val;
@@ -27,25 +47,25 @@ Node astnode(std::string val, std::vector<Node> args, Metadata met) {
 }
 
 //AST node constructors for a specific number of children
-Node astnode(std::string val, Metadata met) {
+Node astnode(Symbol val, Metadata met) {
     std::vector<Node> args;
     return astnode(val, args, met);
 }
 
-Node astnode(std::string val, Node a, Metadata met) {
+Node astnode(Symbol val, Node a, Metadata met) {
     std::vector<Node> args;
     args.push_back(a);
     return astnode(val, args, met);
 }
 
-Node astnode(std::string val, Node a, Node b, Metadata met) {
+Node astnode(Symbol val, Node a, Node b, Metadata met) {
     std::vector<Node> args;
     args.push_back(a);
     args.push_back(b);
     return astnode(val, args, met);
 }
 
-Node astnode(std::string val, Node a, Node b, Node c, Metadata met) {
+Node astnode(Symbol val, Node a, Node b, Node c, Metadata met) {
     std::vector<Node> args;
     args.push_back(a);
     args.push_back(b);
@@ -53,7 +73,7 @@ Node astnode(std::string val, Node a, Node b, Node c, Metadata met) {
     return astnode(val, args, met);
 }
 
-Node astnode(std::string val, Node a, Node b, Node c, Node d, Metadata met) {
+Node astnode(Symbol val, Node a, Node b, Node c, Node d, Metadata met) {
     std::vector<Node> args;
     args.push_back(a);
     args.push_back(b);
@@ -63,6 +83,37 @@ Node astnode(std::string val, Node a, Node b, Node c, Node d, Metadata met) {
 }
 
 
+// Same, interning the name first
+Node token(const std::string &val, Metadata met) {
+    return token(Symbol(val), met);
+}
+
+Node astnode(const std::string &val, std::vector<Node> args, Metadata met) {
+    return astnode(Symbol(val), args, met);
+}
+
+Node astnode(const std::string &val, Metadata met) {
+    return astnode(Symbol(val), met);
+}
+
+Node astnode(const std::string &val, Node a, Metadata met) {
+    return astnode(Symbol(val), a, met);
+}
+
+Node astnode(const std::string &val, Node a, Node b, Metadata met) {
+    return astnode(Symbol(val), a, b, met);
+}
+
+Node astnode(const std::string &val, Node a, Node b, Node c, Metadata met) {
+    return astnode(Symbol(val), a, b, c, met);
+}
+
+Node astnode(const std::string &val, Node a, Node b, Node c, Node d,
+             Metadata met) {
+    return astnode(Symbol(val), a, b, c, d, met);
+}
+
+
 // Print token list
 std::string printTokens(std::vector<Node> tokens) {
     std::string s = "";
@@ -84,7 +135,7 @@ std::string printSimple(Node ast) {
 }
 
 // Number of tokens in a tree
-int treeSize(Node prog) {
+int treeSize(const Node &prog) {
     if (prog.type == TOKEN) return 1;
     int o = 0;
 	for (unsigned i = 0; i < prog.args.size(); i++) o += treeSize(prog.args[i]);
@@ -162,11 +213,7 @@ std::string indentLines(std::string inp) {
 
 // Binary to hexadecimal
 std::string binToNumeric(std::string inp) {
-    std::string o = "0";
-	for (unsigned i = 0; i < inp.length(); i++) {
-        o = decimalAdd(decimalMul(o,"256"), unsignedToDecimal((unsigned char)inp[i]));
-    }
-    return o;
+    return bytesToDecimal(std::vector<uint8_t>(inp.begin(), inp.end()));
 }
 
 std::string hexalpha = "0123456789abcdef";
@@ -211,16 +258,22 @@ std::string strToNumeric(std::string inp, int strpad=32) {
     }
     else if ((inp[0] == '"' && inp[inp.length()-1] == '"')
             || (inp[0] == '\'' && inp[inp.length()-1] == '\'')) {
-            std::vector<uint8_t> bytes = strToBytes(inp.substr(1, inp.size() - 2));
-            for (unsigned i = 0; i < bytes.size(); i++) {
-                o = decimalAdd(decimalMul(o,"256"), unsignedToDecimal(bytes[i]));
-            }
+        std::vector<uint8_t> bytes = strToBytes(inp.substr(1, inp.size() - 2));
         int pad = strpad - bytes.size();
         if (pad < 0) return "";
-        return decimalMul(o, decimalExp("256", unsignedToDecimal(pad)));
+        return u256ToDecimal(u256FromBytes(bytes) << (8 * pad));
     }
     else if (inp.substr(0,2) == "0x") {
-		for (unsigned i = 2; i < inp.length(); i++) {
+        // Accumulate natively for as long as the value fits in 256 bits
+        uint256 v;
+        unsigned i = 2;
+		for (; i < inp.length() && !(v.limbs[3] >> 60); i++) {
+            int dig = std::string("0123456789abcdef0123456789ABCDEF").find(inp[i]) % 16;
+            if (dig < 0) return "";
+            v = (v << 4) | uint256(dig);
+        }
+        o = u256ToDecimal(v);
+		for (; i < inp.length(); i++) {
             int dig = std::string("0123456789abcdef0123456789ABCDEF").find(inp[i]) % 16;
             if (dig < 0) return "";
             o = decimalAdd(decimalMul(o,"16"), unsignedToDecimal(dig));
@@ -264,6 +317,13 @@ Node tryNumberize(Node node) {
 //Converts a value to an array of byte number nodes
 std::vector<Node> toByteArr(std::string val, Metadata metadata, int minLen) {
     std::vector<Node> o;
+    uint256 v;
+    if (u256FromDecimal(val, v)) {
+        std::vector<uint8_t> bytes = u256ToBytes(v, minLen);
+        for (unsigned i = 0; i < bytes.size(); i++)
+            o.push_back(token(unsignedToDecimal(bytes[i]), metadata));
+        return o;
+    }
     int L = 0;
     while (val != "0" || L < minLen) {
         o.push_back(token(decimalMod(val, "256"), metadata));
@@ -277,6 +337,7 @@ std::vector<Node> toByteArr(std::string val, Metadata metadata, int minLen) {
 
 //Converts a byte array into a value
 std::string bytesToDecimal(std::vector<uint8_t> b) {
+    if (b.size() <= 32) return u256ToDecimal(u256FromBytes(b));
     std::string o = "0";
     for (int i = 0; i < b.size(); i++) {
         o = decimalAdd(decimalMul(o, "256"), unsignedToDecimal(b[i]));
@@ -284,12 +345,43 @@ std::string bytesToDecimal(std::vector<uint8_t> b) {
     return o;
 }
 
-int counter = 0;
+// Used when nothing has opened a compilation, eg. when calling into the
+// rewriter directly
+thread_local CompilerContext defaultContext;
+thread_local CompilerContext *activeContext = 0;
+
+CompilerContext &compilerContext() {
+    return activeContext ? *activeContext : defaultContext;
+}
+
+compilationScope::compilationScope() {
+    outer = activeContext;
+    if (!outer) activeContext = &context;
+}
+
+compilationScope::~compilationScope() {
+    if (!outer) activeContext = 0;
+}
+
+uniqueTokenScope::uniqueTokenScope(const std::string &prefix) {
+    CompilerContext &c = compilerContext();
+    outerCounter = c.counter;
+    outerPrefix = c.prefix;
+    c.counter = 0;
+    c.prefix = prefix;
+}
+
+uniqueTokenScope::~uniqueTokenScope() {
+    CompilerContext &c = compilerContext();
+    c.counter = outerCounter;
+    c.prefix = outerPrefix;
+}
 
 //Makes a unique token
 std::string mkUniqueToken() {
-    counter++;
-    return unsignedToDecimal(counter);
+    CompilerContext &c = compilerContext();
+    c.counter++;
+    return c.prefix + unsignedToDecimal(c.counter);
 }
 
 //Does a file exist? http://stackoverflow.com/questions/12774207
@@ -315,12 +407,55 @@ std::string get_file_contents(std::string filename)
   throw(errno);
 }
 
+thread_local bool muteDiagnostics = false;
+thread_local std::string *diagnosticsSink = 0;
+
+void reportDiagnostic(const std::string &msg) {
+    if (muteDiagnostics) return;
+    if (diagnosticsSink) *diagnosticsSink += msg + "\n";
+    else std::cerr << msg << "\n";
+}
+
+void jobOutcome::replay() const {
+    std::vector<std::string> lines = splitLines(diagnostics);
+    for (unsigned i = 0; i < lines.size(); i++) {
+        if (lines[i].size()) reportDiagnostic(lines[i]);
+    }
+    if (error) std::rethrow_exception(error);
+}
+
+std::vector<jobOutcome> runJobs(unsigned n, int threads,
+                                const std::function<void(unsigned)> &job) {
+    std::vector<jobOutcome> outcomes(n);
+    if (threads > (int)n) threads = n;
+    std::atomic<unsigned> next(0);
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; t++) {
+        pool.push_back(std::thread([&]() {
+            unsigned i;
+            while ((i = next++) < n) {
+                compilationScope scope;
+                diagnosticsSink = &outcomes[i].diagnostics;
+                try {
+                    job(i);
+                }
+                catch (...) {
+                    outcomes[i].error = std::current_exception();
+                }
+                diagnosticsSink = 0;
+            }
+        }));
+    }
+    for (unsigned t = 0; t < pool.size(); t++) pool[t].join();
+    return outcomes;
+}
+
 //Report error
 void err(std::string errtext, Metadata met) {
     std::string err = "Error (file \"" + met.file + "\", line " +
         unsignedToDecimal(met.ln + 1) + ", char " + unsignedToDecimal(met.ch) +
         "): " + errtext;
-    std::cerr << err << "\n";
+    reportDiagnostic(err);
     throw(err);
 }
 
@@ -329,7 +464,7 @@ void warn(std::string errtext, Metadata met) {
     std::string err = "Warning (file \"" + met.file + "\", line " +
         unsignedToDecimal(met.ln + 1) + ", char " + unsignedToDecimal(met.ch) +
         "): " + errtext;
-    std::cerr << err << "\n";
+    reportDiagnostic(err);
 }
 
 //Bin to hex
@@ -364,6 +499,16 @@ std::string upperCase(std::string inp) {
     return o;
 }
 
+//Upper to lower
+std::string lowerCase(std::string inp) {
+    std::string o = "";
+	for (unsigned i = 0; i < inp.length(); i++) {
+        if (inp[i] >= 65 && inp[i] <= 90) o += inp[i] + 32;
+        else o += inp[i];
+    }
+    return o;
+}
+
 //Three-int vector
 std::vector<int> triple(int a, int b, int c) {
     std::vector<int> v;
@@ -392,3 +537,125 @@ std::vector<Node> extend(std::vector<Node> a, std::vector<Node> b) {
     for (unsigned i = 0; i < b.size(); i++) a.push_back(b[i]);
     return a;
 }
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+bool heapCounted = false;
+std::atomic<bool> heapCounting(false);
+std::atomic<long long> heapInUse(0);
+std::atomic<long long> heapPeak(0);
+std::atomic<long long> heapAllocations(0);
+
+thread_local passTimings *activeTimings = 0;
+thread_local int phaseDepth = 0;
+
+passTimingScope::passTimingScope(passTimings *timings) {
+    outer = activeTimings;
+    outerCounting = heapCounting;
+    activeTimings = timings;
+    if (timings && heapCounted) heapCounting = true;
+}
+
+passTimingScope::~passTimingScope() {
+    activeTimings = outer;
+    heapCounting = outerCounting;
+}
+
+phaseScope::phaseScope(const char *name) {
+    timings = activeTimings;
+    if (timings) begin(name, -1);
+}
+
+phaseScope::phaseScope(const char *name, const Node &in) {
+    timings = activeTimings;
+    if (timings) begin(name, treeSize(in));
+}
+
+phaseScope::phaseScope(const char *name, const std::vector<Node> &in) {
+    timings = activeTimings;
+    if (timings) begin(name, in.size());
+}
+
+void phaseScope::begin(const char *name, long long nodesIn) {
+    phaseRecord r;
+    r.name = name;
+    r.depth = phaseDepth++;
+    r.seconds = 0;
+    r.nodesIn = nodesIn;
+    r.nodesOut = -1;
+    r.peakBytes = -1;
+    r.allocations = -1;
+    index = timings->phases.size();
+    timings->phases.push_back(r);
+    // The peak is restarted for this phase, and put back afterwards so
+    // that the phase still counts towards the one it is part of
+    startInUse = heapInUse;
+    startAllocations = heapAllocations;
+    outerPeak = heapPeak.exchange(startInUse);
+    start = std::chrono::steady_clock::now();
+    timings->phases[index].start = std::chrono::duration<double>(
+        start - timings->origin).count();
+}
+
+phaseScope::~phaseScope() {
+    if (!timings) return;
+    phaseRecord &r = timings->phases[index];
+    r.seconds = secondsSince(start);
+    long long peak = heapPeak;
+    if (heapCounting) {
+        r.peakBytes = peak - startInUse;
+        r.allocations = heapAllocations - startAllocations;
+    }
+    if (outerPeak > peak) heapPeak = outerPeak;
+    phaseDepth--;
+}
+
+void phaseScope::out(const Node &n) {
+    if (timings) timings->phases[index].nodesOut = treeSize(n);
+}
+
+void phaseScope::out(const std::vector<Node> &v) {
+    if (timings) timings->phases[index].nodesOut = v.size();
+}
+
+std::string countOrDash(long long n) {
+    return n < 0 ? "-" : unsignedToDecimal(n);
+}
+
+std::string passTimings::report() const {
+    std::string o = "     wall ms    nodes in   nodes out  peak bytes"
+                    "      allocs  phase\n";
+    char buf[256];
+    for (unsigned i = 0; i < phases.size(); i++) {
+        const phaseRecord &r = phases[i];
+        sprintf(buf, "%12.3f %11s %11s %11s %11s  ", r.seconds * 1000,
+                countOrDash(r.nodesIn).c_str(),
+                countOrDash(r.nodesOut).c_str(),
+                countOrDash(r.peakBytes).c_str(),
+                countOrDash(r.allocations).c_str());
+        o += buf + std::string(r.depth * 2, ' ') + r.name + "\n";
+    }
+    if (!heapCounted)
+        o += "(the heap is not counted, as memcount.cpp is not linked in)\n";
+    return o;
+}
+
+std::string passTimings::chromeTrace() const {
+    std::string o = "{\"traceEvents\": [\n";
+    char buf[256];
+    for (unsigned i = 0; i < phases.size(); i++) {
+        const phaseRecord &r = phases[i];
+        // Complete events, in microseconds
+        sprintf(buf, "{\"name\": \"%s\", \"ph\": \"X\", \"pid\": 1, "
+                "\"tid\": 1, \"ts\": %.3f, \"dur\": %.3f, \"args\": "
+                "{\"nodesIn\": %lld, \"nodesOut\": %lld, "
+                "\"peakBytes\": %lld, \"allocations\": %lld}}",
+                r.name.c_str(), r.start * 1e6, r.seconds * 1e6, r.nodesIn,
+                r.nodesOut, r.peakBytes, r.allocations);
+        o += std::string(i ? ",\n" : "") + buf;
+    }
+    return o + "\n], \"displayTimeUnit\": \"ms\"}\n";
+}
@@ -8,6 +8,12 @@
 #include <fstream>
 #include <cerrno>
 #include <stdint.h>
+#include <atomic>
+#include <utility>
+#include <functional>
+#include <exception>
+#include <chrono>
+#include "symbol.h"
 
 const int TOKEN = 0,
           ASTNODE = 1,
@@ -30,42 +36,290 @@ const int STATIC = 16,
           ARRAY = 17,
           BYTES = 18;
 
-// Stores metadata about each token
+// File name used for code that does not come from a file
+inline Symbol mainFile() {
+    static const Symbol main("main");
+    return main;
+}
+
+// Stores metadata about each token. File names are interned, so
+// metadata is cheap to copy around with every node
 class Metadata {
     public:
-        Metadata(std::string File="main", int Ln=-1, int Ch=-1) {
+        Metadata(Symbol File=mainFile(), int Ln=-1, int Ch=-1) {
             file = File;
             ln = Ln;
             ch = Ch;
             fixed = false;
         }
-        std::string file;
+        Metadata(const std::string &File, int Ln=-1, int Ch=-1) {
+            file = File;
+            ln = Ln;
+            ch = Ch;
+            fixed = false;
+        }
+        Symbol file;
         int ln;
         int ch;
         bool fixed;
 };
 
+// Mutable state of one compilation. Each thread has its own current
+// context, so compilations running on separate threads share nothing
+// but the immutable rule and opcode tables
+class CompilerContext {
+    public:
+        CompilerContext() {
+            counter = 0;
+        }
+        // Last number handed out by mkUniqueToken
+        unsigned counter;
+        // Put in front of the number, to keep separately compiled parts
+        // of a program apart (see uniqueTokenScope)
+        std::string prefix;
+};
+
+// Context of the compilation running on this thread
+CompilerContext &compilerContext();
+
+// Makes a fresh context current for as long as it lives, unless the
+// thread is already inside a compilation, which then carries on. Entry
+// points (compile, rewrite, compileLLL and friends) open one, so that
+// temporary names and hence the output of a compilation do not depend on
+// what was compiled before it or alongside it
+class compilationScope {
+    public:
+        compilationScope();
+        ~compilationScope();
+    private:
+        CompilerContext *outer;
+        CompilerContext context;
+};
+
+// Gives the tokens made while it lives a namespace of their own,
+// numbered from 1 again, so that a part of a program compiled on its own
+// comes out the same whatever was compiled before it
+class uniqueTokenScope {
+    public:
+        uniqueTokenScope(const std::string &prefix);
+        ~uniqueTokenScope();
+    private:
+        unsigned outerCounter;
+        std::string outerPrefix;
+};
+
+// Makes a token unique within the current compilation
 std::string mkUniqueToken();
 
+class Node;
+
+// Children of a node. The list lives in a reference-counted block that
+// is shared between copies and only cloned (one level deep) when a
+// shared list is about to be modified, so copying a Node is O(1) no
+// matter how big its subtree is. Reads go through the const overloads
+// or the conversion to const std::vector<Node>&
+class NodeList {
+    public:
+        NodeList() {
+            block = 0;
+        }
+        NodeList(const std::vector<Node> &v);
+        NodeList(const NodeList &o);
+        NodeList(NodeList &&o) {
+            block = o.block;
+            o.block = 0;
+        }
+        ~NodeList();
+        NodeList &operator=(const NodeList &o);
+        NodeList &operator=(NodeList &&o) {
+            std::swap(block, o.block);
+            return *this;
+        }
+        NodeList &operator=(const std::vector<Node> &v);
+        size_t size() const;
+        bool empty() const {
+            return size() == 0;
+        }
+        const Node &operator[](size_t i) const;
+        Node &operator[](size_t i);
+        const Node &back() const;
+        Node &back();
+        void push_back(const Node &n);
+        void pop_back();
+        const std::vector<Node> &vec() const;
+        operator const std::vector<Node> &() const {
+            return vec();
+        }
+        // Nonzero if every node in the list is known to be a fixpoint of
+        // the rewrite pass identified by the tag (see apply_rules). Any
+        // write access to the list clears it. The stamp also records how
+        // many nodes lie under the list, which is what skipping it saves
+        uint32_t normalTag() const;
+        uint32_t normalNodes() const;
+        void setNormalTag(uint32_t tag, uint32_t nodes) const;
+    private:
+        struct Block;
+        Block *block;
+        // Makes the block exclusively ours (allocating it if needed)
+        void detach();
+        void release();
+        // Frees a block whose last reference is gone, along with any child
+        // blocks that only it referenced, without recursing
+        static void destroy(Block *b);
+};
+
 // type can be TOKEN or ASTNODE
 class Node {
     public:
         int type;
-        std::string val;
-        std::vector<Node> args;
+        Symbol val;
+        NodeList args;
         Metadata metadata;
 };
-Node token(std::string val, Metadata met=Metadata());
-Node astnode(std::string val, std::vector<Node> args, Metadata met=Metadata());
-Node astnode(std::string val, Metadata met=Metadata());
-Node astnode(std::string val, Node a, Metadata met=Metadata());
-Node astnode(std::string val, Node a, Node b, Metadata met=Metadata());
-Node astnode(std::string val, Node a, Node b, Node c, Metadata met=Metadata());
-Node astnode(std::string val, Node a, Node b,
+
+struct NodeList::Block {
+    std::atomic<int> refs;
+    std::atomic<uint32_t> tag;
+    std::atomic<uint32_t> nodes;
+    std::vector<Node> items;
+};
+
+inline const std::vector<Node> &noNodes() {
+    static const std::vector<Node> empty;
+    return empty;
+}
+
+inline NodeList::NodeList(const std::vector<Node> &v) {
+    block = 0;
+    if (v.size()) {
+        block = new Block();
+        block->refs = 1;
+        block->tag = 0;
+        block->nodes = 0;
+        block->items = v;
+    }
+}
+
+inline NodeList::NodeList(const NodeList &o) {
+    block = o.block;
+    if (block) block->refs.fetch_add(1, std::memory_order_relaxed);
+}
+
+inline void NodeList::release() {
+    if (block && block->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        destroy(block);
+    block = 0;
+}
+
+inline NodeList::~NodeList() {
+    release();
+}
+
+inline NodeList &NodeList::operator=(const NodeList &o) {
+    if (o.block) o.block->refs.fetch_add(1, std::memory_order_relaxed);
+    release();
+    block = o.block;
+    return *this;
+}
+
+inline NodeList &NodeList::operator=(const std::vector<Node> &v) {
+    NodeList o(v);
+    return *this = o;
+}
+
+inline void NodeList::detach() {
+    if (!block) {
+        block = new Block();
+        block->refs = 1;
+        block->tag = 0;
+        block->nodes = 0;
+    }
+    else if (block->refs.load(std::memory_order_acquire) != 1) {
+        Block *b = new Block();
+        b->refs = 1;
+        b->tag = 0;
+        b->nodes = 0;
+        b->items = block->items;
+        release();
+        block = b;
+    }
+    else block->tag.store(0, std::memory_order_relaxed);
+}
+
+inline size_t NodeList::size() const {
+    return block ? block->items.size() : 0;
+}
+
+inline const Node &NodeList::operator[](size_t i) const {
+    return block->items[i];
+}
+
+inline Node &NodeList::operator[](size_t i) {
+    detach();
+    return block->items[i];
+}
+
+inline const Node &NodeList::back() const {
+    return block->items.back();
+}
+
+inline Node &NodeList::back() {
+    detach();
+    return block->items.back();
+}
+
+inline void NodeList::push_back(const Node &n) {
+    // n may live inside our own block
+    Node copy = n;
+    detach();
+    block->items.push_back(copy);
+}
+
+inline void NodeList::pop_back() {
+    detach();
+    block->items.pop_back();
+}
+
+inline const std::vector<Node> &NodeList::vec() const {
+    return block ? block->items : noNodes();
+}
+
+inline uint32_t NodeList::normalTag() const {
+    return block ? block->tag.load(std::memory_order_relaxed) : 0;
+}
+
+inline uint32_t NodeList::normalNodes() const {
+    return block ? block->nodes.load(std::memory_order_relaxed) : 0;
+}
+
+inline void NodeList::setNormalTag(uint32_t tag, uint32_t nodes) const {
+    if (block) {
+        block->nodes.store(nodes, std::memory_order_relaxed);
+        block->tag.store(tag, std::memory_order_relaxed);
+    }
+}
+
+Node token(Symbol val, Metadata met=Metadata());
+Node token(const std::string &val, Metadata met=Metadata());
+Node astnode(Symbol val, std::vector<Node> args, Metadata met=Metadata());
+Node astnode(Symbol val, Metadata met=Metadata());
+Node astnode(Symbol val, Node a, Metadata met=Metadata());
+Node astnode(Symbol val, Node a, Node b, Metadata met=Metadata());
+Node astnode(Symbol val, Node a, Node b, Node c, Metadata met=Metadata());
+Node astnode(Symbol val, Node a, Node b,
+             Node c, Node d, Metadata met=Metadata());
+Node astnode(const std::string &val, std::vector<Node> args,
+             Metadata met=Metadata());
+Node astnode(const std::string &val, Metadata met=Metadata());
+Node astnode(const std::string &val, Node a, Metadata met=Metadata());
+Node astnode(const std::string &val, Node a, Node b, Metadata met=Metadata());
+Node astnode(const std::string &val, Node a, Node b, Node c,
+             Metadata met=Metadata());
+Node astnode(const std::string &val, Node a, Node b,
              Node c, Node d, Metadata met=Metadata());
 
 // Number of tokens in a tree
-int treeSize(Node prog);
+int treeSize(const Node &prog);
 
 // Print token list
 std::string printTokens(std::vector<Node> tokens);
@@ -118,6 +372,113 @@ void err(std::string errtext, Metadata met);
 //Report warning
 void warn(std::string errtext, Metadata met);
 
+// Set on threads doing speculative work whose errors and warnings, if
+// they matter, will be reported again by the thread that owns the
+// compilation; err still throws but nothing is printed
+extern thread_local bool muteDiagnostics;
+
+// When set, errors and warnings raised on this thread are appended here
+// (one per line) instead of being printed
+extern thread_local std::string *diagnosticsSink;
+
+// Prints an error or warning, or appends it to the sink
+void reportDiagnostic(const std::string &msg);
+
+// What a job run on another thread reported and the exception it failed
+// with, if any, kept so that they can be passed on in a fixed order
+class jobOutcome {
+    public:
+        std::string diagnostics;
+        std::exception_ptr error;
+        // Reports the diagnostics as if raised on this thread, then
+        // rethrows the error
+        void replay() const;
+};
+
+// Runs job(0) ... job(n - 1) on up to the given number of threads, each
+// job in a compilation of its own, and returns what each one reported
+std::vector<jobOutcome> runJobs(unsigned n, int threads,
+                                const std::function<void(unsigned)> &job);
+
+// Wall time since a point, in seconds
+double secondsSince(std::chrono::steady_clock::time_point start);
+
+// Heap accounting. Programs that want it link in memcount.cpp, which
+// replaces operator new and delete and counts the bytes allocated
+// while heapCounting is on. The counts are for the whole process.
+// Without it heapCounted is false and no heap counts are reported
+extern bool heapCounted;
+extern std::atomic<bool> heapCounting;
+extern std::atomic<long long> heapInUse;
+extern std::atomic<long long> heapPeak;
+extern std::atomic<long long> heapAllocations;
+
+// One phase of a compilation, as timed by a phaseScope
+class phaseRecord {
+    public:
+        std::string name;
+        // Number of phases it ran inside of
+        int depth;
+        // Seconds from the start of the timings, and taken
+        double start;
+        double seconds;
+        // Size (treeSize, or number of tokens) of what the phase took in
+        // and what it made, or -1 if it was not a tree
+        long long nodesIn;
+        long long nodesOut;
+        // Most heap in use at once during the phase, above what was in
+        // use when it started, and the number of allocations it made
+        // (-1 if the heap is not counted)
+        long long peakBytes;
+        long long allocations;
+};
+
+// The phases a thread ran while a passTimingScope was open, in the order
+// they started (serpent --time-passes)
+class passTimings {
+    public:
+        passTimings() {
+            origin = std::chrono::steady_clock::now();
+        }
+        std::chrono::steady_clock::time_point origin;
+        std::vector<phaseRecord> phases;
+        // A table of the phases, nested ones indented
+        std::string report() const;
+        // Chrome trace-event JSON, for chrome://tracing or Perfetto
+        std::string chromeTrace() const;
+};
+
+// Records the phases this thread runs into the timings for as long as
+// it lives (nothing if they are null)
+class passTimingScope {
+    public:
+        passTimingScope(passTimings *timings);
+        ~passTimingScope();
+    private:
+        passTimings *outer;
+        bool outerCounting;
+};
+
+// Times a phase from its construction to its destruction, if timings
+// are being recorded on this thread; otherwise it costs next to nothing
+class phaseScope {
+    public:
+        phaseScope(const char *name);
+        phaseScope(const char *name, const Node &in);
+        phaseScope(const char *name, const std::vector<Node> &in);
+        ~phaseScope();
+        void out(const Node &n);
+        void out(const std::vector<Node> &v);
+    private:
+        void begin(const char *name, long long nodesIn);
+        passTimings *timings;
+        unsigned index;
+        long long startInUse;
+        long long startAllocations;
+        long long outerPeak;
+        std::chrono::steady_clock::time_point start;
+};
+
 //Bin to hex
 std::string binToHex(std::string inp);
 
@@ -127,6 +488,9 @@ std::string hexToBin(std::string inp);
 //Lower to upper
 std::string upperCase(std::string inp);
 
+//Upper to lower
+std::string lowerCase(std::string inp);
+
 //Three-int vector
 std::vector<int> triple(int a, int b, int c);
 